@@ -11,28 +11,44 @@
 #define FREERTOS_CONFIG_H
 
 #include <stdint.h>
+#include "blfm_config.h"
 
 #define configUSE_PREEMPTION                    1
 #define configUSE_IDLE_HOOK                     0
 #define configUSE_TICK_HOOK                     0
 #define configCPU_CLOCK_HZ                      ((uint32_t)72000000)
 #define configTICK_RATE_HZ                      ((TickType_t)1000)
-#define configMAX_PRIORITIES                    5
+#define configMAX_PRIORITIES                    10
 #define configMINIMAL_STACK_SIZE                ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                   ((size_t)(16 * 1024))
+#define configTOTAL_HEAP_SIZE                   ((size_t)(12 * 1024))
 #define configMAX_TASK_NAME_LEN                 16
-#define configUSE_TRACE_FACILITY                0
+#define configUSE_TRACE_FACILITY                1
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
 
+/* Tickless idle; vPortSuppressTicksAndSleep() lives in blfm_power.c */
+#define configUSE_TICKLESS_IDLE                 2
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
+
 #define configUSE_MUTEXES                       1
 #define configQUEUE_REGISTRY_SIZE               0
-#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configCHECK_FOR_STACK_OVERFLOW          2
 #define configUSE_RECURSIVE_MUTEXES             0
 #define configUSE_MALLOC_FAILED_HOOK            0
 
+/* Set by `make STATIC_ALLOC=1`: no heap, every kernel object in .bss */
+#ifndef BLFM_STATIC_ALLOCATION
+#define BLFM_STATIC_ALLOCATION                  0
+#endif
+
+#if BLFM_STATIC_ALLOCATION
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+#define configKERNEL_PROVIDED_STATIC_MEMORY     1
+#else
 #define configSUPPORT_STATIC_ALLOCATION         0
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
+#endif
 
 #define configKERNEL_INTERRUPT_PRIORITY         255
 #define configMAX_SYSCALL_INTERRUPT_PRIORITY    191
@@ -40,15 +56,24 @@
 #define configUSE_TIMERS                        0
 #define configUSE_QUEUE_SETS 1
 
+/* Index 1 belongs to the I2C1 engine, see blfm_i2c1.h */
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   2
+
 /* Required for CMSIS-style interrupt names */
 #define vPortSVCHandler SVC_Handler
 #define xPortPendSVHandler PendSV_Handler
 #define xPortSysTickHandler SysTick_Handler
 
 #define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskDelayUntil 1
 #define INCLUDE_vTaskDelete 1
 #define INCLUDE_xSemaphoreGetMutexHolder 1
 #define INCLUDE_vTaskSuspend 1
 #define INCLUDE_xTaskGetSchedulerState    1
+#define INCLUDE_xTaskGetIdleTaskHandle    1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+
+/* cpuload, monitoring and trace hooks, shared with the simulator config */
+#include "blfm_rtos_hooks.h"
 
 #endif /* FREERTOS_CONFIG_H */
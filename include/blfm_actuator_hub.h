@@ -11,10 +11,54 @@
 #ifndef BLFM_ACTUATOR_HUB_H
 #define BLFM_ACTUATOR_HUB_H
 
+#include "blfm_cmd_pool.h"
 #include "blfm_types.h"
 
+typedef enum {
+  BLFM_ACTUATOR_LED = 0,
+  BLFM_ACTUATOR_MOTOR,
+  BLFM_ACTUATOR_DISPLAY,
+  BLFM_ACTUATOR_OLED,
+  BLFM_ACTUATOR_SERVO1,
+  BLFM_ACTUATOR_SERVO2,
+  BLFM_ACTUATOR_SERVO3,
+  BLFM_ACTUATOR_SERVO4,
+  BLFM_ACTUATOR_ALARM,
+  BLFM_ACTUATOR_RADIO,
+  BLFM_ACTUATOR_COUNT
+} blfm_actuator_id_t;
+
+typedef struct {
+  uint32_t applied; // Commands that changed the actuator and were written
+  uint32_t skipped; // Commands identical to the shadow state, not written
+} blfm_actuator_update_stats_t;
+
+typedef struct {
+  uint32_t commands;      // Commands applied
+  uint32_t conflated;     // Older commands dropped for a newer one
+  uint32_t latency_last;  // Ticks from controller publish to apply
+  uint32_t latency_max;
+  uint32_t latency_total; // Sum over all applied commands, for averaging
+} blfm_actuator_hub_latency_t;
+
 void blfm_actuator_hub_init(void);
 void blfm_actuator_hub_apply(const blfm_actuator_command_t *cmd);
+void blfm_actuator_hub_apply_handle(blfm_cmd_handle_t handle);
+
+/**
+ * Drop a queued command that was superseded by a newer one.
+ */
+void blfm_actuator_hub_discard_handle(blfm_cmd_handle_t handle);
+
+/**
+ * Forget the shadow state so the next command rewrites every actuator,
+ * e.g. after an actuator was reset behind the hub's back.
+ */
+void blfm_actuator_hub_invalidate(void);
+
+void blfm_actuator_hub_get_stats(blfm_actuator_id_t id,
+                                 blfm_actuator_update_stats_t *out);
+void blfm_actuator_hub_get_latency(blfm_actuator_hub_latency_t *out);
 
 #endif // BLFM_ACTUATOR_HUB_H
 
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_BENCH_H
+#define BLFM_BENCH_H
+
+/*
+ * On-target microbenchmarks. With BLFM_ENABLED_BENCH main() runs the
+ * registry once in place of the rover tasks: every operation is timed
+ * BLFM_BENCH_RUNS times on DWT->CYCCNT with interrupts masked, and the
+ * report goes out on USART1 as text lines:
+ *
+ *   BENCH begin <runs> <cpu_hz> <overhead>
+ *   BENCH <name> <min> <median> <max> <result>
+ *   ...
+ *   BENCH end <count>
+ *
+ * Cycles have the overhead of timing an empty call taken off. result is
+ * what the last run returned, so a driver that failed (nothing on the bus)
+ * shows as such rather than as a fast run.
+ *
+ * tools/bench/bench_target.py captures a report and compares it with a
+ * baseline.
+ */
+
+void blfm_bench_run(void);
+
+#endif // BLFM_BENCH_H
@@ -0,0 +1,74 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_CMD_POOL_H
+#define BLFM_CMD_POOL_H
+
+#include "blfm_types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Statically allocated pool of actuator command buffers.
+ *
+ * Only a one-byte handle travels through the actuator queue. Every holder of
+ * a handle owns one reference: the controller gets one from acquire, hands it
+ * to the queue on send, and the actuator hub drops it after applying.
+ *
+ * Each buffer holds a complete actuator state. The pool keeps a reference to
+ * the last published buffer; acquire reuses it in place when nobody else holds
+ * it, otherwise it clones it into a free slot (copy-on-write).
+ */
+
+// Every slot of the actuator queue, the command the hub is applying and the
+// one the controller is filling; the last published state is one of these
+#define BLFM_CMD_POOL_SIZE 7
+#define BLFM_CMD_HANDLE_INVALID 0xFF
+
+typedef uint8_t blfm_cmd_handle_t;
+
+typedef struct {
+  uint32_t acquired;     // Buffers handed to producers
+  uint32_t reused;       // Acquires served in place, no copy
+  uint32_t cloned;       // Acquires that copied the last state
+  uint32_t bytes_copied; // Total bytes copied by clones
+  uint32_t exhausted;    // Acquires that found no free slot
+  uint8_t in_use;        // Slots currently referenced
+  uint8_t peak_in_use;   // Highest in_use seen
+} blfm_cmd_pool_stats_t;
+
+void blfm_cmd_pool_init(void);
+
+/**
+ * Get a writable buffer holding the last published state.
+ * Returns NULL and sets *handle to BLFM_CMD_HANDLE_INVALID when the pool is
+ * exhausted. The caller owns one reference to the returned handle.
+ */
+blfm_actuator_command_t *blfm_cmd_pool_acquire(blfm_cmd_handle_t *handle);
+
+/**
+ * Mark a buffer as the latest state and stamp it with the current tick.
+ * Must be called before the handle is sent; the caller keeps its own
+ * reference, which then moves to the queue.
+ */
+void blfm_cmd_pool_publish(blfm_cmd_handle_t handle);
+
+blfm_actuator_command_t *blfm_cmd_pool_get(blfm_cmd_handle_t handle);
+void blfm_cmd_pool_retain(blfm_cmd_handle_t handle);
+void blfm_cmd_pool_release(blfm_cmd_handle_t handle);
+
+/**
+ * Tick count recorded when the buffer was last published.
+ */
+uint32_t blfm_cmd_pool_get_timestamp(blfm_cmd_handle_t handle);
+
+void blfm_cmd_pool_get_stats(blfm_cmd_pool_stats_t *out);
+
+#endif // BLFM_CMD_POOL_H
@@ -15,6 +15,7 @@
 #define BLFM_ENABLED_ULTRASONIC 0
 #define BLFM_ENABLED_POTENTIOMETER 0
 #define BLFM_ENABLED_TEMPERATURE 0
+#define BLFM_ENABLED_IMU 0
 
 /* === Actuators presence flags === */
 #define BLFM_ENABLED_LED 1
@@ -38,4 +39,103 @@
 #define BLFM_ENABLED_MODE_BUTTON 1
 #define BLFM_ENABLED_ESP32 0
 
+/* === IR remote === */
+// Edges the EXTI handler can buffer ahead of the decoder, a power of two
+#define BLFM_IR_EDGE_BUFFER 64
+// The decoder wakes once per batch of edges, and after a flush period
+// without a full batch; a burst ends with a flush period without edges
+#define BLFM_IR_DECODE_BATCH 16
+#define BLFM_IR_DECODE_FLUSH_MS 5
+// 1: capture edges with TIM1 CH1/CH2 and DMA instead of EXTI, one interrupt
+// per frame. A frame is everything within the window after its first edge,
+// so commands arrive when the window closes. Not usable with STOP mode.
+#define BLFM_IR_TIMER_CAPTURE 0
+// Covers a 67.5 ms NEC frame; repeats come every 108 ms
+#define BLFM_IR_CAPTURE_WINDOW_MS 80
+// Per edge direction; a NEC frame has 34 of each
+#define BLFM_IR_CAPTURE_EDGES 40
+
+/* === Actuator pipeline === */
+// Apply only the newest queued command; older full-state commands are dropped
+#define BLFM_ACTUATOR_LATEST_WINS 1
+
+/* === Sensor scheduling === */
+// 1: sample sensors from a TIM3 driven cyclic executive
+// 0: one 100 ms SensorHub loop plus a periodic ultrasonic task
+#define BLFM_SENSOR_CYCLIC_EXEC 0
+
+// Minor frame rate; every rate below must divide it
+#define BLFM_CE_MINOR_FRAME_HZ 200
+
+#define BLFM_RATE_IMU_HZ 200
+#define BLFM_RATE_ULTRASONIC_HZ 20
+#define BLFM_RATE_POTENTIOMETER_HZ 10
+#define BLFM_RATE_TEMPERATURE_HZ 1
+// How often the controller is woken with a fresh snapshot
+#define BLFM_RATE_CONTROL_HZ 10
+
+/* === Monitoring === */
+// Samples stack, heap and queue headroom in a low priority task
+#define BLFM_ENABLED_MONITORING 1
+#define BLFM_MONITORING_PERIOD_MS 1000
+// Flag a task once less than this share of its stack has stayed untouched
+#define BLFM_MONITORING_STACK_MARGIN_PERCENT 20
+#define BLFM_MONITORING_HEAP_MARGIN_BYTES 1024
+
+/* === Trace === */
+// Record scheduler, queue and ISR events into RAM and stream them on USART1
+#define BLFM_ENABLED_TRACE 0
+// Ring size in 8-byte records, a power of two
+#define BLFM_TRACE_RECORDS 256
+#define BLFM_TRACE_DRAIN_MS 10
+
+/* === Record === */
+// Log every controller input and stream it on USART1 for tools/replay.
+// Shares the UART with the trace, so only one of the two can be enabled.
+#define BLFM_ENABLED_RECORD 0
+// Ring size in bytes, a power of two; a sensor frame takes about 40
+#define BLFM_RECORD_RING_BYTES 1024
+#define BLFM_RECORD_DRAIN_MS 20
+
+/* === UART === */
+// USART1 baud rate, up to 4.5 Mbaud; tell the host tools when changing it
+#define BLFM_UART_BAUD 115200
+// 1: writes go into a RAM ring that DMA1 channel 4 drains in the background
+// 0: every byte waits for the transmitter
+#define BLFM_UART_TX_DMA 1
+// Ring size in bytes, a power of two. 256 B is 22 ms of line at 115200
+// baud; the trace and record drains only take what fits
+#define BLFM_UART_TX_RING_BYTES 256
+// A write the ring has no room for; BLFM_UART_OVERFLOW_* in blfm_uart.h
+#define BLFM_UART_TX_OVERFLOW BLFM_UART_OVERFLOW_DISCARD
+// Circular receive buffer; a burst of up to half of it arrives in one piece
+#define BLFM_UART_RX_DMA_BYTES 64
+
+/* === I2C1 === */
+// 1: once the scheduler runs, transactions go to an interrupt driven engine
+// with DMA1 channels 6 and 7, and the caller blocks rather than spins
+#define BLFM_I2C1_ASYNC 1
+// Allowed on top of the time the bytes take before a transaction is aborted
+#define BLFM_I2C1_TIMEOUT_MS 10
+// Client priorities, higher first once the running transaction ends
+#define BLFM_I2C1_PRIO_IMU 2
+#define BLFM_I2C1_PRIO_OTHER 1
+#define BLFM_I2C1_PRIO_OLED 0
+// Framebuffer bytes per OLED transaction; the IMU waits for one at most
+#define BLFM_OLED_I2C_CHUNK 16
+
+/* === Bench === */
+// Benchmark build: main() times the blfm_bench.h registry on DWT->CYCCNT,
+// reports on USART1 and stops; the rover tasks never start
+#define BLFM_ENABLED_BENCH 0
+// Runs per benchmark; min, median and max are reported
+#define BLFM_BENCH_RUNS 31
+
+/* === Power === */
+// Idle always suppresses the tick and sleeps in WFI. 1: idle periods of at
+// least BLFM_POWER_STOP_MIN_MS enter STOP mode, timed by the LSE clocked RTC.
+// STOP halts every peripheral clock, so keep it for parking.
+#define BLFM_POWER_STOP_MODE 0
+#define BLFM_POWER_STOP_MIN_MS 50
+
 #endif /* BLFM_CONFIG_H */
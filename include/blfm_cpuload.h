@@ -0,0 +1,86 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_CPULOAD_H
+#define BLFM_CPULOAD_H
+
+#include "blfm_taskmanager.h"
+#include <stdint.h>
+
+/*
+ * CPU accounting on the DWT cycle counter.
+ *
+ * The kernel's task-switch hook charges the cycles since the previous switch
+ * to the task that was running. Instrumented ISRs charge their own cycles and
+ * take them off the interrupted task. Kernel time (SysTick, PendSV) stays
+ * with the task it interrupted.
+ *
+ * The core clock stops in WFI and STOP, so the idle figure is wall time
+ * minus everything that ran, not the idle task's own cycle count.
+ */
+
+// Task slots: one per blfm_task_id_t, then the idle task and everything else
+#define BLFM_CPULOAD_SLOT_IDLE BLFM_TASK_COUNT
+#define BLFM_CPULOAD_SLOT_OTHER (BLFM_TASK_COUNT + 1)
+#define BLFM_CPULOAD_TASK_SLOTS (BLFM_TASK_COUNT + 2)
+
+typedef enum {
+  BLFM_ISR_EXTI3,
+  BLFM_ISR_EXTI4,
+  BLFM_ISR_EXTI9_5,
+  BLFM_ISR_TIM3,
+  BLFM_ISR_RTC_ALARM,
+  BLFM_ISR_TIM1_UP,
+  BLFM_ISR_DMA1_CH4,
+  BLFM_ISR_DMA1_CH5,
+  BLFM_ISR_USART1,
+  BLFM_ISR_I2C1_EV,
+  BLFM_ISR_I2C1_ER,
+  BLFM_ISR_DMA1_CH6,
+  BLFM_ISR_DMA1_CH7,
+  BLFM_ISR_COUNT
+} blfm_isr_id_t;
+
+typedef struct {
+  uint32_t activations; // Switch-ins for a task, entries for an ISR
+  uint32_t peak_cycles; // Longest single activation
+  uint64_t total_cycles;
+} blfm_cpuload_entry_t;
+
+typedef struct {
+  blfm_cpuload_entry_t tasks[BLFM_CPULOAD_TASK_SLOTS];
+  blfm_cpuload_entry_t isrs[BLFM_ISR_COUNT];
+  uint32_t context_switches;
+  uint64_t elapsed_cycles; // Wall time since blfm_cpuload_init
+  uint64_t busy_cycles;    // Non-idle tasks plus ISRs
+  uint8_t idle_percent;
+} blfm_cpuload_stats_t;
+
+void blfm_cpuload_init(void);
+
+/**
+ * Tag a task so its cycles land in the slot of the given task id.
+ */
+void blfm_cpuload_register_task(TaskHandle_t handle, blfm_task_id_t id);
+
+/**
+ * Bracket an ISR body: keep the value from enter and hand it to exit.
+ */
+uint32_t blfm_cpuload_isr_enter(blfm_isr_id_t id);
+void blfm_cpuload_isr_exit(blfm_isr_id_t id, uint32_t entered);
+
+/**
+ * Called by the kernel through traceTASK_SWITCHED_IN.
+ */
+void blfm_cpuload_task_switched_in(uint32_t task_number);
+
+void blfm_cpuload_get_stats(blfm_cpuload_stats_t *out);
+
+#endif // BLFM_CPULOAD_H
@@ -8,17 +8,19 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "FreeRTOS.h"
+#include "queue.h"
 #include "blfm_types.h"
 
-// Initialize UART and buffer
-void blfm_esp32_init(void);
+// Start receiving on USART1; every command frame is sent to the queue from
+// the receive interrupt, so the controller wakes as soon as a burst ends
+void blfm_esp32_init(QueueHandle_t controller_queue);
 
-// Call from UART RX interrupt for each received byte
-void blfm_esp32_receive_byte(uint8_t byte);
+// Receive callback: a span of bytes off the link
+void blfm_esp32_receive(const uint8_t *data, uint32_t len);
 
-// Application calls this to get parsed events
-// Returns true if an event was available and filled
-bool blfm_esp32_get_event(blfm_esp32_event_t *out_event);
+// Frames lost because the controller queue was full
+uint32_t blfm_esp32_get_dropped(void);
 
 #endif // BLFM_ESP32_H
 
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_HAL_H
+#define BLFM_HAL_H
+
+#include "stm32f1xx.h"
+#include <stdint.h>
+
+/*
+ * Peripheral register access for drivers.
+ *
+ * Write BLFM_REG_READ(I2C1, SR1) where a driver would write I2C1->SR1. On
+ * target the macros are that same volatile access, nothing more. Host
+ * builds set BLFM_HAL_HOST=1 and every access becomes a call into
+ * tools/hal, where the model of the peripheral that owns the address keeps
+ * its virtual register file, raises flags and injects faults.
+ *
+ * A buffer handed to a DMA channel goes through BLFM_DMA_ADDR(), which on
+ * the host stands for a pointer wider than CMAR. Interrupt lines are
+ * enabled with BLFM_IRQ_ENABLE(), so the host knows which handlers it may
+ * run.
+ */
+
+#ifndef BLFM_HAL_HOST
+#define BLFM_HAL_HOST 0
+#endif
+
+#if BLFM_HAL_HOST
+
+uint32_t blfm_hal_host_read(const volatile uint32_t *reg);
+void blfm_hal_host_write(volatile uint32_t *reg, uint32_t value);
+uint32_t blfm_hal_host_dma_addr(const volatile void *buf);
+void blfm_hal_host_irq_enable(IRQn_Type irq, uint32_t priority);
+
+#define BLFM_REG_READ(periph, reg) blfm_hal_host_read(&(periph)->reg)
+#define BLFM_REG_WRITE(periph, reg, value)                                     \
+  blfm_hal_host_write(&(periph)->reg, (uint32_t)(value))
+#define BLFM_DMA_ADDR(buf) blfm_hal_host_dma_addr(buf)
+#define BLFM_IRQ_ENABLE(irq, priority) blfm_hal_host_irq_enable(irq, priority)
+
+#else
+
+#define BLFM_REG_READ(periph, reg) ((periph)->reg)
+#define BLFM_REG_WRITE(periph, reg, value) ((periph)->reg = (value))
+#define BLFM_DMA_ADDR(buf) ((uint32_t)(buf))
+#define BLFM_IRQ_ENABLE(irq, priority)                                         \
+  do {                                                                         \
+    NVIC_SetPriority(irq, priority);                                           \
+    NVIC_EnableIRQ(irq);                                                       \
+  } while (0)
+
+#endif // BLFM_HAL_HOST
+
+// Read-modify-write, one read and one write like the |= and &= they replace
+#define BLFM_REG_SET(periph, reg, bits)                                        \
+  BLFM_REG_WRITE(periph, reg, BLFM_REG_READ(periph, reg) | (bits))
+#define BLFM_REG_CLEAR(periph, reg, bits)                                      \
+  BLFM_REG_WRITE(periph, reg, BLFM_REG_READ(periph, reg) & ~(bits))
+#define BLFM_REG_TOGGLE(periph, reg, bits)                                     \
+  BLFM_REG_WRITE(periph, reg, BLFM_REG_READ(periph, reg) ^ (bits))
+
+#endif // BLFM_HAL_H
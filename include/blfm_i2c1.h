@@ -1,4 +1,3 @@
-
 /*
  * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
  *
@@ -13,10 +12,122 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * I2C1 master at 100 kHz. With BLFM_I2C1_ASYNC, once the scheduler runs,
+ * the calls below queue a transaction for the interrupt and DMA driven
+ * engine and block the calling task until it completes; before that, in
+ * interrupts and on the host they poll the peripheral. All return 0 on
+ * success and a negative BLFM_I2C1_E* otherwise.
+ *
+ * Each transaction belongs to a client. A transaction runs to its end, and
+ * then the waiting one of the highest client priority, BLFM_I2C1_PRIO_*,
+ * goes next; clients with long transfers split them so others get in.
+ */
+
+#define BLFM_I2C1_OK 0
+#define BLFM_I2C1_EINVAL (-1)  // Bad arguments; also every polled failure
+#define BLFM_I2C1_ENACK (-2)   // Address or data not acknowledged
+#define BLFM_I2C1_EBUS (-3)    // Bus error or lost arbitration
+#define BLFM_I2C1_ETIMEOUT (-4)
+#define BLFM_I2C1_PENDING 1     // Transaction status while queued or running
+
+// Task notification slot the engine completes transactions on
+#define BLFM_I2C1_NOTIFY_INDEX 1
+
+typedef enum {
+  BLFM_I2C1_CLIENT_OTHER,
+  BLFM_I2C1_CLIENT_IMU,
+  BLFM_I2C1_CLIENT_OLED,
+  BLFM_I2C1_CLIENT_COUNT
+} blfm_i2c1_client_t;
+
+typedef struct blfm_i2c1_xfer {
+  blfm_i2c1_client_t client;
+  uint8_t addr;          // 7-bit address
+  const uint8_t *tx;     // Written first
+  size_t tx_len;
+  uint8_t *rx;           // Then read after a repeated START
+  size_t rx_len;
+  void *task;            // Notified when done; set by blfm_i2c1_submit()
+  volatile int status;   // BLFM_I2C1_PENDING, then the result
+  uint32_t queued_at;    // DWT cycle count at submission
+  struct blfm_i2c1_xfer *next;
+} blfm_i2c1_xfer_t;
+
+typedef struct {
+  uint32_t transfers;  // Completed, successfully or not
+  uint32_t nacks;
+  uint32_t bus_errors;
+  uint32_t timeouts;
+  uint32_t recoveries; // Peripheral resets and bus clears
+  uint32_t peak_queue; // Most transactions ever waiting
+} blfm_i2c1_stats_t;
+
+// Time from submission to the START, for transactions that got the bus
+typedef struct {
+  uint32_t transfers;
+  uint64_t wait_total_us;
+  uint32_t wait_max_us;
+} blfm_i2c1_client_stats_t;
 
 void blfm_i2c1_init(void);
 int blfm_i2c1_write(uint8_t addr, const uint8_t *data, size_t len);
 int blfm_i2c1_write_byte(uint8_t addr, uint8_t reg, uint8_t data);
 int blfm_i2c1_read_bytes(uint8_t addr, uint8_t reg, uint8_t *buf, size_t len);
 
+/**
+ * As above, on behalf of a client other than BLFM_I2C1_CLIENT_OTHER.
+ */
+int blfm_i2c1_client_write(blfm_i2c1_client_t client, uint8_t addr,
+                           const uint8_t *data, size_t len);
+int blfm_i2c1_client_read_bytes(blfm_i2c1_client_t client, uint8_t addr,
+                                uint8_t reg, uint8_t *buf, size_t len);
+
+/**
+ * Reset the peripheral and restore its 100 kHz timing.
+ */
+void blfm_i2c1_reset(void);
+
+/**
+ * Queue a transaction; the submitting task is notified on
+ * BLFM_I2C1_NOTIFY_INDEX when it completes. The transaction and its
+ * buffers must stay valid until then. Tasks only.
+ */
+int blfm_i2c1_submit(blfm_i2c1_xfer_t *xfer);
+
+/**
+ * Wait for a submitted transaction and return its status. One still
+ * pending after timeout_ms is aborted, resetting the bus if it had started.
+ */
+int blfm_i2c1_wait(blfm_i2c1_xfer_t *xfer, uint32_t timeout_ms);
+
+/**
+ * Write tx_len bytes then read rx_len after a repeated START, waiting for
+ * the engine; either length may be 0, not both.
+ */
+int blfm_i2c1_transfer(blfm_i2c1_client_t client, uint8_t addr,
+                       const uint8_t *tx, size_t tx_len, uint8_t *rx,
+                       size_t rx_len);
+
+/**
+ * True while the engine has a transaction running or queued.
+ */
+bool blfm_i2c1_busy(void);
+
+/**
+ * Set up the engine's DMA channels and interrupts; from blfm_i2c1_init().
+ */
+void blfm_i2c1_async_init(void);
+
+/**
+ * True where the engine can be waited on: a task, with the scheduler running.
+ */
+bool blfm_i2c1_async_ready(void);
+
+void blfm_i2c1_get_stats(blfm_i2c1_stats_t *out);
+void blfm_i2c1_get_client_stats(blfm_i2c1_client_t client,
+                                blfm_i2c1_client_stats_t *out);
+
 #endif // BLFM_I2C1_H
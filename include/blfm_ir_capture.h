@@ -0,0 +1,46 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_IR_CAPTURE_H
+#define BLFM_IR_CAPTURE_H
+
+#include "FreeRTOS.h"
+#include "blfm_config.h"
+#include <stdint.h>
+
+/*
+ * IR edge capture on TIM1 without per-edge interrupts. PA8 is TIM1_CH1:
+ * CH1 latches rising edges and CH2 falling edges of the same input, and DMA
+ * moves each capture into a buffer. The first edge of a frame starts the
+ * counter in trigger mode; one-pulse mode stops it when the capture window
+ * ends, and that update interrupt hands the whole frame over.
+ */
+
+#define BLFM_IR_CAPTURE_US_PER_COUNT 2
+#define BLFM_IR_CAPTURE_WINDOW_COUNTS                                          \
+  (BLFM_IR_CAPTURE_WINDOW_MS * 1000 / BLFM_IR_CAPTURE_US_PER_COUNT)
+
+typedef struct {
+  const uint16_t *rise; // Counter values since the frame's first edge
+  const uint16_t *fall;
+  uint8_t rise_count;
+  uint8_t fall_count;
+  uint32_t end_cycles;  // CYCCNT when the window closed,
+  TickType_t end_tick;  // at counter value BLFM_IR_CAPTURE_WINDOW_COUNTS
+} blfm_ir_capture_frame_t;
+
+typedef void (*blfm_ir_capture_callback_t)(const blfm_ir_capture_frame_t *frame);
+
+/**
+ * The callback runs in the TIM1 update interrupt, once per frame.
+ */
+void blfm_ir_capture_init(blfm_ir_capture_callback_t callback);
+
+#endif // BLFM_IR_CAPTURE_H
@@ -0,0 +1,81 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_IR_DECODER_H
+#define BLFM_IR_DECODER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Table-driven IR pulse-train decoder. Every protocol in the table runs its
+ * own small state machine over the same stream of mark and space durations,
+ * so the protocol is identified by whichever one completes a valid frame.
+ * State is a fixed few bytes per protocol; nothing depends on frame length.
+ *
+ * Three encodings cover the supported remotes:
+ *   pulse distance  NEC, Samsung   constant mark, the space carries the bit
+ *   pulse width     Sony SIRC      constant space, the mark carries the bit
+ *   bi-phase        RC5, RC6       Manchester halves of a fixed unit
+ *
+ * Pure C without RTOS or hardware dependencies, so it also runs on the host.
+ */
+
+typedef enum {
+  BLFM_IR_PROTO_NEC = 0,
+  BLFM_IR_PROTO_SAMSUNG,
+  BLFM_IR_PROTO_SONY,
+  BLFM_IR_PROTO_RC5,
+  BLFM_IR_PROTO_RC6,
+  BLFM_IR_PROTO_COUNT
+} blfm_ir_protocol_t;
+
+typedef struct {
+  uint8_t protocol; // blfm_ir_protocol_t
+  uint8_t bits;
+  bool repeat;      // NEC repeat code, or RC5/RC6 with an unchanged toggle
+  uint16_t address;
+  uint16_t command;
+  uint32_t raw;     // Bits in arrival order for MSB-first protocols
+} blfm_ir_frame_t;
+
+typedef struct {
+  uint8_t state;
+  uint8_t count;  // Bits, or half-bits for bi-phase
+  uint8_t first;  // Bi-phase: level of the current bit's first half
+  uint8_t toggle; // Last toggle bit seen, 0xFF before the first frame
+  uint32_t data;
+} blfm_ir_proto_state_t;
+
+typedef struct {
+  blfm_ir_proto_state_t proto[BLFM_IR_PROTO_COUNT];
+  blfm_ir_frame_t last; // Replayed by NEC repeat codes
+  bool has_last;
+} blfm_ir_decoder_t;
+
+void blfm_ir_decoder_init(blfm_ir_decoder_t *dec);
+
+/**
+ * Feed one pulse: is_mark for carrier on (receiver output low). Returns true
+ * and fills *out when the pulse completes a frame.
+ */
+bool blfm_ir_decoder_feed(blfm_ir_decoder_t *dec, uint32_t duration_us,
+                          bool is_mark, blfm_ir_frame_t *out);
+
+/**
+ * The line has been quiet since the last pulse. Frames whose end is only
+ * known from the gap (Sony, a bi-phase frame ending in a space) complete
+ * here.
+ */
+bool blfm_ir_decoder_idle(blfm_ir_decoder_t *dec, blfm_ir_frame_t *out);
+
+const char *blfm_ir_decoder_protocol_name(blfm_ir_protocol_t protocol);
+
+#endif // BLFM_IR_DECODER_H
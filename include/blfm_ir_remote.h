@@ -15,13 +15,34 @@
 #define BLFM_IR_REMOTE_H
 
 #include "FreeRTOS.h"
+#include "blfm_ir_decoder.h"
 #include "blfm_types.h"
 #include "queue.h"
 #include <stdint.h>
 
+typedef struct {
+  uint32_t edges;              // Buffered by the EXTI handler
+  uint32_t overruns;           // Edges lost to a full buffer
+  uint32_t isr_cycles_peak;    // Per edge, or per frame with timer capture
+  uint64_t isr_cycles_total;
+  uint32_t batches;            // Decoder passes that found edges
+  uint32_t decoded;            // Edges run through the state machine
+  uint32_t decode_cycles_peak; // Longest single pass
+  uint64_t decode_cycles_total;
+  uint32_t frames[BLFM_IR_PROTO_COUNT]; // Posted to the controller
+} blfm_ir_remote_stats_t;
+
 void blfm_ir_remote_init(QueueHandle_t controller_queue);
 void ir_exti_handler(void);
 
+/**
+ * Decodes buffered edges and posts frames of any supported protocol to the
+ * controller queue.
+ */
+void blfm_ir_remote_task(void *params);
+
+void blfm_ir_remote_get_stats(blfm_ir_remote_stats_t *out);
+
 #endif // BLFM_IR_REMOTE_H
 
 #endif /* BLFM_ENABLED_IR_REMOTE */
@@ -0,0 +1,74 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_LATENCY_H
+#define BLFM_LATENCY_H
+
+#include "blfm_types.h"
+#include <stdint.h>
+
+/*
+ * Input-to-actuation latency. The IR edge or sensor publish opens a
+ * correlation id, the controller stamps it when it dequeues the input and
+ * when it publishes the command, and the actuator hub closes it once the
+ * outputs are written. Each segment feeds a log2 histogram per path.
+ *
+ * Stamps are CYCCNT for resolution plus the tick count, which takes over
+ * when the core slept in between and CYCCNT stood still.
+ */
+
+typedef enum {
+  BLFM_LATENCY_PATH_IR = 1, // 0 is reserved for untracked commands
+  BLFM_LATENCY_PATH_SENSOR,
+  BLFM_LATENCY_PATH_COUNT
+} blfm_latency_path_t;
+
+typedef enum {
+  BLFM_LATENCY_SEG_TO_CONTROLLER, // Origin to controller dequeue
+  BLFM_LATENCY_SEG_CONTROLLER,    // Dequeue to command publish
+  BLFM_LATENCY_SEG_TO_ACTUATOR,   // Publish to outputs written
+  BLFM_LATENCY_SEG_TOTAL,         // Origin to outputs written
+  BLFM_LATENCY_SEG_COUNT
+} blfm_latency_seg_t;
+
+// Bucket i holds [2^i, 2^(i+1)) us, bucket 0 also holds 0; the last saturates
+#define BLFM_LATENCY_BUCKETS 20
+
+typedef struct {
+  uint32_t count;
+  uint32_t max_us;
+  uint16_t bucket[BLFM_LATENCY_BUCKETS]; // Saturates at 0xFFFF
+} blfm_latency_hist_t;
+
+/**
+ * Open a correlation; ISR-safe. Callers pass the stamps they already hold.
+ */
+void blfm_latency_origin(blfm_corr_t *corr, blfm_latency_path_t path,
+                         uint32_t cycles, uint32_t tick);
+
+void blfm_latency_stamp(blfm_stamp_t *stamp);
+
+/**
+ * Controller side: begin when the input is dequeued, publish when the
+ * command goes out. Untracked inputs leave the command untracked.
+ */
+void blfm_latency_begin(blfm_actuator_command_t *cmd, const blfm_corr_t *corr);
+void blfm_latency_publish(blfm_actuator_command_t *cmd);
+
+/**
+ * Actuator side, right after the outputs are written. Single caller.
+ */
+void blfm_latency_applied(const blfm_actuator_command_t *cmd);
+
+void blfm_latency_get(blfm_latency_path_t path, blfm_latency_seg_t seg,
+                      blfm_latency_hist_t *out);
+void blfm_latency_reset(void);
+
+#endif // BLFM_LATENCY_H
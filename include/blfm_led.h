@@ -20,6 +20,11 @@
 void blfm_led_init(void);
 void blfm_led_apply(const blfm_led_command_t *cmd);
 
+/**
+ * Periodic LED task, created from the task table.
+ */
+void blfm_led_task(void *pvParameters);
+
 #endif /* BLFM_ALARM_H */
 
 #endif /* BLFM_ENABLED_LED */
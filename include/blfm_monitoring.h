@@ -11,11 +11,91 @@
 #ifndef BLFM_MONITORING_H
 #define BLFM_MONITORING_H
 
+#include "FreeRTOS.h"
+#include "blfm_cpuload.h"
+#include "blfm_taskmanager.h"
+#include "queue.h"
+#include <stdbool.h>
 #include <stdint.h>
 
+/*
+ * RAM headroom: stack high-water marks, heap_4 low-water mark and
+ * fragmentation, and the deepest each registered queue has been. CPU
+ * headroom: the cycles each task has run and the idle share, from
+ * blfm_cpuload. The monitoring task refreshes the report every
+ * BLFM_MONITORING_PERIOD_MS.
+ */
+
+#define BLFM_MONITORING_MAX_QUEUES 8
+
+// One stack entry per blfm_task_id_t, then the idle task
+#define BLFM_MONITORING_STACK_IDLE BLFM_TASK_COUNT
+#define BLFM_MONITORING_STACKS (BLFM_TASK_COUNT + 1)
+
+// blfm_monitoring_check_health() bits
+#define BLFM_HEALTH_STACK_LOW (1U << 0)
+#define BLFM_HEALTH_HEAP_LOW (1U << 1)
+#define BLFM_HEALTH_QUEUE_FULL (1U << 2)
+
+typedef struct {
+  uint16_t size_words; // 0 when the task was not created
+  uint16_t free_min;   // Fewest free words ever left on the stack
+  bool low;            // free_min under the configured margin
+} blfm_monitoring_stack_t;
+
+typedef struct {
+  const char *name;
+  uint8_t length;
+  uint8_t peak;  // Most items ever waiting at once
+  uint16_t full; // Sends that failed or blocked because the queue was full
+} blfm_monitoring_queue_t;
+
+typedef struct {
+  blfm_monitoring_stack_t stacks[BLFM_MONITORING_STACKS];
+  blfm_monitoring_queue_t queues[BLFM_MONITORING_MAX_QUEUES];
+  uint8_t queue_count;
+  uint32_t heap_free;          // All zero in the static allocation build
+  uint32_t heap_min_free;
+  uint32_t heap_largest_block;
+  uint8_t heap_fragmentation;  // Percent of free heap outside the largest block
+  uint64_t task_cycles[BLFM_CPULOAD_TASK_SLOTS]; // Run since boot, per slot
+  uint8_t idle_percent;
+  uint32_t samples;
+} blfm_monitoring_report_t;
+
 void blfm_monitoring_init(void);
 void blfm_monitoring_task(void *params);
+
+/**
+ * Track the peak depth of a queue, semaphore or queue set, and the sends
+ * it turned away. A length-1 signal or mailbox sits at its peak after one
+ * send and coalesces by design, so register only real queues.
+ * The name must outlive the queue.
+ */
+void blfm_monitoring_register_queue(QueueHandle_t queue, const char *name);
+
+/**
+ * Refresh the report now; the monitoring task does this periodically.
+ */
+void blfm_monitoring_sample(void);
+
+void blfm_monitoring_get_report(blfm_monitoring_report_t *out);
+
+/**
+ * BLFM_HEALTH_* bits raised by the last sample, 0 when all is well.
+ */
 int blfm_monitoring_check_health(void);
 
-#endif // BLFM_MONITORING_H
+/**
+ * Called by the kernel through traceQUEUE_SEND.
+ */
+void blfm_monitoring_queue_send(uint32_t queue_number, uint32_t waiting,
+                                uint32_t length);
 
+/**
+ * Called by the kernel through traceQUEUE_SEND_FAILED and
+ * traceBLOCKING_ON_QUEUE_SEND.
+ */
+void blfm_monitoring_queue_full(uint32_t queue_number);
+
+#endif // BLFM_MONITORING_H
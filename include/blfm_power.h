@@ -11,7 +11,36 @@
 #ifndef BLFM_POWER_H
 #define BLFM_POWER_H
 
-void blfm_power_dummy(void);
+#include <stdint.h>
 
-#endif // BLFM_POWER_H
+/*
+ * Tickless idle. When every task is blocked the idle task stops the 1 kHz
+ * tick, sleeps until the next task deadline and steps the tick count by the
+ * time actually slept. SysTick keeps counting in WFI and times short sleeps;
+ * with BLFM_POWER_STOP_MODE long sleeps go to STOP and the RTC times them.
+ */
+
+typedef struct {
+  uint32_t sleeps;    // Idle periods slept in WFI
+  uint32_t stops;     // Idle periods slept in STOP
+  uint32_t aborted;   // Sleeps cancelled because a task became ready
+  uint32_t asleep_ms; // Time spent in WFI or STOP
+  uint32_t awake_ms;  // Uptime minus asleep_ms
+} blfm_power_stats_t;
+
+/**
+ * Start the low-power timer. Call once before the scheduler starts.
+ */
+void blfm_power_init(void);
+
+void blfm_power_get_stats(blfm_power_stats_t *out);
 
+/**
+ * Keep the core clock, and with it DWT->CYCCNT, running in WFI while a
+ * driver times input edges with it; sleeps stay out of STOP meanwhile.
+ * Holds nest. Callable from tasks and from ISRs that may call FreeRTOS.
+ */
+void blfm_power_hold_clock(void);
+void blfm_power_release_clock(void);
+
+#endif // BLFM_POWER_H
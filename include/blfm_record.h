@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_RECORD_H
+#define BLFM_RECORD_H
+
+#include "blfm_config.h"
+#include "blfm_types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Controller input log. The recorder streams it on USART1, tools/replay
+ * feeds it back through blfm_controller_process*() on the host. Pure
+ * encoding, no RTOS, so both sides share it.
+ *
+ * Little-endian. A header, "BLRC" version:u8 config:u32, then records:
+ *   type:u8 dtick:varint payload
+ * dtick is the tick advance since the previous record, LEB128 encoded.
+ *   SENSOR       valid:u8 distance_mm:u16 imu:6*i16 temperature_mc:i32
+ *                potentiometer:u16 timestamp:4*u32
+ *   IR           timestamp:u32 pulse_us:u32 command:u32 address:u16
+ *                protocol:u8 repeat:u8
+ *   MODE_BUTTON  event_type:u8 timestamp:u32
+ *   BIGSOUND     event_type:u8 timestamp:u32
+ *   ESP32        command:u8 speed:u8 timestamp:u32
+ *   IR_TIMEOUT   none, the controller's idle IR timeout check
+ *   DROPPED      count:u16, records lost to a full ring just before
+ * Correlation stamps are not recorded; they never reach the controller's
+ * decisions.
+ */
+
+#define BLFM_RECORD_VERSION 1
+#define BLFM_RECORD_HEADER_BYTES 9
+// Type, a full 5-byte dtick and the sensor payload
+#define BLFM_RECORD_MAX_BYTES 48
+
+// Modules whose flags change what the controller does with its inputs
+#define BLFM_RECORD_CONFIG                                                     \
+  ((BLFM_ENABLED_ULTRASONIC << 0) | (BLFM_ENABLED_POTENTIOMETER << 1) |       \
+   (BLFM_ENABLED_TEMPERATURE << 2) | (BLFM_ENABLED_IMU << 3) |                \
+   (BLFM_ENABLED_LED << 4) | (BLFM_ENABLED_MOTOR << 5) |                      \
+   (BLFM_ENABLED_DISPLAY << 6) | (BLFM_ENABLED_ALARM << 7) |                  \
+   (BLFM_ENABLED_SERVO << 8) | (BLFM_ENABLED_OLED << 9) |                     \
+   (BLFM_ENABLED_BIGSOUND << 10) | (BLFM_ENABLED_IR_REMOTE << 11) |           \
+   (BLFM_ENABLED_MODE_BUTTON << 12) | (BLFM_ENABLED_ESP32 << 13))
+
+typedef enum {
+  BLFM_RECORD_SENSOR = 1,
+  BLFM_RECORD_IR,
+  BLFM_RECORD_MODE_BUTTON,
+  BLFM_RECORD_BIGSOUND,
+  BLFM_RECORD_ESP32,
+  BLFM_RECORD_IR_TIMEOUT,
+  BLFM_RECORD_DROPPED,
+} blfm_record_type_t;
+
+typedef struct {
+  uint8_t type;  // blfm_record_type_t
+  uint32_t tick; // When the controller took the input
+  union {
+    blfm_sensor_data_t sensor;
+    blfm_ir_remote_event_t ir;
+    blfm_mode_button_event_t mode_button;
+    blfm_bigsound_event_t bigsound;
+    blfm_esp32_event_t esp32;
+    uint16_t dropped;
+  };
+} blfm_record_t;
+
+uint32_t blfm_record_encode_header(uint8_t *buf);
+
+/**
+ * Returns false unless buf starts with a header of this version.
+ */
+bool blfm_record_decode_header(const uint8_t *buf, uint32_t len,
+                               uint32_t *config);
+
+/**
+ * Writes at most BLFM_RECORD_MAX_BYTES; returns the length.
+ */
+uint32_t blfm_record_encode(const blfm_record_t *rec, uint32_t prev_tick,
+                            uint8_t *buf);
+
+/**
+ * Returns the bytes consumed, 0 when buf ends mid-record, -1 on an unknown
+ * type.
+ */
+int32_t blfm_record_decode(const uint8_t *buf, uint32_t len,
+                           uint32_t prev_tick, blfm_record_t *rec);
+
+#endif // BLFM_RECORD_H
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_RECORDER_H
+#define BLFM_RECORDER_H
+
+#include "blfm_config.h"
+#include "blfm_record.h"
+#include <stdint.h>
+
+/*
+ * Controller input recorder. Every input the controller acts on is encoded
+ * (see blfm_record.h) into a RAM ring as it is taken; the recorder task
+ * streams the ring on USART1, header first, so a capture must start before
+ * reset. A full ring drops records and says so with a DROPPED record; the
+ * controller never waits on the UART.
+ *
+ * tools/replay runs a capture back through the controller on the host.
+ */
+
+#if BLFM_ENABLED_RECORD
+#define BLFM_RECORD_INPUT(type, input) blfm_recorder_log((type), (input))
+#else
+#define BLFM_RECORD_INPUT(type, input)
+#endif
+
+void blfm_recorder_init(void);
+
+/**
+ * input points at the type's event or sensor struct; NULL for IR_TIMEOUT.
+ * Controller task only: the ring has a single producer.
+ */
+void blfm_recorder_log(uint8_t type, const void *input);
+
+uint32_t blfm_recorder_get_dropped(void);
+
+void blfm_recorder_task(void *params);
+
+#endif // BLFM_RECORDER_H
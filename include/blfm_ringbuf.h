@@ -0,0 +1,78 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_RINGBUF_H
+#define BLFM_RINGBUF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Lock-free single-producer/single-consumer byte ring.
+ *
+ * head is written only by the producer and tail only by the consumer, so no
+ * LDREX/STREX is needed: each side publishes its index with a release store
+ * and reads the other's with an acquire load. Both indices run freely and
+ * wrap at 2^32; the storage size must be a power of two.
+ *
+ * Typical use is one ISR producing and one task consuming, or the reverse.
+ * Neither side ever blocks or disables interrupts.
+ */
+
+typedef struct {
+  uint8_t *buf;
+  uint32_t mask;          // size - 1
+  volatile uint32_t head; // Producer: bytes ever written
+  volatile uint32_t tail; // Consumer: bytes ever read
+} blfm_ringbuf_t;
+
+/**
+ * Returns false when size is not a power of two.
+ */
+bool blfm_ringbuf_init(blfm_ringbuf_t *rb, uint8_t *storage, uint32_t size);
+
+// Either side may call these; the answer can only grow in the caller's favour
+uint32_t blfm_ringbuf_used(const blfm_ringbuf_t *rb);
+uint32_t blfm_ringbuf_free(const blfm_ringbuf_t *rb);
+
+/* -------------------- Producer -------------------- */
+
+bool blfm_ringbuf_push_byte(blfm_ringbuf_t *rb, uint8_t byte);
+
+/**
+ * Copies as much of data as fits; returns the bytes written.
+ */
+uint32_t blfm_ringbuf_push(blfm_ringbuf_t *rb, const uint8_t *data,
+                           uint32_t len);
+
+/**
+ * Zero-copy write: the largest contiguous free span. Fill up to the returned
+ * length at *span, then commit what was written.
+ */
+uint32_t blfm_ringbuf_write_span(blfm_ringbuf_t *rb, uint8_t **span);
+void blfm_ringbuf_commit(blfm_ringbuf_t *rb, uint32_t len);
+
+/* -------------------- Consumer -------------------- */
+
+bool blfm_ringbuf_pop_byte(blfm_ringbuf_t *rb, uint8_t *byte);
+
+/**
+ * Copies up to len bytes out; returns the bytes read.
+ */
+uint32_t blfm_ringbuf_pop(blfm_ringbuf_t *rb, uint8_t *out, uint32_t len);
+
+/**
+ * Zero-copy read: the largest contiguous filled span. Use up to the returned
+ * length at *span, then consume what was used.
+ */
+uint32_t blfm_ringbuf_read_span(blfm_ringbuf_t *rb, const uint8_t **span);
+void blfm_ringbuf_consume(blfm_ringbuf_t *rb, uint32_t len);
+
+#endif // BLFM_RINGBUF_H
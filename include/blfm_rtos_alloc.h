@@ -0,0 +1,88 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_RTOS_ALLOC_H
+#define BLFM_RTOS_ALLOC_H
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+/*
+ * Kernel object creation for both allocation modes.
+ *
+ * Declare storage once at file scope with the *_STORAGE macro, then create
+ * the object with the matching *_CREATE macro. With BLFM_STATIC_ALLOCATION
+ * (make STATIC_ALLOC=1) the storage is a static object placed in
+ * .bss.blfm_rtos.<module>, which `make ram-report` totals per module.
+ * Otherwise the storage macros expand to nothing and the objects come from
+ * the heap as before.
+ */
+
+// Stack depth a task row asks for; the simulator's FreeRTOSConfig.h widens
+// it, since the POSIX port runs every task on a pthread
+#ifndef BLFM_TASK_STACK_WORDS
+#define BLFM_TASK_STACK_WORDS(words) (words)
+#endif
+
+#define BLFM_RTOS_SECTION(module)                                              \
+  __attribute__((section(".bss.blfm_rtos." #module)))
+
+#if BLFM_STATIC_ALLOCATION
+
+#define BLFM_QUEUE_STORAGE(module, name, length, item_size)                    \
+  static StaticQueue_t name##_queue_buffer BLFM_RTOS_SECTION(module);          \
+  static uint8_t name##_queue_storage[(length) * (item_size)]                  \
+      BLFM_RTOS_SECTION(module)
+#define BLFM_QUEUE_CREATE(name, length, item_size)                             \
+  xQueueCreateStatic((length), (item_size), name##_queue_storage,              \
+                     &name##_queue_buffer)
+
+#define BLFM_QUEUE_SET_STORAGE(module, name, length)                           \
+  BLFM_QUEUE_STORAGE(module, name, length, sizeof(QueueSetMemberHandle_t))
+#define BLFM_QUEUE_SET_CREATE(name, length)                                    \
+  xQueueCreateSetStatic((length), name##_queue_storage, &name##_queue_buffer)
+
+#define BLFM_SEMAPHORE_STORAGE(module, name)                                   \
+  static StaticSemaphore_t name##_semaphore_buffer BLFM_RTOS_SECTION(module)
+#define BLFM_BINARY_SEMAPHORE_CREATE(name)                                     \
+  xSemaphoreCreateBinaryStatic(&name##_semaphore_buffer)
+
+#define BLFM_TASK_STORAGE(module, name, stack_words)                           \
+  static StackType_t name##_task_stack[stack_words]                            \
+      BLFM_RTOS_SECTION(module);                                               \
+  static StaticTask_t name##_task_buffer BLFM_RTOS_SECTION(module)
+#define BLFM_TASK_STACK(name) (name##_task_stack)
+#define BLFM_TASK_BUFFER(name) (&name##_task_buffer)
+
+#else
+
+// Expands to a harmless declaration so the trailing ';' stays valid
+#define BLFM_RTOS_NO_STORAGE(name) extern int blfm_rtos_no_storage_##name
+
+#define BLFM_QUEUE_STORAGE(module, name, length, item_size)                    \
+  BLFM_RTOS_NO_STORAGE(name)
+#define BLFM_QUEUE_CREATE(name, length, item_size)                             \
+  xQueueCreate((length), (item_size))
+
+#define BLFM_QUEUE_SET_STORAGE(module, name, length) BLFM_RTOS_NO_STORAGE(name)
+#define BLFM_QUEUE_SET_CREATE(name, length) xQueueCreateSet(length)
+
+#define BLFM_SEMAPHORE_STORAGE(module, name) BLFM_RTOS_NO_STORAGE(name)
+#define BLFM_BINARY_SEMAPHORE_CREATE(name) xSemaphoreCreateBinary()
+
+#define BLFM_TASK_STORAGE(module, name, stack_words) BLFM_RTOS_NO_STORAGE(name)
+#define BLFM_TASK_STACK(name) NULL
+#define BLFM_TASK_BUFFER(name) NULL
+
+#endif /* BLFM_STATIC_ALLOCATION */
+
+#endif // BLFM_RTOS_ALLOC_H
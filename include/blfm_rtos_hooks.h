@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_RTOS_HOOKS_H
+#define BLFM_RTOS_HOOKS_H
+
+#include <stdint.h>
+
+/*
+ * Kernel trace macros, included at the end of FreeRTOSConfig.h. Kept apart
+ * so the target and the host simulator (tools/sim) run the same hooks.
+ */
+
+/* Per-task CPU accounting on DWT->CYCCNT, see blfm_cpuload.h */
+void blfm_cpuload_task_switched_in(uint32_t task_number);
+
+/* Queue peak depths and rejected sends, see blfm_monitoring.h */
+void blfm_monitoring_queue_send(uint32_t queue_number, uint32_t waiting,
+                                uint32_t length);
+void blfm_monitoring_queue_full(uint32_t queue_number);
+
+/* RAM trace recorder, see blfm_trace.h */
+#if BLFM_ENABLED_TRACE
+#include "blfm_trace.h"
+#define BLFM_TRACE_HOOK(type, id, arg)                                         \
+  blfm_trace_record((type), (uint8_t)(id), (uint16_t)(arg))
+#else
+#define BLFM_TRACE_HOOK(type, id, arg)
+#endif
+
+#define BLFM_TRACE_HOOK_QUEUE(type, pxQueue)                                   \
+  BLFM_TRACE_HOOK((type), (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+
+#define traceTASK_SWITCHED_OUT()                                               \
+  BLFM_TRACE_HOOK(BLFM_TRACE_TASK_OUT, pxCurrentTCB->uxTaskNumber, 0)
+#define traceTASK_SWITCHED_IN()                                                \
+  do {                                                                         \
+    blfm_cpuload_task_switched_in(pxCurrentTCB->uxTaskNumber);                 \
+    BLFM_TRACE_HOOK(BLFM_TRACE_TASK_IN, pxCurrentTCB->uxTaskNumber, 0);        \
+  } while (0)
+
+#define traceQUEUE_SEND(pxQueue)                                               \
+  do {                                                                         \
+    blfm_monitoring_queue_send((pxQueue)->uxQueueNumber,                       \
+                               (pxQueue)->uxMessagesWaiting,                   \
+                               (pxQueue)->uxLength);                           \
+    BLFM_TRACE_HOOK_QUEUE(BLFM_TRACE_QUEUE_SEND, pxQueue);                     \
+  } while (0)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) traceQUEUE_SEND(pxQueue)
+#define traceQUEUE_RECEIVE(pxQueue)                                            \
+  BLFM_TRACE_HOOK_QUEUE(BLFM_TRACE_QUEUE_RECEIVE, pxQueue)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) traceQUEUE_RECEIVE(pxQueue)
+#define traceQUEUE_SEND_FAILED(pxQueue)                                        \
+  blfm_monitoring_queue_full((pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND_FROM_ISR_FAILED(pxQueue) traceQUEUE_SEND_FAILED(pxQueue)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue)                                   \
+  do {                                                                         \
+    blfm_monitoring_queue_full((pxQueue)->uxQueueNumber);                      \
+    BLFM_TRACE_HOOK_QUEUE(BLFM_TRACE_QUEUE_BLOCK_SEND, pxQueue);               \
+  } while (0)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue)                                \
+  BLFM_TRACE_HOOK_QUEUE(BLFM_TRACE_QUEUE_BLOCK_RECEIVE, pxQueue)
+
+#endif // BLFM_RTOS_HOOKS_H
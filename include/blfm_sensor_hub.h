@@ -13,10 +13,44 @@
 
 #include "FreeRTOS.h"
 #include "task.h"
+#include "blfm_config.h"
 #include "blfm_types.h"
 
+/*
+ * Latest-value blackboard. Each sensor publishes into its own field as soon
+ * as it has a reading, with a timestamp and a validity bit; a failing sensor
+ * only clears its own bit. Readers take a consistent snapshot through a
+ * sequence lock, so they never block and never see a half-written field.
+ */
+
 void blfm_sensor_hub_init();
-bool blfm_sensor_hub_read(blfm_sensor_data_t *out);
 
-#endif // BLFM_SENSOR_HUB_H
+/**
+ * Read one sensor inline and publish the result. Does nothing for disabled
+ * sensors and for the ultrasonic, which is measured by its own task.
+ */
+void blfm_sensor_hub_sample(blfm_sensor_id_t id);
+
+/**
+ * Sample every inline sensor once; the SensorHub loop when the cyclic
+ * executive is off.
+ */
+void blfm_sensor_hub_poll(void);
 
+void blfm_sensor_hub_publish(blfm_sensor_id_t id, const void *value);
+void blfm_sensor_hub_invalidate(blfm_sensor_id_t id);
+
+/**
+ * Copy the current blackboard. Constant time; retries only if a publish
+ * lands in the middle of the copy.
+ */
+void blfm_sensor_hub_snapshot(blfm_sensor_data_t *out);
+
+#if BLFM_ENABLED_ULTRASONIC
+/**
+ * Periodic ultrasonic measurement task, created from the task table.
+ */
+void blfm_sensor_hub_ultrasonic_task(void *pvParameters);
+#endif
+
+#endif // BLFM_SENSOR_HUB_H
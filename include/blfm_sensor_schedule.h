@@ -0,0 +1,54 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_SENSOR_SCHEDULE_H
+#define BLFM_SENSOR_SCHEDULE_H
+
+#include "blfm_config.h"
+
+#if BLFM_SENSOR_CYCLIC_EXEC
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Time-triggered cyclic executive for the sensors. TIM3 fires once per
+ * minor frame and the SensorHub task runs the slots due in that frame, from
+ * a schedule fixed at compile time by the BLFM_RATE_* settings. The major
+ * frame is one second, which every rate dividing the minor frame rate
+ * repeats in.
+ */
+
+#define BLFM_CE_MINOR_FRAME_US (1000000u / BLFM_CE_MINOR_FRAME_HZ)
+#define BLFM_CE_MAJOR_FRAME_MINORS BLFM_CE_MINOR_FRAME_HZ
+
+typedef struct {
+  uint32_t frames;       // Minor frames executed
+  uint32_t overruns;     // Minor frames lost because an earlier one ran late
+  uint16_t busy_us_last; // From the TIM3 update to the end of the frame
+  uint16_t busy_us_max;
+} blfm_sensor_schedule_stats_t;
+
+/**
+ * Start TIM3. Must be called from the task that runs the frames.
+ */
+void blfm_sensor_schedule_start(void);
+
+/**
+ * Wait for the next minor frame and run its slots. Returns true when the
+ * control slot was due and the controller should take a snapshot.
+ */
+bool blfm_sensor_schedule_run_frame(void);
+
+void blfm_sensor_schedule_get_stats(blfm_sensor_schedule_stats_t *out);
+
+#endif /* BLFM_SENSOR_CYCLIC_EXEC */
+
+#endif /* BLFM_SENSOR_SCHEDULE_H */
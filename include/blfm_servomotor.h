@@ -22,6 +22,11 @@ void blfm_servomotor_init(void);
 void blfm_servomotor_set_type(uint8_t servo_id, blfm_servo_type_t type);
 void blfm_servomotor_apply(uint8_t servo_id, const blfm_servomotor_command_t *cmd);
 
+/**
+ * PWM generation task, created from the task table with a 20ms period.
+ */
+void blfm_servomotor_pwm_task(void *pvParameters);
+
 #endif /* BLFM_ENABLED_SERVO */
 
 #endif /* BLFM_SERVOMOTOR_H */
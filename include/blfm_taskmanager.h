@@ -11,8 +11,67 @@
 #ifndef BLFM_TASKMANAGER_H
 #define BLFM_TASKMANAGER_H
 
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdint.h>
+
+/*
+ * Every task in the firmware. Rows for disabled modules stay in the enum so
+ * IDs are stable, but are never created.
+ */
+typedef enum {
+  BLFM_TASK_SENSOR_HUB = 0,
+  BLFM_TASK_CONTROLLER,
+  BLFM_TASK_ACTUATOR_HUB,
+  BLFM_TASK_LED,
+  BLFM_TASK_ULTRASONIC,
+  BLFM_TASK_SERVO_PWM,
+  BLFM_TASK_MONITORING,
+  BLFM_TASK_TRACE,
+  BLFM_TASK_IR_DECODE,
+  BLFM_TASK_RECORD,
+  BLFM_TASK_COUNT
+} blfm_task_id_t;
+
+typedef struct {
+  uint32_t cycles;          // Completed cycles
+  uint32_t deadline_misses; // Cycles that ended after release + deadline
+  uint32_t jitter_last;     // Ticks between release and start, last cycle
+  uint32_t jitter_max;
+  uint32_t response_last;   // Ticks between release and end, last cycle
+  uint32_t response_max;
+} blfm_task_timing_t;
+
 void blfm_taskmanager_setup(void);
 void blfm_taskmanager_start(void);
 
-#endif // BLFM_TASKMANAGER_H
+/**
+ * Handle of a created task, or NULL if it is disabled or not created yet.
+ */
+TaskHandle_t blfm_taskmanager_get_handle(blfm_task_id_t id);
+
+UBaseType_t blfm_taskmanager_get_priority(blfm_task_id_t id);
 
+/**
+ * Stack size in words, or 0 if the task is disabled or not created yet.
+ */
+uint16_t blfm_taskmanager_get_stack_words(blfm_task_id_t id);
+
+/**
+ * Per-cycle timing. A task calls cycle_begin with the tick its work was
+ * released at (the period boundary, or when its event was produced) and
+ * cycle_end once the work is done.
+ */
+void blfm_taskmanager_cycle_begin(blfm_task_id_t id, TickType_t release);
+void blfm_taskmanager_cycle_end(blfm_task_id_t id);
+
+/**
+ * For periodic tasks: close the current cycle, sleep until the next period
+ * boundary and open the next cycle. *release must start at the first
+ * release tick and is advanced by one period per call.
+ */
+void blfm_taskmanager_next_cycle(blfm_task_id_t id, TickType_t *release);
+
+void blfm_taskmanager_get_timing(blfm_task_id_t id, blfm_task_timing_t *out);
+
+#endif // BLFM_TASKMANAGER_H
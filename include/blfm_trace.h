@@ -0,0 +1,60 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_TRACE_H
+#define BLFM_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * RAM trace recorder. Kernel hooks and ISR brackets append 8-byte records
+ * stamped with DWT->CYCCNT to a ring buffer; the trace task drains it over
+ * USART1. When the ring is full new records are dropped and counted, so the
+ * recorder never waits on the UART.
+ *
+ * Wire format, little-endian, decoded by tools/trace/trace2json.py:
+ *   "BLTN" kind:u8 id:u8 len:u8 name[len]        one per task, queue, ISR
+ *   "BLTR" count:u16 dropped:u16 record[count]    record as blfm_trace_record_t
+ */
+
+typedef enum {
+  BLFM_TRACE_TASK_IN = 1,    // id: task number
+  BLFM_TRACE_TASK_OUT,       // id: task number
+  BLFM_TRACE_QUEUE_SEND,     // id: queue number, arg: items waiting before
+  BLFM_TRACE_QUEUE_RECEIVE,  // id: queue number, arg: items waiting before
+  BLFM_TRACE_QUEUE_BLOCK_SEND,
+  BLFM_TRACE_QUEUE_BLOCK_RECEIVE,
+  BLFM_TRACE_ISR_ENTER,      // id: blfm_isr_id_t
+  BLFM_TRACE_ISR_EXIT,
+  BLFM_TRACE_SLEEP,          // arg: ticks slept; CYCCNT stood still meanwhile
+} blfm_trace_type_t;
+
+// Name frame kinds
+#define BLFM_TRACE_NAME_TASK 0
+#define BLFM_TRACE_NAME_QUEUE 1
+#define BLFM_TRACE_NAME_ISR 2
+
+typedef struct {
+  uint32_t cycles;
+  uint8_t type;
+  uint8_t id;
+  uint16_t arg;
+} blfm_trace_record_t;
+
+/**
+ * Safe from any context, including the kernel's own critical sections.
+ */
+void blfm_trace_record(uint8_t type, uint8_t id, uint16_t arg);
+
+uint32_t blfm_trace_get_dropped(void);
+
+void blfm_trace_task(void *params);
+
+#endif // BLFM_TRACE_H
@@ -25,6 +25,28 @@
 #define BLFM_OLED_MAX_SMALL_TEXT_LEN 12
 #define BLFM_OLED_MAX_BIG_TEXT_LEN 16
 
+//==============================================================================
+// LATENCY
+//==============================================================================
+
+typedef struct {
+  uint32_t cycles; // DWT->CYCCNT
+  uint32_t tick;   // Covers time asleep, when CYCCNT stands still
+} blfm_stamp_t;
+
+// Follows one input from its ISR or sample through to the actuators
+typedef struct {
+  uint16_t id;         // 0 when the input is not tracked
+  uint8_t path;        // blfm_latency_path_t
+  blfm_stamp_t origin; // Edge or sample time
+} blfm_corr_t;
+
+typedef struct {
+  blfm_corr_t corr;
+  blfm_stamp_t dequeued;  // Controller picked the input up
+  blfm_stamp_t published; // Command handed to the actuator hub
+} blfm_latency_stamps_t;
+
 //==============================================================================
 // COMMUNICATION - ESP32
 //==============================================================================
@@ -106,14 +128,31 @@ typedef struct {
   uint32_t timestamp;        // Tick count at event
   uint32_t pulse_us;         // Raw IR code received
   blfm_ir_command_t command; // Decoded command
+  uint16_t address;          // Device address from the frame
+  uint8_t protocol;          // blfm_ir_protocol_t
+  bool repeat;               // Key held: repeat code or unchanged toggle
+  blfm_corr_t corr;          // Stamped at the edge that completed the frame
 } blfm_ir_remote_event_t;
 
 
+typedef enum {
+  BLFM_SENSOR_ULTRASONIC = 0,
+  BLFM_SENSOR_IMU,
+  BLFM_SENSOR_TEMPERATURE,
+  BLFM_SENSOR_POTENTIOMETER,
+  BLFM_SENSOR_COUNT
+} blfm_sensor_id_t;
+
+#define BLFM_SENSOR_BIT(id) (1u << (id))
+
 typedef struct {
   blfm_ultrasonic_data_t ultrasonic;
   blfm_imu_data_t imu;
   blfm_temperature_data_t temperature;
   blfm_potentiometer_data_t potentiometer;
+  uint8_t valid;                         // BLFM_SENSOR_BIT set per good field
+  uint32_t timestamp[BLFM_SENSOR_COUNT]; // Tick of each field's last update
+  blfm_corr_t corr;                      // Latest publish into the board
 } blfm_sensor_data_t;
 
 //==============================================================================
@@ -256,6 +295,7 @@ typedef struct {
   blfm_servomotor_command_t servo3;
   blfm_servomotor_command_t servo4;
   blfm_stepmotor_command_t stepmotor;
+  blfm_latency_stamps_t latency;
 } blfm_actuator_command_t;
 
 #endif // BLFM_TYPES_H
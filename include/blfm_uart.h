@@ -1,4 +1,3 @@
-
 /*
  * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
  *
@@ -13,9 +12,68 @@
 
 #include <stdint.h>
 
+/*
+ * USART1 transmit. With BLFM_UART_TX_DMA writes are copied into a RAM ring
+ * that DMA1 channel 4 drains in the background, so a writer never waits on
+ * the line; what happens to a write the ring has no room for is
+ * BLFM_UART_TX_OVERFLOW. Without it every byte waits for the transmitter.
+ * Receiving is separate, see blfm_uart_rx_start().
+ *
+ * Writes may come from tasks and ISRs. Each is copied in with interrupts
+ * masked, so bytes of two writes never interleave; keep them to a few
+ * hundred bytes.
+ */
+
+// BLFM_UART_TX_OVERFLOW policies
+#define BLFM_UART_OVERFLOW_DISCARD 0  // Drop the whole write
+#define BLFM_UART_OVERFLOW_TRUNCATE 1 // Queue what fits, drop the rest
+#define BLFM_UART_OVERFLOW_WAIT 2     // Wait for room; tasks only
+
+/**
+ * Runs in interrupt context, where FreeRTOS FromISR calls are allowed.
+ */
+typedef void (*blfm_uart_rx_callback_t)(const uint8_t *data, uint32_t len);
+
+typedef struct {
+  uint32_t bytes_sent;    // Handed to the transmitter
+  uint32_t bytes_dropped; // Lost to a full ring
+  uint32_t peak_backlog;  // Most bytes ever waiting in the ring
+  uint32_t overflows;     // Writes that found the ring full
+  uint32_t bytes_received;
+  uint32_t rx_errors;     // Overrun, noise and framing errors
+} blfm_uart_stats_t;
+
 void blfm_uart_init(void);
+
+/**
+ * Queue len bytes and return; the count queued is returned.
+ */
+uint32_t blfm_uart_write(const void *buf, uint32_t len);
+
+/**
+ * Room in the ring: a write of up to this many bytes is queued whole.
+ */
+uint32_t blfm_uart_tx_free(void);
+
+/**
+ * Single bytes wait for room whatever the overflow policy, for output that
+ * must arrive intact such as stream headers.
+ */
 void blfm_uart_send_u8(uint8_t val);
 void blfm_uart_send_u32(uint32_t val);
 
-#endif // BLFM_UART_H
+/**
+ * Wait until everything queued has left the transmitter.
+ */
+void blfm_uart_flush(void);
+
+/**
+ * Start receiving on PA10. DMA1 channel 5 fills a circular buffer of
+ * BLFM_UART_RX_DMA_BYTES; the callback gets what arrived as soon as the
+ * line goes idle after a burst, or half the buffer has filled.
+ */
+void blfm_uart_rx_start(blfm_uart_rx_callback_t callback);
 
+void blfm_uart_get_stats(blfm_uart_stats_t *out);
+
+#endif // BLFM_UART_H
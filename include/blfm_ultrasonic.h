@@ -18,8 +18,17 @@
 #include "blfm_types.h"
 #include <stdbool.h>
 
+// Task notification the echo interrupt gives; the measuring task must not
+// use it for anything else
+#define BLFM_ULTRASONIC_NOTIFY_INDEX 1
+
 void blfm_ultrasonic_init(void);
-bool blfm_ultrasonic_read(blfm_ultrasonic_data_t *data);
+
+/**
+ * Trigger one ping and time the echo from its EXTI edges. The calling task
+ * blocks, for up to 50 ms without an echo, rather than spinning.
+ */
+bool blfm_ultrasonic_measure(blfm_ultrasonic_data_t *data);
 
 #endif // BLFM_ULTRASONIC_H
 
@@ -3,10 +3,15 @@
 mkdir -p FreeRTOS/portable/GCC/ARM_CM3
 mkdir -p FreeRTOS/portable/MemMang
 mkdir -p FreeRTOS/include
+mkdir -p FreeRTOS/portable/ThirdParty/GCC/Posix/utils
 
 cp ~/Projects/FreeRTOS-Kernel/*.c                       FreeRTOS/
 cp ~/Projects/FreeRTOS-Kernel/include/*.h               FreeRTOS/include/
 cp ~/Projects/FreeRTOS-Kernel/portable/GCC/ARM_CM3/*    FreeRTOS/portable/GCC/ARM_CM3/
 cp ~/Projects/FreeRTOS-Kernel/portable/MemMang/heap_4.c FreeRTOS/portable/MemMang/heap_4.c
 
+# POSIX port for `make sim`
+cp ~/Projects/FreeRTOS-Kernel/portable/ThirdParty/GCC/Posix/*.[ch] FreeRTOS/portable/ThirdParty/GCC/Posix/
+cp ~/Projects/FreeRTOS-Kernel/portable/ThirdParty/GCC/Posix/utils/* FreeRTOS/portable/ThirdParty/GCC/Posix/utils/
+
 echo "FreeRTOS setup complete."
@@ -0,0 +1,77 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (C) 2025 Masoud Bolhassani
+#
+# Per-module RAM breakdown from a GNU ld map file.
+# Usage: scripts/ram_report.sh <map> [ram_bytes] [budget_bytes]
+
+MAP=$1
+RAM=${2:-20480}
+BUDGET=${3:-}
+
+if [ ! -f "$MAP" ]; then
+  echo "usage: $0 <map> [ram_bytes] [budget_bytes]" >&2
+  exit 1
+fi
+
+awk -v ram="$RAM" -v budget="$BUDGET" '
+function hex(s,    i, v) {
+  v = 0
+  s = tolower(substr(s, 3))
+  for (i = 1; i <= length(s); i++)
+    v = v * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+  return v
+}
+
+/^Linker script and memory map/ { inmap = 1; next }
+!inmap { next }
+
+# Long input section names put address, size and file on the next line
+/^ [.A-Z]/ && NF == 1 { pending = $1; next }
+
+{
+  if (pending != "") {
+    name = pending; size = $2; file = $3; pending = ""
+  } else if ($0 ~ /^ [.A-Z]/ && NF >= 4) {
+    name = $1; size = $3; file = $4
+  } else {
+    next
+  }
+  if (size !~ /^0x/ || (name !~ /^\.(data|bss)/ && name != "COMMON"))
+    next
+
+  bytes = hex(size)
+  if (bytes == 0)
+    next
+
+  if (name ~ /^\.bss\.blfm_rtos\./) {
+    module = substr(name, length(".bss.blfm_rtos.") + 1)
+    rtos[module] += bytes
+    rtos_total += bytes
+  }
+  object[file] += bytes
+  total += bytes
+}
+
+END {
+  if (rtos_total > 0) {
+    print "Kernel objects by module (tasks, queues, semaphores):"
+    for (m in rtos)
+      printf "  %-28s %6d\n", m, rtos[m] | "sort -k2 -nr"
+    close("sort -k2 -nr")
+    printf "  %-28s %6d\n\n", "total", rtos_total
+  }
+
+  print "Static RAM by object (.data + .bss):"
+  for (f in object)
+    printf "  %-48s %6d\n", f, object[f] | "sort -k2 -nr"
+  close("sort -k2 -nr")
+
+  printf "\nTotal: %d of %d bytes (%d left for the main stack)\n",
+         total, ram, ram - total
+  if (budget != "") {
+    printf "Budget: %d bytes, %s\n", budget,
+           total <= budget ? "ok" : "EXCEEDED"
+  }
+}
+' "$MAP"
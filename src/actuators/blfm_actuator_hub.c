@@ -39,9 +39,120 @@
 #endif
 
 #include "blfm_actuator_hub.h"
+#include "FreeRTOS.h"
+#include "blfm_cmd_pool.h"
+#include "blfm_latency.h"
 #include "blfm_types.h"
+#include "libc_stubs.h"
+#include "task.h"
+
+// Last state written to each actuator; only fields of valid entries count
+static blfm_actuator_command_t shadow;
+static bool shadow_valid[BLFM_ACTUATOR_COUNT];
+static blfm_actuator_update_stats_t update_stats[BLFM_ACTUATOR_COUNT];
+static blfm_actuator_hub_latency_t latency_stats;
+
+/* -------------------- Shadow comparison -------------------- */
+
+#if BLFM_ENABLED_DISPLAY || BLFM_ENABLED_OLED
+// Compares two NUL-terminated fields of at most len bytes
+static bool text_equal(const char *a, const char *b, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if (a[i] != b[i])
+      return false;
+    if (a[i] == '\0')
+      return true;
+  }
+  return true;
+}
+#endif
+
+#if BLFM_ENABLED_LED
+static bool led_equal(const blfm_led_command_t *a,
+                      const blfm_led_command_t *b) {
+  return a->mode == b->mode && a->blink_speed_ms == b->blink_speed_ms &&
+         a->pattern_id == b->pattern_id && a->brightness == b->brightness;
+}
+#endif
+
+#if BLFM_ENABLED_MOTOR
+static bool single_motor_equal(const blfm_single_motor_command_t *a,
+                               const blfm_single_motor_command_t *b) {
+  return a->speed == b->speed && a->direction == b->direction;
+}
+
+static bool motor_equal(const blfm_motor_command_t *a,
+                        const blfm_motor_command_t *b) {
+  return single_motor_equal(&a->left, &b->left) &&
+         single_motor_equal(&a->right, &b->right);
+}
+#endif
+
+#if BLFM_ENABLED_DISPLAY
+static bool display_equal(const blfm_display_command_t *a,
+                          const blfm_display_command_t *b) {
+  return text_equal(a->line1, b->line1, BLFM_DISPLAY_LINE_LENGTH) &&
+         text_equal(a->line2, b->line2, BLFM_DISPLAY_LINE_LENGTH);
+}
+#endif
+
+#if BLFM_ENABLED_OLED
+static bool oled_equal(const blfm_oled_command_t *a,
+                       const blfm_oled_command_t *b) {
+  return a->icon1 == b->icon1 && a->icon2 == b->icon2 &&
+         a->icon3 == b->icon3 && a->icon4 == b->icon4 &&
+         text_equal(a->smalltext1, b->smalltext1,
+                    BLFM_OLED_MAX_SMALL_TEXT_LEN) &&
+         text_equal(a->bigtext, b->bigtext, BLFM_OLED_MAX_BIG_TEXT_LEN) &&
+         text_equal(a->smalltext2, b->smalltext2,
+                    BLFM_OLED_MAX_SMALL_TEXT_LEN) &&
+         a->invert == b->invert && a->progress_percent == b->progress_percent;
+}
+#endif
+
+#if BLFM_ENABLED_SERVO
+static bool servo_equal(const blfm_servomotor_command_t *a,
+                        const blfm_servomotor_command_t *b) {
+  return a->angle == b->angle && a->pulse_width_us == b->pulse_width_us &&
+         a->scan_min_angle == b->scan_min_angle &&
+         a->scan_max_angle == b->scan_max_angle &&
+         a->scan_step == b->scan_step && a->scan_delay_ms == b->scan_delay_ms &&
+         a->target_x == b->target_x && a->target_y == b->target_y &&
+         a->tracking_speed == b->tracking_speed &&
+         a->proportional_input == b->proportional_input &&
+         a->deadband == b->deadband && a->travel_limit == b->travel_limit &&
+         a->speed == b->speed && a->enable_smooth == b->enable_smooth &&
+         a->reverse_direction == b->reverse_direction;
+}
+#endif
+
+#if BLFM_ENABLED_ALARM
+static bool alarm_equal(const blfm_alarm_command_t *a,
+                        const blfm_alarm_command_t *b) {
+  return a->active == b->active && a->pattern_id == b->pattern_id &&
+         a->duration_ms == b->duration_ms && a->volume == b->volume;
+}
+#endif
+
+
+// Decides whether an actuator must be written and updates its counters
+static bool needs_update(blfm_actuator_id_t id, bool unchanged) {
+  if (shadow_valid[id] && unchanged) {
+    update_stats[id].skipped++;
+    return false;
+  }
+  shadow_valid[id] = true;
+  update_stats[id].applied++;
+  return true;
+}
+
+/* -------------------- Public API -------------------- */
 
 void blfm_actuator_hub_init(void) {
+  blfm_actuator_hub_invalidate();
+  memset(update_stats, 0, sizeof(update_stats));
+  memset(&latency_stats, 0, sizeof(latency_stats));
+
 #if BLFM_ENABLED_LED
   blfm_led_init();
 #endif
@@ -89,42 +200,132 @@ void blfm_actuator_hub_apply(const blfm_actuator_command_t *cmd) {
     return;
 
 #if BLFM_ENABLED_LED
-  blfm_led_apply(&cmd->led);
+  if (needs_update(BLFM_ACTUATOR_LED, led_equal(&shadow.led, &cmd->led))) {
+    blfm_led_apply(&cmd->led);
+    shadow.led = cmd->led;
+  }
 #endif
 
 #if BLFM_ENABLED_MOTOR
-  blfm_motor_apply(&cmd->motor);
+  if (needs_update(BLFM_ACTUATOR_MOTOR,
+                   motor_equal(&shadow.motor, &cmd->motor))) {
+    blfm_motor_apply(&cmd->motor);
+    shadow.motor = cmd->motor;
+  }
 #endif
 
 #if BLFM_ENABLED_DISPLAY
-  blfm_display_apply(&cmd->display);
+  if (needs_update(BLFM_ACTUATOR_DISPLAY,
+                   display_equal(&shadow.display, &cmd->display))) {
+    blfm_display_apply(&cmd->display);
+    shadow.display = cmd->display;
+  }
 #endif
 
 #if BLFM_ENABLED_OLED
-  blfm_oled_apply(&cmd->oled);
+  if (needs_update(BLFM_ACTUATOR_OLED, oled_equal(&shadow.oled, &cmd->oled))) {
+    blfm_oled_apply(&cmd->oled);
+    shadow.oled = cmd->oled;
+  }
 #endif
 
 #if BLFM_ENABLED_SERVO
   // Apply commands to enabled servos only
 #if BLFM_ENABLED_SERVO1
-  blfm_servomotor_apply(0, &cmd->servo1);
+  if (needs_update(BLFM_ACTUATOR_SERVO1,
+                   servo_equal(&shadow.servo1, &cmd->servo1))) {
+    blfm_servomotor_apply(0, &cmd->servo1);
+    shadow.servo1 = cmd->servo1;
+  }
 #endif
 #if BLFM_ENABLED_SERVO2
-  blfm_servomotor_apply(1, &cmd->servo2);
+  if (needs_update(BLFM_ACTUATOR_SERVO2,
+                   servo_equal(&shadow.servo2, &cmd->servo2))) {
+    blfm_servomotor_apply(1, &cmd->servo2);
+    shadow.servo2 = cmd->servo2;
+  }
 #endif
 #if BLFM_ENABLED_SERVO3
-  blfm_servomotor_apply(2, &cmd->servo3);
+  if (needs_update(BLFM_ACTUATOR_SERVO3,
+                   servo_equal(&shadow.servo3, &cmd->servo3))) {
+    blfm_servomotor_apply(2, &cmd->servo3);
+    shadow.servo3 = cmd->servo3;
+  }
 #endif
 #if BLFM_ENABLED_SERVO4
-  blfm_servomotor_apply(3, &cmd->servo4);
+  if (needs_update(BLFM_ACTUATOR_SERVO4,
+                   servo_equal(&shadow.servo4, &cmd->servo4))) {
+    blfm_servomotor_apply(3, &cmd->servo4);
+    shadow.servo4 = cmd->servo4;
+  }
 #endif
 #endif
 
 #if BLFM_ENABLED_ALARM
-  blfm_alarm_apply(&cmd->alarm);
+  if (needs_update(BLFM_ACTUATOR_ALARM,
+                   alarm_equal(&shadow.alarm, &cmd->alarm))) {
+    blfm_alarm_apply(&cmd->alarm);
+    shadow.alarm = cmd->alarm;
+  }
 #endif
 
 #if BLFM_ENABLED_RADIO
-  blfm_radio_apply(&cmd->radio);
+  // Not state but a transmission: a repeated packet (heartbeat, retry) is
+  // sent again, so the radio never compares against its shadow
+  if (needs_update(BLFM_ACTUATOR_RADIO, false)) {
+    blfm_radio_apply(&cmd->radio);
+  }
 #endif
 }
+
+void blfm_actuator_hub_apply_handle(blfm_cmd_handle_t handle) {
+  const blfm_actuator_command_t *cmd = blfm_cmd_pool_get(handle);
+  if (!cmd)
+    return;
+
+  blfm_actuator_hub_apply(cmd);
+  blfm_latency_applied(cmd);
+
+  uint32_t latency = xTaskGetTickCount() - blfm_cmd_pool_get_timestamp(handle);
+  taskENTER_CRITICAL();
+  latency_stats.commands++;
+  latency_stats.latency_last = latency;
+  latency_stats.latency_total += latency;
+  if (latency > latency_stats.latency_max) {
+    latency_stats.latency_max = latency;
+  }
+  taskEXIT_CRITICAL();
+
+  // The hub owns the reference it received from the queue
+  blfm_cmd_pool_release(handle);
+}
+
+void blfm_actuator_hub_discard_handle(blfm_cmd_handle_t handle) {
+  latency_stats.conflated++;
+  blfm_cmd_pool_release(handle);
+}
+
+void blfm_actuator_hub_invalidate(void) {
+  for (int i = 0; i < BLFM_ACTUATOR_COUNT; i++) {
+    shadow_valid[i] = false;
+  }
+}
+
+void blfm_actuator_hub_get_stats(blfm_actuator_id_t id,
+                                 blfm_actuator_update_stats_t *out) {
+  if (!out || id >= BLFM_ACTUATOR_COUNT)
+    return;
+
+  taskENTER_CRITICAL();
+  *out = update_stats[id];
+  taskEXIT_CRITICAL();
+}
+
+void blfm_actuator_hub_get_latency(blfm_actuator_hub_latency_t *out) {
+  if (!out)
+    return;
+
+  taskENTER_CRITICAL();
+  *out = latency_stats;
+  taskEXIT_CRITICAL();
+}
@@ -19,20 +19,24 @@
 #include "stm32f1xx.h"
 #include "task.h"
 #include "blfm_pins.h"
+#include "blfm_rtos_alloc.h"
+#include "blfm_taskmanager.h"
 
-// Internal state for blinking
-#define LED_TASK_INTERVAL_MS 10
-
-#define LED_TASK_STACK_SIZE 256
-#define LED_TASK_PRIORITY 2
 #define LED_QUEUE_LENGTH 1
+// Shortest blink half-period, keeps a zero speed from spinning the task
+#define LED_MIN_BLINK_MS 10
 
 static void blfm_led_external_on(void);
 static void blfm_led_external_off(void);
-static void vLedTask(void *pvParameters);
+
+// A command with the tick it was applied at, the LED task's release
+typedef struct {
+  blfm_led_command_t cmd;
+  TickType_t applied;
+} led_request_t;
 
 static QueueHandle_t led_command_queue = NULL;
-static TaskHandle_t led_task_handle = NULL;
+BLFM_QUEUE_STORAGE(led, led_command, LED_QUEUE_LENGTH, sizeof(led_request_t));
 
 void blfm_led_init(void) {
   blfm_gpio_config_output((uint32_t)BLFM_LED_ONBOARD_PORT, BLFM_LED_ONBOARD_PIN);
@@ -41,23 +45,18 @@ void blfm_led_init(void) {
   //blfm_gpio_set_pin((uint32_t)BLFM_LED_DEBUG_PORT, BLFM_LED_DEBUG_PIN);
       
   if (led_command_queue == NULL) {
-    led_command_queue =
-        xQueueCreate(LED_QUEUE_LENGTH, sizeof(blfm_led_command_t));
+    led_command_queue = BLFM_QUEUE_CREATE(led_command, LED_QUEUE_LENGTH,
+                                          sizeof(led_request_t));
     configASSERT(led_command_queue != NULL);
   }
-
-  if (led_task_handle == NULL) {
-    BaseType_t result = xTaskCreate(vLedTask, "LEDTask", LED_TASK_STACK_SIZE,
-                                    NULL, LED_TASK_PRIORITY, &led_task_handle);
-    configASSERT(result == pdPASS);
-    if (result != pdPASS) {}
-  }
 }
 
 void blfm_led_apply(const blfm_led_command_t *cmd) {
   if (!cmd || !led_command_queue)
     return;
-  xQueueOverwrite(led_command_queue, cmd);
+
+  led_request_t request = {.cmd = *cmd, .applied = xTaskGetTickCount()};
+  xQueueOverwrite(led_command_queue, &request);
 }
 
 static void blfm_led_external_on(void) {
@@ -68,19 +67,33 @@ static void blfm_led_external_off(void) {
   blfm_gpio_clear_pin((uint32_t)BLFM_LED_EXTERNAL_PORT, BLFM_LED_EXTERNAL_PIN);
 }
 
-static void vLedTask(void *pvParameters) {
+void blfm_led_task(void *pvParameters) {
   (void)pvParameters;
   blfm_led_command_t current_cmd = {.mode = BLFM_LED_MODE_OFF,
 				    .blink_speed_ms = 200};
-  TickType_t last_toggle_tick = xTaskGetTickCount();
   bool led_state = false;
 
   for (;;) {
-    blfm_led_command_t received_cmd;
+    led_request_t received;
+    TickType_t wait = portMAX_DELAY;
+
+    // Only blinking needs a timeout; steady modes sleep until a new command
+    if (current_cmd.mode == BLFM_LED_MODE_BLINK) {
+      wait = pdMS_TO_TICKS(current_cmd.blink_speed_ms);
+      if (wait < pdMS_TO_TICKS(LED_MIN_BLINK_MS)) {
+        wait = pdMS_TO_TICKS(LED_MIN_BLINK_MS);
+      }
+    }
 
-    // Check for new command (non-blocking)
-    if (xQueueReceive(led_command_queue, &received_cmd, 0) == pdPASS) {
-      current_cmd = received_cmd;
+    // A toggle is released when the blink period ran out
+    TickType_t waited = xTaskGetTickCount();
+    bool updated =
+        xQueueReceive(led_command_queue, &received, wait) == pdPASS;
+    blfm_taskmanager_cycle_begin(BLFM_TASK_LED,
+                                 updated ? received.applied : waited + wait);
+
+    if (updated) {
+      current_cmd = received.cmd;
     }
 
     switch (current_cmd.mode) {
@@ -94,20 +107,17 @@ static void vLedTask(void *pvParameters) {
       led_state = true;
       break;
 
-    case BLFM_LED_MODE_BLINK: {
-      TickType_t now = xTaskGetTickCount();
-      if ((now - last_toggle_tick) >=
-          pdMS_TO_TICKS(current_cmd.blink_speed_ms)) {
+    case BLFM_LED_MODE_BLINK:
+      // Toggle when the blink period ran out, not on every new command
+      if (!updated) {
         led_state = !led_state;
         if (led_state) {
           blfm_led_external_on();
         } else {
           blfm_led_external_off();
         }
-        last_toggle_tick = now;
       }
       break;
-    }
 
     default:
       blfm_led_external_off();
@@ -115,7 +125,7 @@ static void vLedTask(void *pvParameters) {
       break;
     }
 
-    vTaskDelay(pdMS_TO_TICKS(10));
+    blfm_taskmanager_cycle_end(BLFM_TASK_LED);
   }
 }
 
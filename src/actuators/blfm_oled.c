@@ -20,6 +20,9 @@
 #define OLED_HEIGHT 32
 #define OLED_PAGES 4
 
+_Static_assert(BLFM_OLED_I2C_CHUNK > 0 && OLED_WIDTH % BLFM_OLED_I2C_CHUNK == 0,
+               "BLFM_OLED_I2C_CHUNK must divide the display width");
+
 // Simple framebuffer - one byte per column per page
 static uint8_t framebuffer[OLED_PAGES][OLED_WIDTH];
 static bool initialized = false;
@@ -27,13 +30,14 @@ static bool initialized = false;
 // Send command to OLED
 static void send_cmd(uint8_t cmd) {
     uint8_t data[2] = {0x00, cmd};
-    blfm_i2c1_write(OLED_ADDR, data, 2);
+    blfm_i2c1_client_write(BLFM_I2C1_CLIENT_OLED, OLED_ADDR, data, 2);
 }
 
-// Send data to OLED
-static void send_data(uint8_t data) {
-    uint8_t buffer[2] = {0x40, data};
-    blfm_i2c1_write(OLED_ADDR, buffer, 2);
+// Send a run of framebuffer bytes in one transaction
+static void send_data(const uint8_t *data, uint8_t len) {
+    uint8_t buffer[1 + BLFM_OLED_I2C_CHUNK] = {0x40};
+    memcpy(&buffer[1], data, len);
+    blfm_i2c1_client_write(BLFM_I2C1_CLIENT_OLED, OLED_ADDR, buffer, 1 + len);
 }
 
 void blfm_oled_init(void) {
@@ -88,9 +92,9 @@ void blfm_oled_flush(void) {
         send_cmd(0x00);         // Lower column start address
         send_cmd(0x10);         // Higher column start address
         
-        // Send page data
-        for (int x = 0; x < OLED_WIDTH; x++) {
-            send_data(framebuffer[page][x]);
+        // Send page data in chunks, so the bus is free between them
+        for (int x = 0; x < OLED_WIDTH; x += BLFM_OLED_I2C_CHUNK) {
+            send_data(&framebuffer[page][x], BLFM_OLED_I2C_CHUNK);
         }
     }
 }
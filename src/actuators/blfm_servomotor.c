@@ -12,6 +12,7 @@
 
 #include "blfm_servomotor.h"
 #include "blfm_pwm.h"
+#include "blfm_taskmanager.h"
 #include "FreeRTOS.h"
 #include "task.h"
 
@@ -54,29 +55,17 @@ static void process_proportional_servo(uint8_t servo_id, const blfm_servomotor_c
   blfm_pwm_set_pulse_us(servo_id, pulse_us);
 }
 
-// Simple delay function for PWM timing
-static void simple_delay_ms(uint32_t ms) {
-  for (uint32_t i = 0; i < ms; i++) {
-    for (volatile uint32_t j = 0; j < 8000; j++) {
-      // Simple busy wait - approximately 1ms at 72MHz
-    }
-  }
-}
-
-// Servo PWM task - continuously generates PWM cycles like working test
-static void servo_pwm_task(void *pvParameters) {
+// Servo PWM task - one pulse per 20ms period, sleeping in between
+void blfm_servomotor_pwm_task(void *pvParameters) {
   (void)pvParameters;
-  
+  TickType_t release = xTaskGetTickCount();
+
+  blfm_taskmanager_cycle_begin(BLFM_TASK_SERVO_PWM, release);
   while (1) {
     // Generate PWM pulse for all enabled channels
     blfm_pwm_generate_cycle();
-    
-    // Wait remaining time to complete 20ms period
-    // After longest pulse (2500us), wait ~17.5ms more
-    simple_delay_ms(17);
-    
-    // Give time for other tasks
-    vTaskDelay(pdMS_TO_TICKS(1));
+
+    blfm_taskmanager_next_cycle(BLFM_TASK_SERVO_PWM, &release);
   }
 }
 
@@ -88,9 +77,6 @@ void blfm_servomotor_init(void) {
     servo_states[i].type = BLFM_SERVO_TYPE_MANUAL;
     servo_states[i].reverse_direction = false;
   }
-  
-  // Create servo PWM task
-  xTaskCreate(servo_pwm_task, "ServoPWM", 128, NULL, 3, NULL);
 }
 
 void blfm_servomotor_set_type(uint8_t servo_id, blfm_servo_type_t type) {
@@ -17,7 +17,9 @@
  * scheduler.
  */
 
+#include "blfm_bench.h"
 #include "blfm_board.h"
+#include "blfm_config.h"
 #include "blfm_taskmanager.h"
 #include "blfm_gpio.h"
 #include "blfm_pins.h"
@@ -35,11 +37,16 @@ int main(void) {
   // Initialize system clocks, peripherals, and low-level hardware
   blfm_board_init();
 
+#if BLFM_ENABLED_BENCH
+  // Benchmark build: report the timings and stop
+  blfm_bench_run();
+#else
   // Set up all RTOS tasks and any necessary synchronization primitives
   blfm_taskmanager_setup();
 
   // Start the FreeRTOS scheduler (does not return)
   blfm_taskmanager_start();
+#endif
 
   // Fallback loop: should never reach here if RTOS is running
   while (1) {
@@ -2,53 +2,55 @@
 #include "blfm_config.h"
 #if BLFM_ENABLED_ESP32
 
-#include "blfm_esp32.h"
-#include "libc_stubs.h"
-
-static uint8_t rx_buffer[2];
-static uint8_t rx_index = 0;
-
-static volatile blfm_esp32_event_t pending_event;
-static volatile bool event_ready = false;
+#if BLFM_POWER_STOP_MODE
+#error "USART1 is unclocked in STOP mode; ESP32 commands would be lost"
+#endif
 
-void blfm_esp32_init(void) {
-  rx_index = 0;
-  event_ready = false;
-  memset((void *)&pending_event, 0, sizeof(pending_event));
+#include "blfm_esp32.h"
+#include "blfm_uart.h"
+#include "task.h"
+
+#define ESP32_FRAME_LEN 2
+
+static QueueHandle_t esp32_queue = NULL;
+// A frame split across two callbacks waits here for its second byte
+static uint8_t partial[ESP32_FRAME_LEN];
+static uint8_t partial_len;
+static volatile uint32_t rx_dropped;
+
+void blfm_esp32_init(QueueHandle_t controller_queue) {
+  esp32_queue = controller_queue;
+  partial_len = 0;
+  rx_dropped = 0;
+  blfm_uart_rx_start(blfm_esp32_receive);
 }
 
-void blfm_esp32_receive_byte(uint8_t byte) {
-  if (event_ready) {
-    // Drop bytes until app takes event
-    return;
+void blfm_esp32_receive(const uint8_t *data, uint32_t len) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  TickType_t now = xTaskGetTickCountFromISR();
+
+  for (uint32_t i = 0; i < len; i++) {
+    partial[partial_len++] = data[i];
+    if (partial_len < ESP32_FRAME_LEN)
+      continue;
+    partial_len = 0;
+
+    blfm_esp32_event_t event = {
+        .command = (blfm_esp32_command_type_t)partial[0],
+        .speed = partial[1],
+        .timestamp = now,
+    };
+    if (xQueueSendFromISR(esp32_queue, &event, &xHigherPriorityTaskWoken) !=
+        pdPASS) {
+      rx_dropped++;
+    }
   }
 
-  rx_buffer[rx_index++] = byte;
-
-  if (rx_index >= 2) {
-    // We have a full frame
-    pending_event.command = (blfm_esp32_command_type_t)rx_buffer[0];
-    pending_event.speed = rx_buffer[1];
-    // Optional timestamp (could use xTaskGetTickCount() if FreeRTOS used)
-    pending_event.timestamp = 0;
-
-    event_ready = true;
-    rx_index = 0;
-  }
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
-bool blfm_esp32_get_event(blfm_esp32_event_t *out_event) {
-  if (!event_ready) {
-    return false;
-  }
-
-  if (out_event != NULL) {
-    memcpy((void *)out_event, (const void *)&pending_event,
-           sizeof(blfm_esp32_event_t));
-  }
-
-  event_ready = false;
-  return true;
+uint32_t blfm_esp32_get_dropped(void) {
+  return rx_dropped;
 }
 
 #endif /* BLFM_ENABLED_ESP32 */
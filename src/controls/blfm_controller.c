@@ -11,6 +11,7 @@
 #include "FreeRTOS.h"
 #include "blfm_config.h"
 #include "blfm_gpio.h"
+#include "blfm_ir_decoder.h"
 #include "blfm_pins.h"
 #include "blfm_state.h"
 #include "blfm_types.h"
@@ -218,7 +219,10 @@ void blfm_controller_process(const blfm_sensor_data_t *in,
   //blfm_led_mode_t led_mode = BLFM_LED_MODE_BLINK;
 
 #if BLFM_ENABLED_ULTRASONIC
-  if (blfm_system_state.current_mode == BLFM_MODE_AUTO) {
+  bool have_distance = in->valid & BLFM_SENSOR_BIT(BLFM_SENSOR_ULTRASONIC);
+
+  // Without a fresh distance keep the last motion rather than guess
+  if (blfm_system_state.current_mode == BLFM_MODE_AUTO && have_distance) {
     switch (blfm_system_state.motion_state) {
     case BLFM_MOTION_STOP:
     case BLFM_MOTION_FORWARD:
@@ -258,7 +262,8 @@ void blfm_controller_process(const blfm_sensor_data_t *in,
 #endif /* BLFM_ENABLED_ULTRASONIC */
 
 #if BLFM_ENABLED_ALARM
-  if (in->ultrasonic.distance_mm < 100) {
+  if ((in->valid & BLFM_SENSOR_BIT(BLFM_SENSOR_ULTRASONIC)) &&
+      in->ultrasonic.distance_mm < 100) {
     out->alarm.active = true;
     out->alarm.pattern_id = 1;
     out->alarm.duration_ms = 500;
@@ -334,6 +339,10 @@ void blfm_controller_process_ir_remote(const blfm_ir_remote_event_t *in,
   if (!in || !out)
     return;
 
+  // The key map below is the rover's NEC remote; other remotes are ignored
+  if (in->protocol != BLFM_IR_PROTO_NEC)
+    return;
+
   int16_t speed = MOTOR_DEFAULT_SPEED;
 
   switch (in->command) {
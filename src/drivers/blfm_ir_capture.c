@@ -0,0 +1,111 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_config.h"
+#if BLFM_ENABLED_IR_REMOTE && BLFM_IR_TIMER_CAPTURE
+
+#include "blfm_ir_capture.h"
+#include "blfm_cpuload.h"
+#include "blfm_gpio.h"
+#include "blfm_pins.h"
+#include "stm32f1xx.h"
+#include "task.h"
+
+#if BLFM_POWER_STOP_MODE
+#error "TIM1 stops in STOP mode and cannot wake the core; use the EXTI backend"
+#endif
+
+_Static_assert(BLFM_IR_CAPTURE_WINDOW_COUNTS <= 0x10000,
+               "capture window too long for 16-bit TIM1");
+_Static_assert(BLFM_IR_CAPTURE_EDGES <= 0xFF, "edge counts are 8-bit");
+
+// Fixed request mapping: TIM1_CH1 on channel 2, TIM1_CH2 on channel 3
+#define RISE_DMA DMA1_Channel2
+#define FALL_DMA DMA1_Channel3
+
+// Highest priority allowed to call FreeRTOS from an ISR
+#define CAPTURE_IRQ_PRIORITY                                                   \
+  (configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - __NVIC_PRIO_BITS))
+
+static uint16_t rise_buffer[BLFM_IR_CAPTURE_EDGES];
+static uint16_t fall_buffer[BLFM_IR_CAPTURE_EDGES];
+static blfm_ir_capture_callback_t frame_callback = NULL;
+
+// A full buffer just stops the channel; later edges of that frame are lost
+static void dma_arm(DMA_Channel_TypeDef *channel, volatile uint32_t *source,
+                    uint16_t *buffer) {
+  channel->CCR = 0;
+  channel->CPAR = (uint32_t)source;
+  channel->CMAR = (uint32_t)buffer;
+  channel->CNDTR = BLFM_IR_CAPTURE_EDGES;
+  channel->CCR = DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0 |
+                 DMA_CCR_PL_0 | DMA_CCR_EN;
+}
+
+void blfm_ir_capture_init(blfm_ir_capture_callback_t callback) {
+  frame_callback = callback;
+
+  RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+  RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+  // Input capture only needs the pin as an input
+  blfm_gpio_config_input_pullup((uint32_t)BLFM_IR_REMOTE_PORT,
+                                BLFM_IR_REMOTE_PIN);
+
+  TIM1->CR1 = 0;
+  TIM1->PSC = 72 * BLFM_IR_CAPTURE_US_PER_COUNT - 1;
+  TIM1->ARR = BLFM_IR_CAPTURE_WINDOW_COUNTS - 1;
+
+  // IC1 and IC2 both map to TI1, filtered over 8 samples of the 72 MHz clock
+  TIM1->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_CC2S_1 | TIM_CCMR1_IC1F_0 |
+                TIM_CCMR1_IC1F_1;
+  TIM1->CCER = TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC2P;
+
+  // Any TI1 edge starts a stopped counter; a running one ignores it
+  TIM1->SMCR = TIM_SMCR_TS_2 | TIM_SMCR_SMS_2 | TIM_SMCR_SMS_1;
+
+  // Stop at the end of the window; only that overflow raises an update
+  TIM1->CR1 = TIM_CR1_OPM | TIM_CR1_URS;
+  TIM1->CNT = 0;
+  TIM1->EGR = TIM_EGR_UG; // Load PSC now
+  TIM1->SR = 0;
+
+  dma_arm(RISE_DMA, &TIM1->CCR1, rise_buffer);
+  dma_arm(FALL_DMA, &TIM1->CCR2, fall_buffer);
+  TIM1->DIER = TIM_DIER_UIE | TIM_DIER_CC1DE | TIM_DIER_CC2DE;
+
+  NVIC_SetPriority(TIM1_UP_IRQn, CAPTURE_IRQ_PRIORITY);
+  NVIC_EnableIRQ(TIM1_UP_IRQn);
+}
+
+void TIM1_UP_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_TIM1_UP);
+  TIM1->SR = ~TIM_SR_UIF;
+
+  blfm_ir_capture_frame_t frame = {
+      .rise = rise_buffer,
+      .fall = fall_buffer,
+      .rise_count = (uint8_t)(BLFM_IR_CAPTURE_EDGES - RISE_DMA->CNDTR),
+      .fall_count = (uint8_t)(BLFM_IR_CAPTURE_EDGES - FALL_DMA->CNDTR),
+      .end_cycles = DWT->CYCCNT,
+      .end_tick = xTaskGetTickCountFromISR(),
+  };
+  if (frame_callback) {
+    frame_callback(&frame);
+  }
+
+  // The counter is stopped until the next edge, so rewinding is safe
+  dma_arm(RISE_DMA, &TIM1->CCR1, rise_buffer);
+  dma_arm(FALL_DMA, &TIM1->CCR2, fall_buffer);
+
+  blfm_cpuload_isr_exit(BLFM_ISR_TIM1_UP, entered);
+}
+
+#endif /* BLFM_ENABLED_IR_REMOTE && BLFM_IR_TIMER_CAPTURE */
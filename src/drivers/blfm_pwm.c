@@ -9,9 +9,10 @@
 
 #include "blfm_pwm.h"
 #include "blfm_config.h"
-#include "stm32f1xx.h"
+#include "blfm_hal.h"
 #include "blfm_pins.h"
 #include "blfm_gpio.h"
+#include <stdbool.h>
 
 // Simple PWM using TIM4 - based on working test
 #define PWM_TIMER TIM4
@@ -62,8 +63,8 @@ static const gpio_pin_config_t channel_pins[BLFM_PWM_MAX_CHANNELS] = {
 
 void blfm_pwm_init(void) {
   // Enable clocks
-  RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;  // GPIOA for PA0-PA3
-  RCC->APB1ENR |= PWM_RCC_APB1ENR_MASK;   // TIM4 clock
+  BLFM_REG_SET(RCC, APB2ENR, RCC_APB2ENR_IOPAEN);  // GPIOA for PA0-PA3
+  BLFM_REG_SET(RCC, APB1ENR, PWM_RCC_APB1ENR_MASK);   // TIM4 clock
 
   // Configure GPIO pins as outputs for enabled channels only
   for (int i = 0; i < BLFM_PWM_MAX_CHANNELS; i++) {
@@ -74,11 +75,11 @@ void blfm_pwm_init(void) {
   }
 
   // Configure TIM4 for 1us resolution - same as working test
-  PWM_TIMER->CR1 = 0;  // Stop timer
-  PWM_TIMER->PSC = 71;  // 72MHz / 72 = 1MHz = 1us tick
-  PWM_TIMER->ARR = 0xFFFF;  // Max count for free running
-  PWM_TIMER->CNT = 0;
-  PWM_TIMER->CR1 |= TIM_CR1_CEN;  // Start timer
+  BLFM_REG_WRITE(PWM_TIMER, CR1, 0);  // Stop timer
+  BLFM_REG_WRITE(PWM_TIMER, PSC, 71);  // 72MHz / 72 = 1MHz = 1us tick
+  BLFM_REG_WRITE(PWM_TIMER, ARR, 0xFFFF);  // Max count for free running
+  BLFM_REG_WRITE(PWM_TIMER, CNT, 0);
+  BLFM_REG_SET(PWM_TIMER, CR1, TIM_CR1_CEN);  // Start timer
 }
 
 void blfm_pwm_set_pulse_us(uint8_t channel, uint16_t us) {
@@ -104,8 +105,8 @@ void blfm_pwm_generate_cycle(void) {
   for (uint8_t i = 0; i < BLFM_PWM_MAX_CHANNELS; i++) {
     if (channel_enabled[i]) {
       // Wait for this channel's pulse width using timer
-      uint16_t start = PWM_TIMER->CNT;
-      while ((uint16_t)(PWM_TIMER->CNT - start) < pulse_widths[i]);
+      uint16_t start = BLFM_REG_READ(PWM_TIMER, CNT);
+      while ((uint16_t)(BLFM_REG_READ(PWM_TIMER, CNT) - start) < pulse_widths[i]);
       
       blfm_gpio_clear_pin((uint32_t)channel_pins[i].port, channel_pins[i].pin);
     }
@@ -0,0 +1,439 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Interrupt and DMA driven I2C1 master. Transactions queue up in order;
+ * the event interrupt sends the START and the address, DMA1 channel 6
+ * feeds the bytes written and channel 7 takes the bytes read, and the
+ * submitting task is notified once the STOP is on its way. Transactions
+ * wait in client priority order, first come first served within one, and
+ * the wait of each is accounted to its client. A NACK ends the
+ * transaction with a STOP, a bus error or lost arbitration resets the
+ * peripheral, and a bus a slave holds low is clocked free before the next
+ * START.
+ */
+
+#include "blfm_config.h"
+#if BLFM_I2C1_ASYNC
+
+#include "blfm_i2c1.h"
+#include "FreeRTOS.h"
+#include "blfm_cpuload.h"
+#include "blfm_hal.h"
+#include "blfm_pins.h"
+#include "libc_stubs.h"
+#include "stm32f1xx.h"
+#include "task.h"
+
+_Static_assert(BLFM_I2C1_NOTIFY_INDEX < configTASK_NOTIFICATION_ARRAY_ENTRIES,
+               "the I2C1 notification slot is not configured");
+
+// I2C1_TX and I2C1_RX are wired to these channels only
+#define TX_DMA DMA1_Channel6
+#define RX_DMA DMA1_Channel7
+
+// Just below the capture ISRs; completions notify tasks, so not above
+#define IRQ_PRIORITY                                                           \
+  ((configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - __NVIC_PRIO_BITS)) + 1)
+
+#define CYCLES_PER_US (configCPU_CLOCK_HZ / 1000000U)
+// A STOP takes one SCL period at 100 kHz; give it ten
+#define STOP_WAIT_US 100U
+
+#define CR2_ENGINE                                                             \
+  (I2C_CR2_ITEVTEN | I2C_CR2_ITERREN | I2C_CR2_ITBUFEN | I2C_CR2_DMAEN |      \
+   I2C_CR2_LAST)
+#define SR1_ERRORS                                                             \
+  (I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | I2C_SR1_OVR |                    \
+   I2C_SR1_PECERR | I2C_SR1_TIMEOUT | I2C_SR1_SMBALERT)
+
+static const uint8_t priorities[BLFM_I2C1_CLIENT_COUNT] = {
+    [BLFM_I2C1_CLIENT_OTHER] = BLFM_I2C1_PRIO_OTHER,
+    [BLFM_I2C1_CLIENT_IMU] = BLFM_I2C1_PRIO_IMU,
+    [BLFM_I2C1_CLIENT_OLED] = BLFM_I2C1_PRIO_OLED,
+};
+
+static blfm_i2c1_xfer_t *active;
+static blfm_i2c1_xfer_t *head;
+static uint32_t queued;
+static bool reading; // Past the repeated START of the active transaction
+static bool ready;
+static blfm_i2c1_stats_t stats;
+static blfm_i2c1_client_stats_t client_stats[BLFM_I2C1_CLIENT_COUNT];
+
+/* -------------------- Bus -------------------- */
+
+static void delay_us(uint32_t us) {
+  uint32_t start = BLFM_REG_READ(DWT, CYCCNT);
+  while (BLFM_REG_READ(DWT, CYCCNT) - start < us * CYCLES_PER_US)
+    ;
+}
+
+static bool wait_idle(void) {
+  uint32_t start = BLFM_REG_READ(DWT, CYCCNT);
+  while ((BLFM_REG_READ(I2C1, CR1) & I2C_CR1_STOP) ||
+         (BLFM_REG_READ(I2C1, SR2) & I2C_SR2_BUSY)) {
+    if (BLFM_REG_READ(DWT, CYCCNT) - start > STOP_WAIT_US * CYCLES_PER_US)
+      return false;
+  }
+  return true;
+}
+
+// Nine clocks finish whatever byte a slave was sending, then a STOP
+static void bus_clear(void) {
+  const uint32_t scl = 1U << BLFM_I2C1_SCL_PIN;
+  const uint32_t sda = 1U << BLFM_I2C1_SDA_PIN;
+  const uint32_t pins =
+      (0xFU << (BLFM_I2C1_SCL_PIN * 4)) | (0xFU << (BLFM_I2C1_SDA_PIN * 4));
+  const uint32_t od_out = 0x77777777U & pins; // General purpose open-drain
+  const uint32_t od_af = 0xBBBBBBBBU & pins;  // Alternate open-drain
+
+  stats.recoveries++;
+  BLFM_REG_CLEAR(I2C1, CR1, I2C_CR1_PE);
+  BLFM_REG_WRITE(GPIOB, BSRR, scl | sda);
+  BLFM_REG_WRITE(GPIOB, CRL, (BLFM_REG_READ(GPIOB, CRL) & ~pins) | od_out);
+
+  for (uint8_t i = 0; i < 9 && !(BLFM_REG_READ(GPIOB, IDR) & sda); i++) {
+    BLFM_REG_WRITE(GPIOB, BRR, scl);
+    delay_us(5);
+    BLFM_REG_WRITE(GPIOB, BSRR, scl);
+    delay_us(5);
+  }
+
+  BLFM_REG_WRITE(GPIOB, BRR, scl);
+  delay_us(5);
+  BLFM_REG_WRITE(GPIOB, BRR, sda);
+  delay_us(5);
+  BLFM_REG_WRITE(GPIOB, BSRR, scl);
+  delay_us(5);
+  BLFM_REG_WRITE(GPIOB, BSRR, sda);
+  delay_us(5);
+
+  BLFM_REG_WRITE(GPIOB, CRL, (BLFM_REG_READ(GPIOB, CRL) & ~pins) | od_af);
+  blfm_i2c1_reset();
+}
+
+/* -------------------- Engine -------------------- */
+
+// Everything below runs in the engine's interrupts or in a critical section
+
+static void stop_hw(void) {
+  BLFM_REG_WRITE(TX_DMA, CCR, 0);
+  BLFM_REG_WRITE(RX_DMA, CCR, 0);
+  BLFM_REG_WRITE(DMA1, IFCR, DMA_IFCR_CGIF6 | DMA_IFCR_CGIF7);
+  BLFM_REG_CLEAR(I2C1, CR2, CR2_ENGINE);
+  BLFM_REG_SET(I2C1, CR1, I2C_CR1_ACK);
+}
+
+static void start_next(void) {
+  if (active || !head)
+    return;
+
+  active = head;
+  head = head->next;
+  queued--;
+
+  blfm_i2c1_client_stats_t *cs = &client_stats[active->client];
+  uint32_t waited =
+      (BLFM_REG_READ(DWT, CYCCNT) - active->queued_at) / CYCLES_PER_US;
+  cs->transfers++;
+  cs->wait_total_us += waited;
+  if (waited > cs->wait_max_us) {
+    cs->wait_max_us = waited;
+  }
+
+  // A reset or an abort may have left a slave holding SDA low
+  if (!wait_idle()) {
+    bus_clear();
+  }
+
+  reading = active->tx_len == 0;
+  BLFM_REG_SET(I2C1, CR2, I2C_CR2_ITEVTEN | I2C_CR2_ITERREN);
+  BLFM_REG_SET(I2C1, CR1, I2C_CR1_START);
+}
+
+// The STOP, if any, is already requested
+static void finish(int status, BaseType_t *woken) {
+  blfm_i2c1_xfer_t *xfer = active;
+
+  stop_hw();
+  active = NULL;
+  stats.transfers++;
+  if (status == BLFM_I2C1_ENACK) {
+    stats.nacks++;
+  } else if (status == BLFM_I2C1_EBUS) {
+    stats.bus_errors++;
+  }
+
+  xfer->status = status;
+  vTaskNotifyGiveIndexedFromISR((TaskHandle_t)xfer->task,
+                                BLFM_I2C1_NOTIFY_INDEX, woken);
+  start_next();
+}
+
+// ADDR is cleared by the SR2 read, after the DMA is ready for the data
+static void address_sent(blfm_i2c1_xfer_t *xfer) {
+  if (!reading) {
+    BLFM_REG_WRITE(TX_DMA, CMAR, BLFM_DMA_ADDR(xfer->tx));
+    BLFM_REG_WRITE(TX_DMA, CNDTR, xfer->tx_len);
+    BLFM_REG_WRITE(TX_DMA, CCR,
+                   DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_PL_0 |
+                       DMA_CCR_EN);
+    BLFM_REG_WRITE(I2C1, CR2,
+                   (BLFM_REG_READ(I2C1, CR2) & ~I2C_CR2_ITEVTEN) |
+                       I2C_CR2_DMAEN);
+    (void)BLFM_REG_READ(I2C1, SR2);
+  } else if (xfer->rx_len == 1) {
+    // Too short for the DMA: NACK it and ask for the STOP up front
+    BLFM_REG_CLEAR(I2C1, CR1, I2C_CR1_ACK);
+    (void)BLFM_REG_READ(I2C1, SR2);
+    BLFM_REG_SET(I2C1, CR1, I2C_CR1_STOP);
+    BLFM_REG_SET(I2C1, CR2, I2C_CR2_ITBUFEN);
+  } else {
+    // LAST has the peripheral NACK the final byte by itself
+    BLFM_REG_SET(I2C1, CR1, I2C_CR1_ACK);
+    BLFM_REG_WRITE(RX_DMA, CMAR, BLFM_DMA_ADDR(xfer->rx));
+    BLFM_REG_WRITE(RX_DMA, CNDTR, xfer->rx_len);
+    BLFM_REG_WRITE(RX_DMA, CCR,
+                   DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_PL_0 | DMA_CCR_EN);
+    BLFM_REG_WRITE(I2C1, CR2,
+                   (BLFM_REG_READ(I2C1, CR2) & ~I2C_CR2_ITEVTEN) |
+                       I2C_CR2_DMAEN | I2C_CR2_LAST);
+    (void)BLFM_REG_READ(I2C1, SR2);
+  }
+}
+
+void I2C1_EV_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_I2C1_EV);
+  BaseType_t woken = pdFALSE;
+  uint32_t sr1 = BLFM_REG_READ(I2C1, SR1);
+  blfm_i2c1_xfer_t *xfer = active;
+
+  if (!xfer) {
+    BLFM_REG_CLEAR(I2C1, CR2, I2C_CR2_ITEVTEN | I2C_CR2_ITBUFEN);
+  } else if (sr1 & I2C_SR1_SB) {
+    BLFM_REG_WRITE(I2C1, DR, (uint8_t)((xfer->addr << 1) | (reading ? 1 : 0)));
+  } else if (sr1 & I2C_SR1_ADDR) {
+    address_sent(xfer);
+  } else if ((sr1 & I2C_SR1_BTF) && !reading) {
+    // The last byte written has left; read, or end here
+    if (xfer->rx_len) {
+      reading = true;
+      BLFM_REG_SET(I2C1, CR1, I2C_CR1_START);
+    } else {
+      BLFM_REG_SET(I2C1, CR1, I2C_CR1_STOP);
+      finish(BLFM_I2C1_OK, &woken);
+    }
+  } else if (sr1 & I2C_SR1_RXNE) {
+    xfer->rx[0] = (uint8_t)BLFM_REG_READ(I2C1, DR);
+    finish(BLFM_I2C1_OK, &woken);
+  }
+
+  blfm_cpuload_isr_exit(BLFM_ISR_I2C1_EV, entered);
+  portYIELD_FROM_ISR(woken);
+}
+
+void I2C1_ER_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_I2C1_ER);
+  BaseType_t woken = pdFALSE;
+  uint32_t sr1 = BLFM_REG_READ(I2C1, SR1);
+
+  // The error flags clear on writing 0; the others are read-only
+  BLFM_REG_WRITE(I2C1, SR1, (uint16_t)~(sr1 & SR1_ERRORS));
+
+  if (active) {
+    if (sr1 & I2C_SR1_AF) {
+      BLFM_REG_SET(I2C1, CR1, I2C_CR1_STOP);
+      finish(BLFM_I2C1_ENACK, &woken);
+    } else if (sr1 & SR1_ERRORS) {
+      blfm_i2c1_reset();
+      finish(BLFM_I2C1_EBUS, &woken);
+    }
+  }
+
+  blfm_cpuload_isr_exit(BLFM_ISR_I2C1_ER, entered);
+  portYIELD_FROM_ISR(woken);
+}
+
+// All bytes are in DR; BTF says when the last has gone out
+void DMA1_Channel6_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_DMA1_CH6);
+
+  BLFM_REG_WRITE(DMA1, IFCR, DMA_IFCR_CGIF6);
+  BLFM_REG_WRITE(TX_DMA, CCR, 0);
+  if (active) {
+    BLFM_REG_WRITE(I2C1, CR2,
+                   (BLFM_REG_READ(I2C1, CR2) & ~I2C_CR2_DMAEN) |
+                       I2C_CR2_ITEVTEN);
+  }
+
+  blfm_cpuload_isr_exit(BLFM_ISR_DMA1_CH6, entered);
+}
+
+void DMA1_Channel7_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_DMA1_CH7);
+  BaseType_t woken = pdFALSE;
+
+  BLFM_REG_WRITE(DMA1, IFCR, DMA_IFCR_CGIF7);
+  if (active) {
+    BLFM_REG_SET(I2C1, CR1, I2C_CR1_STOP);
+    finish(BLFM_I2C1_OK, &woken);
+  }
+
+  blfm_cpuload_isr_exit(BLFM_ISR_DMA1_CH7, entered);
+  portYIELD_FROM_ISR(woken);
+}
+
+/* -------------------- Tasks -------------------- */
+
+static void abort_xfer(blfm_i2c1_xfer_t *xfer) {
+  taskENTER_CRITICAL();
+  if (xfer->status == BLFM_I2C1_PENDING) {
+    if (xfer == active) {
+      stop_hw();
+      BLFM_REG_SET(I2C1, CR1, I2C_CR1_STOP);
+      (void)wait_idle();
+      blfm_i2c1_reset();
+      active = NULL;
+    } else {
+      blfm_i2c1_xfer_t **link = &head;
+      while (*link != xfer) {
+        link = &(*link)->next;
+      }
+      *link = xfer->next;
+      queued--;
+    }
+    xfer->status = BLFM_I2C1_ETIMEOUT;
+    stats.transfers++;
+    stats.timeouts++;
+    start_next();
+  }
+  taskEXIT_CRITICAL();
+}
+
+int blfm_i2c1_submit(blfm_i2c1_xfer_t *xfer) {
+  if (!xfer || (xfer->tx_len == 0 && xfer->rx_len == 0) ||
+      (xfer->tx_len && !xfer->tx) || (xfer->rx_len && !xfer->rx) ||
+      xfer->tx_len > 0xFFFF || xfer->rx_len > 0xFFFF ||
+      xfer->client >= BLFM_I2C1_CLIENT_COUNT)
+    return BLFM_I2C1_EINVAL;
+
+  uint8_t priority = priorities[xfer->client];
+  xfer->task = xTaskGetCurrentTaskHandle();
+  xfer->status = BLFM_I2C1_PENDING;
+
+  taskENTER_CRITICAL();
+  xfer->queued_at = BLFM_REG_READ(DWT, CYCCNT);
+
+  // Behind everything of its own priority or above
+  blfm_i2c1_xfer_t **link = &head;
+  while (*link && priorities[(*link)->client] >= priority) {
+    link = &(*link)->next;
+  }
+  xfer->next = *link;
+  *link = xfer;
+  if (++queued > stats.peak_queue) {
+    stats.peak_queue = queued;
+  }
+  start_next();
+  taskEXIT_CRITICAL();
+  return BLFM_I2C1_OK;
+}
+
+int blfm_i2c1_wait(blfm_i2c1_xfer_t *xfer, uint32_t timeout_ms) {
+  // One more tick, or a wait could end at the very next tick interrupt
+  TickType_t limit = pdMS_TO_TICKS(timeout_ms) + 1;
+  TickType_t start = xTaskGetTickCount();
+
+  while (xfer->status == BLFM_I2C1_PENDING) {
+    TickType_t waited = xTaskGetTickCount() - start;
+    if (waited >= limit) {
+      abort_xfer(xfer);
+      break;
+    }
+    ulTaskNotifyTakeIndexed(BLFM_I2C1_NOTIFY_INDEX, pdTRUE, limit - waited);
+  }
+  return xfer->status;
+}
+
+int blfm_i2c1_transfer(blfm_i2c1_client_t client, uint8_t addr,
+                       const uint8_t *tx, size_t tx_len, uint8_t *rx,
+                       size_t rx_len) {
+  blfm_i2c1_xfer_t xfer = {.client = client,
+                           .addr = addr,
+                           .tx = tx,
+                           .tx_len = tx_len,
+                           .rx = rx,
+                           .rx_len = rx_len};
+
+  int rc = blfm_i2c1_submit(&xfer);
+  if (rc != BLFM_I2C1_OK)
+    return rc;
+
+  // About 11 bytes a millisecond at 100 kHz
+  return blfm_i2c1_wait(&xfer,
+                        BLFM_I2C1_TIMEOUT_MS + (tx_len + rx_len) / 10);
+}
+
+bool blfm_i2c1_busy(void) { return active != NULL || head != NULL; }
+
+bool blfm_i2c1_async_ready(void) {
+#if BLFM_HAL_HOST
+  // The bench plays the interrupts from its one thread
+  return ready;
+#else
+  return ready && __get_IPSR() == 0 && __get_PRIMASK() == 0 &&
+         xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+#endif
+}
+
+void blfm_i2c1_async_init(void) {
+  active = NULL;
+  head = NULL;
+  queued = 0;
+  memset(&stats, 0, sizeof(stats));
+  memset(client_stats, 0, sizeof(client_stats));
+
+  BLFM_REG_SET(CoreDebug, DEMCR, CoreDebug_DEMCR_TRCENA_Msk);
+  BLFM_REG_SET(DWT, CTRL, DWT_CTRL_CYCCNTENA_Msk);
+
+  BLFM_REG_SET(RCC, AHBENR, RCC_AHBENR_DMA1EN);
+  BLFM_REG_WRITE(TX_DMA, CCR, 0);
+  BLFM_REG_WRITE(TX_DMA, CPAR, (uint32_t)&I2C1->DR);
+  BLFM_REG_WRITE(RX_DMA, CCR, 0);
+  BLFM_REG_WRITE(RX_DMA, CPAR, (uint32_t)&I2C1->DR);
+
+  BLFM_IRQ_ENABLE(I2C1_EV_IRQn, IRQ_PRIORITY);
+  BLFM_IRQ_ENABLE(I2C1_ER_IRQn, IRQ_PRIORITY);
+  BLFM_IRQ_ENABLE(DMA1_Channel6_IRQn, IRQ_PRIORITY);
+  BLFM_IRQ_ENABLE(DMA1_Channel7_IRQn, IRQ_PRIORITY);
+
+  ready = true;
+}
+
+void blfm_i2c1_get_stats(blfm_i2c1_stats_t *out) {
+  if (!out)
+    return;
+
+  taskENTER_CRITICAL();
+  *out = stats;
+  taskEXIT_CRITICAL();
+}
+
+void blfm_i2c1_get_client_stats(blfm_i2c1_client_t client,
+                                blfm_i2c1_client_stats_t *out) {
+  if (!out || client >= BLFM_I2C1_CLIENT_COUNT)
+    return;
+
+  taskENTER_CRITICAL();
+  *out = client_stats[client];
+  taskEXIT_CRITICAL();
+}
+
+#endif /* BLFM_I2C1_ASYNC */
@@ -1,4 +1,3 @@
-
 /*
  * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
  *
@@ -9,7 +8,224 @@
  */
 
 #include "blfm_uart.h"
+#include "FreeRTOS.h"
+#include "blfm_config.h"
+#include "blfm_cpuload.h"
+#include "blfm_ringbuf.h"
+#include "libc_stubs.h"
 #include "stm32f1xx.h"
+#include <stdbool.h>
+
+// PCLK2, which clocks USART1; see blfm_clock.c
+#define USART1_CLOCK_HZ 72000000U
+
+_Static_assert(USART1_CLOCK_HZ / BLFM_UART_BAUD >= 16,
+               "BLFM_UART_BAUD above PCLK2 / 16");
+_Static_assert(BLFM_UART_RX_DMA_BYTES >= 2 && BLFM_UART_RX_DMA_BYTES <= 0xFFFF,
+               "BLFM_UART_RX_DMA_BYTES out of range");
+
+static blfm_uart_stats_t stats;
+
+#if BLFM_UART_TX_DMA
+
+_Static_assert((BLFM_UART_TX_RING_BYTES & (BLFM_UART_TX_RING_BYTES - 1)) == 0,
+               "BLFM_UART_TX_RING_BYTES must be a power of two");
+_Static_assert(BLFM_UART_TX_RING_BYTES <= 0x10000,
+               "a DMA transfer is at most 65535 bytes");
+
+// USART1_TX is wired to channel 4 only
+#define TX_DMA DMA1_Channel4
+
+// Below the capture ISRs; a late refill only leaves a gap on the line
+#define TX_DMA_IRQ_PRIORITY                                                    \
+  ((configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - __NVIC_PRIO_BITS)) + 2)
+
+static uint8_t tx_storage[BLFM_UART_TX_RING_BYTES];
+static blfm_ringbuf_t tx_ring;
+static uint32_t dma_len; // Bytes the running transfer covers, 0 when idle
+
+// Everything below runs with interrupts masked
+
+static void tx_start(void) {
+  const uint8_t *span;
+  uint32_t len = blfm_ringbuf_read_span(&tx_ring, &span);
+
+  dma_len = len;
+  if (len == 0)
+    return;
+
+  TX_DMA->CCR &= ~DMA_CCR_EN;
+  TX_DMA->CMAR = (uint32_t)span;
+  TX_DMA->CNDTR = len;
+  TX_DMA->CCR |= DMA_CCR_EN;
+}
+
+static void tx_complete(void) {
+  DMA1->IFCR = DMA_IFCR_CGIF4;
+  blfm_ringbuf_consume(&tx_ring, dma_len);
+  stats.bytes_sent += dma_len;
+  tx_start();
+}
+
+// A waiting writer may have the DMA interrupt masked, by PRIMASK or by the
+// kernel before the scheduler starts, so it completes transfers itself
+static void tx_poll(void) {
+  if (dma_len && (DMA1->ISR & DMA_ISR_TCIF4)) {
+    tx_complete();
+  }
+}
+
+static uint32_t tx_queue(const uint8_t *data, uint32_t len, bool whole) {
+  uint32_t room = blfm_ringbuf_free(&tx_ring);
+  if (len > room) {
+    stats.overflows++;
+    len = whole ? 0 : room;
+  }
+
+  blfm_ringbuf_push(&tx_ring, data, len);
+
+  uint32_t backlog = blfm_ringbuf_used(&tx_ring);
+  if (backlog > stats.peak_backlog) {
+    stats.peak_backlog = backlog;
+  }
+  if (dma_len == 0) {
+    tx_start();
+  }
+  return len;
+}
+
+static uint32_t tx_write(const uint8_t *data, uint32_t len, int policy) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  uint32_t queued =
+      tx_queue(data, len, policy == BLFM_UART_OVERFLOW_DISCARD);
+  while (policy == BLFM_UART_OVERFLOW_WAIT && queued < len) {
+    // Let other interrupts in while the line drains
+    __set_PRIMASK(primask);
+    __disable_irq();
+    tx_poll();
+    queued += tx_queue(data + queued, len - queued, false);
+  }
+  stats.bytes_dropped += len - queued;
+
+  __set_PRIMASK(primask);
+  return queued;
+}
+
+void DMA1_Channel4_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_DMA1_CH4);
+
+  // Writers at a higher priority may be queueing
+  __disable_irq();
+  tx_poll();
+  __enable_irq();
+
+  blfm_cpuload_isr_exit(BLFM_ISR_DMA1_CH4, entered);
+}
+
+#else
+
+static uint32_t tx_write(const uint8_t *data, uint32_t len, int policy) {
+  (void)policy;
+  for (uint32_t i = 0; i < len; i++) {
+    while (!(USART1->SR & USART_SR_TXE))
+      ;
+    USART1->DR = data[i];
+  }
+  stats.bytes_sent += len;
+  return len;
+}
+
+#endif /* BLFM_UART_TX_DMA */
+
+/* -------------------- Receive -------------------- */
+
+// USART1_RX is wired to channel 5 only
+#define RX_DMA DMA1_Channel5
+
+// Highest priority allowed to call FreeRTOS, which the callback may do
+#define RX_IRQ_PRIORITY                                                        \
+  (configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - __NVIC_PRIO_BITS))
+
+#define RX_ERRORS (USART_SR_ORE | USART_SR_NE | USART_SR_FE)
+
+static uint8_t rx_buffer[BLFM_UART_RX_DMA_BYTES];
+static uint32_t rx_pos; // Next byte to hand over
+static blfm_uart_rx_callback_t rx_callback;
+
+static void rx_hand_over(uint32_t from, uint32_t to) {
+  stats.bytes_received += to - from;
+  if (rx_callback) {
+    rx_callback(&rx_buffer[from], to - from);
+  }
+}
+
+// Both receive interrupts share a priority, so neither runs inside the other
+static void rx_deliver(void) {
+  uint32_t head = BLFM_UART_RX_DMA_BYTES - RX_DMA->CNDTR;
+  if (head >= BLFM_UART_RX_DMA_BYTES) {
+    head = 0;
+  }
+
+  if (head < rx_pos) {
+    rx_hand_over(rx_pos, BLFM_UART_RX_DMA_BYTES);
+    rx_pos = 0;
+  }
+  if (head > rx_pos) {
+    rx_hand_over(rx_pos, head);
+  }
+  rx_pos = head;
+}
+
+void USART1_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_USART1);
+
+  // SR then DR clears IDLE and the errors; the DMA has the data already
+  uint32_t sr = USART1->SR;
+  if (sr & (USART_SR_IDLE | RX_ERRORS)) {
+    (void)USART1->DR;
+    if (sr & RX_ERRORS) {
+      stats.rx_errors++;
+    }
+    rx_deliver();
+  }
+
+  blfm_cpuload_isr_exit(BLFM_ISR_USART1, entered);
+}
+
+// Half and full buffer: hand over before the DMA comes round again
+void DMA1_Channel5_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_DMA1_CH5);
+  DMA1->IFCR = DMA_IFCR_CGIF5;
+  rx_deliver();
+  blfm_cpuload_isr_exit(BLFM_ISR_DMA1_CH5, entered);
+}
+
+void blfm_uart_rx_start(blfm_uart_rx_callback_t callback) {
+  rx_callback = callback;
+  rx_pos = 0;
+
+  // PA10 (RX) as input with pull-up, so an unplugged link reads idle
+  GPIOA->CRH = (GPIOA->CRH & ~(0xF << 8)) | (0x8 << 8);
+  GPIOA->ODR |= 1 << 10;
+
+  RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+  RX_DMA->CCR = 0;
+  RX_DMA->CPAR = (uint32_t)&USART1->DR;
+  RX_DMA->CMAR = (uint32_t)rx_buffer;
+  RX_DMA->CNDTR = sizeof(rx_buffer);
+  RX_DMA->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_HTIE | DMA_CCR_TCIE |
+                DMA_CCR_PL_1 | DMA_CCR_EN;
+
+  NVIC_SetPriority(DMA1_Channel5_IRQn, RX_IRQ_PRIORITY);
+  NVIC_SetPriority(USART1_IRQn, RX_IRQ_PRIORITY);
+  NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+  NVIC_EnableIRQ(USART1_IRQn);
+
+  USART1->CR3 |= USART_CR3_DMAR | USART_CR3_EIE;
+  USART1->CR1 |= USART_CR1_RE | USART_CR1_IDLEIE;
+}
 
 void blfm_uart_init(void) {
   // Enable GPIOA and USART1
@@ -19,22 +235,74 @@ void blfm_uart_init(void) {
   GPIOA->CRH &= ~(0xF << 4);       // Clear PA9 bits
   GPIOA->CRH |=  (0xB << 4);       // CNF=10 (AF Push-Pull), MODE=11 (50 MHz)
 
-  // Set baud rate for 72 MHz system clock and 115200 bps: 72e6 / 115200 ≈ 625
-  USART1->BRR = 625;
+  // 16x oversampling; the rounded divider is within 0.2% up to 2 Mbaud
+  USART1->BRR = (USART1_CLOCK_HZ + BLFM_UART_BAUD / 2) / BLFM_UART_BAUD;
+
+  memset(&stats, 0, sizeof(stats));
+
+#if BLFM_UART_TX_DMA
+  (void)blfm_ringbuf_init(&tx_ring, tx_storage, sizeof(tx_storage));
+  dma_len = 0;
+
+  RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+  TX_DMA->CCR = 0;
+  TX_DMA->CPAR = (uint32_t)&USART1->DR;
+  TX_DMA->CCR = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_TCIE;
+  USART1->CR3 = USART_CR3_DMAT;
+
+  NVIC_SetPriority(DMA1_Channel4_IRQn, TX_DMA_IRQ_PRIORITY);
+  NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+#endif
 
   // Enable TX and USART
   USART1->CR1 = USART_CR1_TE | USART_CR1_UE;
 }
 
+uint32_t blfm_uart_write(const void *buf, uint32_t len) {
+  if (!buf || len == 0)
+    return 0;
+  return tx_write((const uint8_t *)buf, len, BLFM_UART_TX_OVERFLOW);
+}
+
+uint32_t blfm_uart_tx_free(void) {
+#if BLFM_UART_TX_DMA
+  return blfm_ringbuf_free(&tx_ring);
+#else
+  return UINT32_MAX;
+#endif
+}
+
 void blfm_uart_send_u8(uint8_t val) {
-  while (!(USART1->SR & USART_SR_TXE));
-  USART1->DR = val;
+  tx_write(&val, 1, BLFM_UART_OVERFLOW_WAIT);
 }
 
 void blfm_uart_send_u32(uint32_t val) {
-  blfm_uart_send_u8((val >> 24) & 0xFF);
-  blfm_uart_send_u8((val >> 16) & 0xFF);
-  blfm_uart_send_u8((val >> 8) & 0xFF);
-  blfm_uart_send_u8(val & 0xFF);
+  uint8_t buf[4] = {(uint8_t)(val >> 24), (uint8_t)(val >> 16),
+                    (uint8_t)(val >> 8), (uint8_t)val};
+  tx_write(buf, sizeof(buf), BLFM_UART_OVERFLOW_WAIT);
 }
 
+void blfm_uart_flush(void) {
+#if BLFM_UART_TX_DMA
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  while (dma_len) {
+    tx_poll();
+    __set_PRIMASK(primask);
+    __disable_irq();
+  }
+  __set_PRIMASK(primask);
+#endif
+  while (!(USART1->SR & USART_SR_TC))
+    ;
+}
+
+void blfm_uart_get_stats(blfm_uart_stats_t *out) {
+  if (!out)
+    return;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  *out = stats;
+  __set_PRIMASK(primask);
+}
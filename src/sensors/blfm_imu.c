@@ -10,6 +10,9 @@
 
 /* MPU-6050 */
 
+#include "blfm_config.h"
+#if BLFM_ENABLED_IMU
+
 #include "blfm_imu.h"
 #include "blfm_i2c1.h"
 
@@ -18,14 +21,17 @@
 #define MPU6050_REG_ACCEL_X   0x3B
 
 void blfm_imu_init(void) {
-  blfm_i2c1_write_byte(MPU6050_ADDR, MPU6050_REG_PWR_MGMT, 0x00);
+  uint8_t wake[2] = {MPU6050_REG_PWR_MGMT, 0x00};
+  blfm_i2c1_client_write(BLFM_I2C1_CLIENT_IMU, MPU6050_ADDR, wake, 2);
 }
 
 bool blfm_imu_read(blfm_imu_data_t *data) {
   if (!data) return false;
 
   uint8_t raw[14];
-  blfm_i2c1_read_bytes(MPU6050_ADDR, MPU6050_REG_ACCEL_X, raw, 14);
+  if (blfm_i2c1_client_read_bytes(BLFM_I2C1_CLIENT_IMU, MPU6050_ADDR,
+                                  MPU6050_REG_ACCEL_X, raw, 14) != 0)
+    return false;
 
   data->acc_x = (int16_t)(raw[0] << 8 | raw[1]);
   data->acc_y = (int16_t)(raw[2] << 8 | raw[3]);
@@ -37,3 +43,5 @@ bool blfm_imu_read(blfm_imu_data_t *data) {
 
   return true;
 }
+
+#endif /* BLFM_ENABLED_IMU */
@@ -0,0 +1,470 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_config.h"
+#if BLFM_ENABLED_IR_REMOTE
+
+#include "blfm_ir_decoder.h"
+#include "libc_stubs.h"
+
+// Receivers stretch marks and shrink spaces by up to ~100 us
+#define TOLERANCE_PERCENT 30
+#define BIPHASE_TOLERANCE_PERCENT 35
+// A space this long ends any frame
+#define GAP_US 5000
+#define MAX_PULSE_US 0xFFFF
+#define NO_BIT 0xFF
+
+typedef enum { ENC_PULSE_DISTANCE, ENC_PULSE_WIDTH, ENC_BIPHASE } encoding_t;
+
+typedef enum {
+  CHECK_NONE,
+  CHECK_INVERTED_CMD, // The field after the command is its complement
+  CHECK_LEADING_ONE   // The first bit received is a 1 (RC6 start bit)
+} check_t;
+
+typedef enum {
+  ST_IDLE,
+  ST_HDR_SPACE,
+  ST_BIT_MARK,
+  ST_BIT_SPACE,
+  ST_HALVES // Bi-phase: collecting half-bits
+} state_t;
+
+typedef struct {
+  const char *name;
+  uint8_t encoding;
+  uint8_t check;
+  uint8_t bits_min;
+  uint8_t bits_max;
+  uint32_t lengths;      // Allowed frame lengths as bit flags, 0 for any
+  uint16_t hdr_mark;     // 0 when the frame has no header
+  uint16_t hdr_space;
+  uint16_t repeat_space; // Header mark plus this space replays the last frame
+  uint16_t zero_mark;
+  uint16_t zero_space;
+  uint16_t one_mark;
+  uint16_t one_space;
+  uint16_t unit;         // Bi-phase half-bit
+  uint8_t one_first;     // Bi-phase: first-half level of a 1, 1 = mark
+  uint8_t lead_half;     // Bi-phase: the first half-bit is an unseen space
+  uint8_t wide_bit;      // Bi-phase: bit with double-width halves
+  uint8_t msb_first;
+  uint8_t addr_shift;
+  uint8_t addr_bits;     // 0: the rest of the frame
+  uint8_t cmd_shift;
+  uint8_t cmd_bits;
+  uint8_t toggle_shift;
+} protocol_def_t;
+
+static const protocol_def_t protocols[BLFM_IR_PROTO_COUNT] = {
+    [BLFM_IR_PROTO_NEC] = {.name = "NEC",
+                           .encoding = ENC_PULSE_DISTANCE,
+                           .check = CHECK_INVERTED_CMD,
+                           .bits_min = 32,
+                           .bits_max = 32,
+                           .hdr_mark = 9000,
+                           .hdr_space = 4500,
+                           .repeat_space = 2250,
+                           .zero_mark = 560,
+                           .zero_space = 560,
+                           .one_mark = 560,
+                           .one_space = 1690,
+                           .wide_bit = NO_BIT,
+                           .addr_shift = 0,
+                           .addr_bits = 16,
+                           .cmd_shift = 16,
+                           .cmd_bits = 8,
+                           .toggle_shift = NO_BIT},
+    [BLFM_IR_PROTO_SAMSUNG] = {.name = "Samsung",
+                               .encoding = ENC_PULSE_DISTANCE,
+                               .check = CHECK_INVERTED_CMD,
+                               .bits_min = 32,
+                               .bits_max = 32,
+                               .hdr_mark = 4500,
+                               .hdr_space = 4500,
+                               .zero_mark = 560,
+                               .zero_space = 560,
+                               .one_mark = 560,
+                               .one_space = 1690,
+                               .wide_bit = NO_BIT,
+                               .addr_shift = 0,
+                               .addr_bits = 16,
+                               .cmd_shift = 16,
+                               .cmd_bits = 8,
+                               .toggle_shift = NO_BIT},
+    [BLFM_IR_PROTO_SONY] = {.name = "Sony",
+                            .encoding = ENC_PULSE_WIDTH,
+                            .check = CHECK_NONE,
+                            .bits_min = 12,
+                            .bits_max = 20,
+                            .lengths = (1UL << 12) | (1UL << 15) | (1UL << 20),
+                            .hdr_mark = 2400,
+                            .hdr_space = 600,
+                            .zero_mark = 600,
+                            .zero_space = 600,
+                            .one_mark = 1200,
+                            .one_space = 600,
+                            .wide_bit = NO_BIT,
+                            .addr_shift = 7,
+                            .addr_bits = 0,
+                            .cmd_shift = 0,
+                            .cmd_bits = 7,
+                            .toggle_shift = NO_BIT},
+    [BLFM_IR_PROTO_RC5] = {.name = "RC5",
+                           .encoding = ENC_BIPHASE,
+                           .check = CHECK_NONE,
+                           .bits_min = 14,
+                           .bits_max = 14,
+                           .unit = 889,
+                           .one_first = 0,
+                           .lead_half = 1,
+                           .wide_bit = NO_BIT,
+                           .msb_first = 1,
+                           .addr_shift = 6,
+                           .addr_bits = 5,
+                           .cmd_shift = 0,
+                           .cmd_bits = 6,
+                           .toggle_shift = 11},
+    // Mode 0: start, 3 mode bits, the double-width toggle, 8 + 8 bits
+    [BLFM_IR_PROTO_RC6] = {.name = "RC6",
+                           .encoding = ENC_BIPHASE,
+                           .check = CHECK_LEADING_ONE,
+                           .bits_min = 21,
+                           .bits_max = 21,
+                           .hdr_mark = 2666,
+                           .hdr_space = 889,
+                           .unit = 444,
+                           .one_first = 1,
+                           .lead_half = 0,
+                           .wide_bit = 4,
+                           .msb_first = 1,
+                           .addr_shift = 8,
+                           .addr_bits = 8,
+                           .cmd_shift = 0,
+                           .cmd_bits = 8,
+                           .toggle_shift = 16},
+};
+
+static bool near(uint32_t d, uint16_t expected) {
+  if (expected == 0)
+    return false;
+  uint32_t slack = (uint32_t)expected * TOLERANCE_PERCENT / 100;
+  return d + slack >= expected && d <= expected + slack;
+}
+
+// Whole half-bit units in d, or 0 if d is not close to a multiple
+static uint8_t to_units(uint32_t d, uint16_t unit) {
+  uint32_t n = (d + unit / 2) / unit;
+  if (n == 0 || n > 4)
+    return 0;
+
+  uint32_t expected = n * unit;
+  uint32_t slack = (uint32_t)unit * BIPHASE_TOLERANCE_PERCENT / 100;
+  if (d + slack < expected || d > expected + slack)
+    return 0;
+  return (uint8_t)n;
+}
+
+static uint32_t field(uint32_t raw, uint8_t shift, uint8_t bits) {
+  raw >>= shift;
+  return bits >= 32 ? raw : raw & ((1UL << bits) - 1);
+}
+
+static void restart(blfm_ir_proto_state_t *st) {
+  st->state = ST_IDLE;
+  st->count = 0;
+  st->data = 0;
+}
+
+static void shift_in(const protocol_def_t *def, blfm_ir_proto_state_t *st,
+                     uint8_t bit) {
+  if (def->msb_first) {
+    st->data = (st->data << 1) | bit;
+  } else {
+    st->data |= (uint32_t)bit << st->count;
+  }
+  st->count++;
+}
+
+static bool emit(blfm_ir_decoder_t *dec, uint8_t id, uint8_t bits,
+                 blfm_ir_frame_t *out) {
+  const protocol_def_t *def = &protocols[id];
+  blfm_ir_proto_state_t *st = &dec->proto[id];
+  uint32_t raw = st->data;
+  restart(st);
+
+  if (def->lengths && !(def->lengths & (1UL << bits)))
+    return false;
+
+  uint8_t addr_bits = def->addr_bits ? def->addr_bits : bits - def->addr_shift;
+  blfm_ir_frame_t frame = {
+      .protocol = id,
+      .bits = bits,
+      .repeat = false,
+      .address = (uint16_t)field(raw, def->addr_shift, addr_bits),
+      .command = (uint16_t)field(raw, def->cmd_shift, def->cmd_bits),
+      .raw = raw,
+  };
+
+  switch (def->check) {
+  case CHECK_INVERTED_CMD: {
+    uint32_t inverse = field(raw, def->cmd_shift + def->cmd_bits, def->cmd_bits);
+    if ((inverse ^ frame.command) != (1UL << def->cmd_bits) - 1)
+      return false;
+    break;
+  }
+  case CHECK_LEADING_ONE:
+    if (!((raw >> (bits - 1)) & 1))
+      return false;
+    break;
+  default:
+    break;
+  }
+
+  if (def->toggle_shift != NO_BIT) {
+    uint8_t toggle = (raw >> def->toggle_shift) & 1;
+    frame.repeat = toggle == st->toggle;
+    st->toggle = toggle;
+  }
+
+  *out = frame;
+  dec->last = frame;
+  dec->has_last = true;
+  return true;
+}
+
+/* -------------------- Encodings -------------------- */
+
+static bool feed_pulse_distance(blfm_ir_decoder_t *dec, uint8_t id,
+                                uint32_t d, bool is_mark,
+                                blfm_ir_frame_t *out) {
+  const protocol_def_t *def = &protocols[id];
+  blfm_ir_proto_state_t *st = &dec->proto[id];
+
+  switch (st->state) {
+  case ST_HDR_SPACE:
+    if (is_mark)
+      break;
+    if (near(d, def->hdr_space)) {
+      st->state = ST_BIT_MARK;
+      return false;
+    }
+    if (near(d, def->repeat_space) && dec->has_last &&
+        dec->last.protocol == id) {
+      restart(st);
+      *out = dec->last;
+      out->repeat = true;
+      return true;
+    }
+    break;
+
+  case ST_BIT_MARK:
+    if (is_mark && near(d, def->zero_mark)) {
+      st->state = ST_BIT_SPACE;
+      return false;
+    }
+    break;
+
+  case ST_BIT_SPACE:
+    if (!is_mark && (near(d, def->one_space) || near(d, def->zero_space))) {
+      shift_in(def, st, near(d, def->one_space));
+      if (st->count == def->bits_max)
+        return emit(dec, id, st->count, out);
+      st->state = ST_BIT_MARK;
+      return false;
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  // Out of step: start over; the pulse may itself open a frame
+  restart(st);
+  if (is_mark && near(d, def->hdr_mark)) {
+    st->state = ST_HDR_SPACE;
+  }
+  return false;
+}
+
+static bool feed_pulse_width(blfm_ir_decoder_t *dec, uint8_t id, uint32_t d,
+                             bool is_mark, blfm_ir_frame_t *out) {
+  const protocol_def_t *def = &protocols[id];
+  blfm_ir_proto_state_t *st = &dec->proto[id];
+
+  switch (st->state) {
+  case ST_HDR_SPACE:
+    if (!is_mark && near(d, def->hdr_space)) {
+      st->state = ST_BIT_MARK;
+      return false;
+    }
+    break;
+
+  case ST_BIT_MARK:
+    if (is_mark && (near(d, def->one_mark) || near(d, def->zero_mark))) {
+      shift_in(def, st, near(d, def->one_mark));
+      if (st->count == def->bits_max)
+        return emit(dec, id, st->count, out);
+      st->state = ST_BIT_SPACE;
+      return false;
+    }
+    break;
+
+  case ST_BIT_SPACE:
+    if (is_mark)
+      break;
+    if (near(d, def->zero_space)) {
+      st->state = ST_BIT_MARK;
+      return false;
+    }
+    // Shorter frames end on the gap
+    if (d >= GAP_US && st->count >= def->bits_min)
+      return emit(dec, id, st->count, out);
+    break;
+
+  default:
+    break;
+  }
+
+  restart(st);
+  if (is_mark && near(d, def->hdr_mark)) {
+    st->state = ST_HDR_SPACE;
+  }
+  return false;
+}
+
+// Returns -1 on a broken bit, 1 once the frame is complete, else 0
+static int8_t add_half(const protocol_def_t *def, blfm_ir_proto_state_t *st,
+                       uint8_t level) {
+  if ((st->count & 1) == 0) {
+    st->first = level;
+    st->count++;
+    return 0;
+  }
+
+  // Every bit has a transition in its middle
+  if (level == st->first)
+    return -1;
+
+  st->count++;
+  st->data = (st->data << 1) | (st->first == def->one_first ? 1u : 0u);
+  return st->count == 2 * def->bits_max ? 1 : 0;
+}
+
+static bool feed_biphase(blfm_ir_decoder_t *dec, uint8_t id, uint32_t d,
+                         bool is_mark, blfm_ir_frame_t *out) {
+  const protocol_def_t *def = &protocols[id];
+  blfm_ir_proto_state_t *st = &dec->proto[id];
+
+  if (st->state == ST_HDR_SPACE) {
+    if (!is_mark && near(d, def->hdr_space)) {
+      st->state = ST_HALVES;
+      return false;
+    }
+    restart(st);
+  }
+
+  if (st->state == ST_IDLE) {
+    if (!is_mark)
+      return false;
+    if (def->hdr_mark) {
+      if (near(d, def->hdr_mark)) {
+        st->state = ST_HDR_SPACE;
+      }
+      return false;
+    }
+    // Headerless: this mark is already part of the first bit
+    st->state = ST_HALVES;
+    if (def->lead_half) {
+      add_half(def, st, 0);
+    }
+  }
+
+  // A gap supplies the last half of a frame that ends in a space
+  uint8_t units = (!is_mark && d >= GAP_US) ? UINT8_MAX : to_units(d, def->unit);
+  if (units == 0) {
+    restart(st);
+    return false;
+  }
+
+  while (units > 0) {
+    uint8_t width = (st->count / 2 == def->wide_bit) ? 2 : 1;
+    if (units < width) {
+      restart(st);
+      return false;
+    }
+    units -= width;
+
+    int8_t result = add_half(def, st, is_mark ? 1 : 0);
+    if (result < 0) {
+      restart(st);
+      return false;
+    }
+    if (result > 0)
+      return emit(dec, id, st->count / 2, out);
+  }
+  return false;
+}
+
+/* -------------------- API -------------------- */
+
+void blfm_ir_decoder_init(blfm_ir_decoder_t *dec) {
+  memset(dec, 0, sizeof(*dec));
+  for (uint8_t i = 0; i < BLFM_IR_PROTO_COUNT; i++) {
+    dec->proto[i].toggle = NO_BIT;
+  }
+}
+
+bool blfm_ir_decoder_feed(blfm_ir_decoder_t *dec, uint32_t duration_us,
+                          bool is_mark, blfm_ir_frame_t *out) {
+  uint32_t d = duration_us > MAX_PULSE_US ? MAX_PULSE_US : duration_us;
+  bool found = false;
+
+  for (uint8_t id = 0; id < BLFM_IR_PROTO_COUNT; id++) {
+    blfm_ir_frame_t frame;
+    bool done;
+
+    switch (protocols[id].encoding) {
+    case ENC_PULSE_DISTANCE:
+      done = feed_pulse_distance(dec, id, d, is_mark, &frame);
+      break;
+    case ENC_PULSE_WIDTH:
+      done = feed_pulse_width(dec, id, d, is_mark, &frame);
+      break;
+    default:
+      done = feed_biphase(dec, id, d, is_mark, &frame);
+      break;
+    }
+
+    if (done && !found) {
+      *out = frame;
+      found = true;
+    }
+  }
+  return found;
+}
+
+bool blfm_ir_decoder_idle(blfm_ir_decoder_t *dec, blfm_ir_frame_t *out) {
+  // A long space completes whatever can end on one and resets the rest
+  bool found = blfm_ir_decoder_feed(dec, GAP_US, false, out);
+  for (uint8_t id = 0; id < BLFM_IR_PROTO_COUNT; id++) {
+    restart(&dec->proto[id]);
+  }
+  return found;
+}
+
+const char *blfm_ir_decoder_protocol_name(blfm_ir_protocol_t protocol) {
+  if (protocol >= BLFM_IR_PROTO_COUNT)
+    return "?";
+  return protocols[protocol].name;
+}
+
+#endif /* BLFM_ENABLED_IR_REMOTE */
@@ -8,16 +8,13 @@
  */
 
 /*
- * Fixed NEC-style IR Decoder
- * Enables both rising and falling edge interrupts and measures pulse widths.
+ * IR remote receiver on PA8 (active low).
  *
- * Works reliably with NEC IR remotes.
+ * The EXTI handler, or the TIM1 capture backend, only stamps edges; the
+ * decode task turns them into pulse widths and runs them through the
+ * multi-protocol decoder in blfm_ir_decoder.c.
  */
 
-// ===============================================================
-// NEC IR Decoder - Clean, Tested Version (Active Low)
-// ===============================================================
-
 #include "blfm_config.h"
 #if BLFM_ENABLED_IR_REMOTE
 
@@ -25,177 +22,302 @@
 #include "FreeRTOS.h"
 #include "blfm_exti_dispatcher.h"
 #include "blfm_gpio.h"
+#include "blfm_ir_capture.h"
+#include "blfm_ir_decoder.h"
+#include "blfm_latency.h"
 #include "blfm_pins.h"
+#include "blfm_power.h"
+#include "blfm_ringbuf.h"
+#include "blfm_taskmanager.h"
 #include "blfm_types.h"
+#include "libc_stubs.h"
 #include "queue.h"
 #include "stm32f1xx.h"
+#include "task.h"
 #include <stdbool.h>
 
-// ===============================================================
-// Timing Definitions (microseconds)
-// ===============================================================
-#define NEC_BITS 32
-#define NEC_HDR_MARK_MIN 8500
-#define NEC_HDR_MARK_MAX 9500
-#define NEC_HDR_SPACE_MIN 4000
-#define NEC_HDR_SPACE_MAX 5000
-#define NEC_BIT_MARK_MIN 400
-#define NEC_BIT_MARK_MAX 700
-#define NEC_ZERO_SPACE_MIN 300
-#define NEC_ZERO_SPACE_MAX 800
-#define NEC_ONE_SPACE_MIN 1300
-#define NEC_ONE_SPACE_MAX 2200
-#define NEC_REPEAT_SPACE_MIN 2000
-#define NEC_REPEAT_SPACE_MAX 2500
-
-#define NEC_REPEAT_TIMEOUT_MS 250
+// A NEC repeat code only counts this soon after a full frame
+#define IR_REPEAT_WINDOW_MS 150
+// Quiet time after which the decoder is told the line is idle; longer than
+// any space inside a frame
+#define IR_IDLE_MS 10
+// Highest priority allowed to call FreeRTOS from an ISR
+#define EXTI_IRQ_PRIORITY                                                      \
+  (configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - __NVIC_PRIO_BITS))
 
-// ===============================================================
-// State Definitions
-// ===============================================================
-typedef enum {
-  NEC_STATE_IDLE,
-  NEC_STATE_LEAD_SPACE,
-  NEC_STATE_BIT_MARK,
-  NEC_STATE_BIT_SPACE
-} nec_state_t;
-
-static nec_state_t nec_state = NEC_STATE_IDLE;
-static uint32_t nec_data = 0;
-static uint32_t bit_index = 0;
+static blfm_ir_decoder_t decoder;
 static uint32_t last_edge_time = 0;
+static TickType_t last_edge_tick = 0;
 static QueueHandle_t ir_controller_queue = NULL;
-static uint32_t last_valid_command_tick = 0;
+static TickType_t last_valid_command_tick = 0;
 
 // ===============================================================
-// NEC Pulse Decoder
+// Edge Buffer
 // ===============================================================
-static blfm_ir_command_t ir_remote_process_pulse(uint32_t pulse_us,
-                                                 bool is_low) {
-  static blfm_ir_command_t last_cmd = BLFM_IR_CMD_NONE;
-
-  if (is_low) {
-    // MARK
-    switch (nec_state) {
-    case NEC_STATE_IDLE:
-      if (pulse_us > NEC_HDR_MARK_MIN && pulse_us < NEC_HDR_MARK_MAX) {
-        nec_state = NEC_STATE_LEAD_SPACE;
-      }
-      break;
+// CYCCNT at the edge, with the pin level after the edge in bit 0
+typedef struct {
+  uint32_t stamp;
+  uint32_t tick;
+} ir_edge_t;
+
+_Static_assert((BLFM_IR_EDGE_BUFFER & (BLFM_IR_EDGE_BUFFER - 1)) == 0,
+               "BLFM_IR_EDGE_BUFFER must be a power of two");
+
+// Whole edges only: every push and pop is one ir_edge_t at an aligned offset
+static uint8_t edge_storage[BLFM_IR_EDGE_BUFFER * sizeof(ir_edge_t)];
+static blfm_ringbuf_t edge_ring;
+static TaskHandle_t decode_task = NULL;
+static volatile bool decode_idle;  // Decoder waits for the next burst
+static volatile bool wake_pending; // Set by the ISR, cleared by the task
+static TickType_t wake_tick;       // Oldest unserved wakeup, the release
+static blfm_ir_remote_stats_t stats;
 
-    case NEC_STATE_BIT_MARK:
-      if (pulse_us > NEC_BIT_MARK_MIN && pulse_us < NEC_BIT_MARK_MAX) {
-        nec_state = NEC_STATE_BIT_SPACE;
-      } else {
-        nec_state = NEC_STATE_IDLE;
-      }
-      break;
+// ===============================================================
+// ISR
+// ===============================================================
+// Wakes the decode task; its cycle is released at the first unserved wakeup
+static void wake_decoder(TickType_t tick, BaseType_t *woken) {
+  if (!wake_pending) {
+    wake_pending = true;
+    wake_tick = tick;
+  }
+  vTaskNotifyGiveFromISR(decode_task, woken);
+}
 
-    default:
-      break;
-    }
+static void buffer_edge(uint32_t cycles, bool level, TickType_t tick) {
+  ir_edge_t edge = {
+      .stamp = (cycles & ~1u) | (level ? 1u : 0u),
+      .tick = tick,
+  };
+  if (blfm_ringbuf_push(&edge_ring, (const uint8_t *)&edge, sizeof(edge)) ==
+      sizeof(edge)) {
+    stats.edges++;
   } else {
-    // SPACE
-    switch (nec_state) {
-    case NEC_STATE_LEAD_SPACE:
-      if (pulse_us > NEC_HDR_SPACE_MIN && pulse_us < NEC_HDR_SPACE_MAX) {
-        nec_data = 0;
-        bit_index = 0;
-        nec_state = NEC_STATE_BIT_MARK;
-
-      } else if (pulse_us > NEC_REPEAT_SPACE_MIN &&
-                 pulse_us < NEC_REPEAT_SPACE_MAX) {
-        uint32_t now = xTaskGetTickCount();
-        // Accept REPEAT only if received within 150ms of the LAST VALID command
-        if ((now - last_valid_command_tick) < pdMS_TO_TICKS(150)) {
-          // Still valid repeat
-          nec_state = NEC_STATE_IDLE;
-          return last_cmd;
-        } else {
-          // Too old — treat as NONE
-          nec_state = NEC_STATE_IDLE;
-          return BLFM_IR_CMD_NONE;
-        }
-      }
+    stats.overruns++;
+  }
+}
 
-      else {
-        nec_state = NEC_STATE_IDLE;
-      }
-      break;
-
-    case NEC_STATE_BIT_SPACE:
-      if (pulse_us > NEC_ONE_SPACE_MIN && pulse_us < NEC_ONE_SPACE_MAX) {
-        nec_data |= (1UL << bit_index);
-      } else if (pulse_us > NEC_ZERO_SPACE_MIN &&
-                 pulse_us < NEC_ZERO_SPACE_MAX) {
-        nec_data &= ~(1UL << bit_index);
-      } else {
-        nec_state = NEC_STATE_IDLE;
-        break;
-      }
+static void charge_isr(uint32_t entered) {
+  uint32_t cycles = DWT->CYCCNT - entered;
+  stats.isr_cycles_total += cycles;
+  if (cycles > stats.isr_cycles_peak) {
+    stats.isr_cycles_peak = cycles;
+  }
+}
 
-      bit_index++;
-      if (bit_index >= NEC_BITS) {
-        uint8_t command = (nec_data >> 16) & 0xFF;
-        uint8_t command_inv = (nec_data >> 24) & 0xFF;
-
-        if ((command ^ command_inv) == 0xFF) {
-          last_cmd = (blfm_ir_command_t)command;
-          last_valid_command_tick = xTaskGetTickCount();
-          nec_state = NEC_STATE_IDLE;
-          return last_cmd;
-        } else {
-          last_cmd = BLFM_IR_CMD_NONE;
-          nec_state = NEC_STATE_IDLE;
-          return BLFM_IR_CMD_NONE;
-        }
-      } else {
-        nec_state = NEC_STATE_BIT_MARK;
-      }
-      break;
+#if BLFM_IR_TIMER_CAPTURE
+// Capture counts run from the frame's first edge to the window end
+#define CAPTURE_CYCLES_PER_COUNT (72 * BLFM_IR_CAPTURE_US_PER_COUNT)
+#define CAPTURE_US_PER_TICK (1000000 / configTICK_RATE_HZ)
+
+static void buffer_capture(const blfm_ir_capture_frame_t *frame,
+                           uint16_t count, bool level) {
+  uint32_t ago = BLFM_IR_CAPTURE_WINDOW_COUNTS - count;
+  buffer_edge(frame->end_cycles - ago * CAPTURE_CYCLES_PER_COUNT, level,
+              frame->end_tick -
+                  ago * BLFM_IR_CAPTURE_US_PER_COUNT / CAPTURE_US_PER_TICK);
+}
 
-    default:
-      break;
+// Merges the two sorted capture buffers back into one edge stream
+static void ir_capture_frame(const blfm_ir_capture_frame_t *frame) {
+  uint32_t entered = DWT->CYCCNT;
+  uint8_t r = 0;
+  uint8_t f = 0;
+
+  if (!decode_task) {
+    return;
+  }
+
+  while (r < frame->rise_count || f < frame->fall_count) {
+    if (f < frame->fall_count &&
+        (r >= frame->rise_count || frame->fall[f] < frame->rise[r])) {
+      buffer_capture(frame, frame->fall[f++], false);
+    } else {
+      buffer_capture(frame, frame->rise[r++], true);
     }
   }
 
-  return BLFM_IR_CMD_NONE;
+  BaseType_t hpTaskWoken = pdFALSE;
+  wake_decoder(frame->end_tick, &hpTaskWoken);
+  charge_isr(entered);
+  portYIELD_FROM_ISR(hpTaskWoken);
 }
+#else
+static uint8_t edges_unsignalled; // ISR only
 
-// ===============================================================
-// ISR
-// ===============================================================
+// Only stamps the edge; the state machine runs in blfm_ir_remote_task
 void ir_exti_handler(void) {
-  if (!ir_controller_queue) {
+  uint32_t now = DWT->CYCCNT;
+
+  if (!decode_task) {
     return;
   }
 
-  uint32_t now = DWT->CYCCNT;
+  TickType_t tick = xTaskGetTickCountFromISR();
+  buffer_edge(now, (GPIOA->IDR & GPIO_IDR_IDR8) != 0, tick);
+
+  // Pulses are CYCCNT differences, and tickless idle sleeps between edges
+  if (decode_idle) {
+    blfm_power_hold_clock();
+  }
+
+  // Wake the decoder at the start of a burst and then once per batch
+  BaseType_t hpTaskWoken = pdFALSE;
+  if (decode_idle || ++edges_unsignalled >= BLFM_IR_DECODE_BATCH) {
+    decode_idle = false;
+    edges_unsignalled = 0;
+    wake_decoder(tick, &hpTaskWoken);
+  }
+
+  charge_isr(now);
+  portYIELD_FROM_ISR(hpTaskWoken);
+}
+#endif /* BLFM_IR_TIMER_CAPTURE */
+
+// ===============================================================
+// DECODE TASK
+// ===============================================================
+static void post_frame(const blfm_ir_frame_t *frame, uint32_t cycles,
+                       TickType_t tick, uint32_t pulse_us) {
+  if (frame->repeat && frame->protocol == BLFM_IR_PROTO_NEC) {
+    if ((tick - last_valid_command_tick) >= pdMS_TO_TICKS(IR_REPEAT_WINDOW_MS))
+      return;
+  } else if (!frame->repeat) {
+    last_valid_command_tick = tick;
+  }
+
+  stats.frames[frame->protocol]++;
+
+  blfm_ir_remote_event_t event = {
+      .timestamp = tick,
+      .pulse_us = pulse_us,
+      .command = (blfm_ir_command_t)frame->command,
+      .address = frame->address,
+      .protocol = frame->protocol,
+      .repeat = frame->repeat,
+  };
+  blfm_latency_origin(&event.corr, BLFM_LATENCY_PATH_IR, cycles, tick);
+  xQueueSendToBack(ir_controller_queue, &event, 0);
+}
+
+static void decode_edge(const ir_edge_t *edge) {
+  uint32_t now = edge->stamp & ~1u;
+  bool is_mark = (edge->stamp & 1u) != 0; // Active low: high ends a mark
+  blfm_ir_frame_t frame;
 
   if (last_edge_time == 0) {
     last_edge_time = now;
+    last_edge_tick = edge->tick;
     return;
   }
 
-  uint32_t diff = now - last_edge_time;
-  uint32_t pulse_us = diff / 72;
+  uint32_t pulse_us = (now - last_edge_time) / 72;
+  last_edge_time = now;
+  last_edge_tick = edge->tick;
 
-  bool is_low = ((GPIOA->IDR & GPIO_IDR_IDR8) == 0);
-  bool is_mark = !is_low;
+  if (blfm_ir_decoder_feed(&decoder, pulse_us, is_mark, &frame)) {
+    post_frame(&frame, now, edge->tick, pulse_us);
+  }
+}
+
+// Completes frames whose end is only known from the gap after them
+static void decode_idle_line(void) {
+  blfm_ir_frame_t frame;
 
-  blfm_ir_command_t cmd = ir_remote_process_pulse(pulse_us, is_mark);
-  if (cmd != BLFM_IR_CMD_NONE) {
-    blfm_ir_remote_event_t event = {
-        .timestamp = xTaskGetTickCountFromISR(),
-        .pulse_us = pulse_us,
-        .command = cmd,
-    };
-    BaseType_t hpTaskWoken = pdFALSE;
-    xQueueSendFromISR(ir_controller_queue, &event, &hpTaskWoken);
-    portYIELD_FROM_ISR(hpTaskWoken);
+  if (blfm_ir_decoder_idle(&decoder, &frame)) {
+    post_frame(&frame, last_edge_time, last_edge_tick, 0);
   }
+}
 
-  last_edge_time = now;
+// Returns the number of edges decoded
+static uint32_t decode_pending(void) {
+  uint32_t start = DWT->CYCCNT;
+  uint32_t count = 0;
+  ir_edge_t edge;
+
+  while (blfm_ringbuf_pop(&edge_ring, (uint8_t *)&edge, sizeof(edge)) ==
+         sizeof(edge)) {
+    decode_edge(&edge);
+    count++;
+  }
+
+  if (count > 0) {
+    uint32_t cycles = DWT->CYCCNT - start;
+    taskENTER_CRITICAL();
+    stats.batches++;
+    stats.decoded += count;
+    stats.decode_cycles_total += cycles;
+    if (cycles > stats.decode_cycles_peak) {
+      stats.decode_cycles_peak = cycles;
+    }
+    taskEXIT_CRITICAL();
+  }
+  return count;
+}
+
+static TickType_t take_release(TickType_t fallback) {
+  TickType_t release = fallback;
+
+  taskENTER_CRITICAL();
+  if (wake_pending) {
+    wake_pending = false;
+    release = wake_tick;
+  }
+  taskEXIT_CRITICAL();
+  return release;
+}
+
+void blfm_ir_remote_task(void *params) {
+  (void)params;
+
+  decode_idle = true;
+  decode_task = xTaskGetCurrentTaskHandle();
+
+  for (;;) {
+#if BLFM_IR_TIMER_CAPTURE
+    // Each notification brings a whole frame; nothing to flush
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    blfm_taskmanager_cycle_begin(BLFM_TASK_IR_DECODE,
+                                 take_release(xTaskGetTickCount()));
+    if (decode_pending() > 0) {
+      // The capture window closes after the line has gone quiet
+      decode_idle_line();
+    }
+    blfm_taskmanager_cycle_end(BLFM_TASK_IR_DECODE);
+#else
+    TickType_t wait =
+        decode_idle ? portMAX_DELAY : pdMS_TO_TICKS(BLFM_IR_DECODE_FLUSH_MS);
+    TickType_t waited = xTaskGetTickCount();
+    ulTaskNotifyTake(pdTRUE, wait);
+
+    // A flush is released when its timeout ran out
+    TickType_t now = xTaskGetTickCount();
+    blfm_taskmanager_cycle_begin(BLFM_TASK_IR_DECODE,
+                                 take_release(waited + wait));
+    if (decode_pending() == 0 &&
+        (now - last_edge_tick) >= pdMS_TO_TICKS(IR_IDLE_MS)) {
+      // A quiet spell ends the burst, unless an edge slipped in since
+      decode_idle_line();
+      taskENTER_CRITICAL();
+      if (blfm_ringbuf_used(&edge_ring) == 0) {
+        decode_idle = true;
+        blfm_power_release_clock();
+      }
+      taskEXIT_CRITICAL();
+    }
+    blfm_taskmanager_cycle_end(BLFM_TASK_IR_DECODE);
+#endif
+  }
+}
+
+void blfm_ir_remote_get_stats(blfm_ir_remote_stats_t *out) {
+  if (!out)
+    return;
+
+  taskENTER_CRITICAL();
+  memcpy(out, &stats, sizeof(stats));
+  taskEXIT_CRITICAL();
 }
 
 // ===============================================================
@@ -203,12 +325,16 @@ void ir_exti_handler(void) {
 // ===============================================================
 void blfm_ir_remote_init(QueueHandle_t controller_queue) {
   ir_controller_queue = controller_queue;
+  blfm_ir_decoder_init(&decoder);
+  blfm_ringbuf_init(&edge_ring, edge_storage, sizeof(edge_storage));
 
   // Enable DWT for precise timings
   CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
-  DWT->CYCCNT = 0;
   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
+#if BLFM_IR_TIMER_CAPTURE
+  blfm_ir_capture_init(ir_capture_frame);
+#else
   // Configure GPIO
   blfm_gpio_config_input_pullup((uint32_t)BLFM_IR_REMOTE_PORT,
                                 BLFM_IR_REMOTE_PIN);
@@ -225,8 +351,10 @@ void blfm_ir_remote_init(QueueHandle_t controller_queue) {
   // Register callback
   blfm_exti_register_callback(BLFM_IR_REMOTE_PIN, ir_exti_handler);
 
-  // Enable NVIC
+  // Enable NVIC, low enough to be masked by the decoder's critical sections
+  NVIC_SetPriority(EXTI9_5_IRQn, EXTI_IRQ_PRIORITY);
   NVIC_EnableIRQ(EXTI9_5_IRQn);
+#endif
 }
 
 #endif /* BLFM_ENABLED_IR_REMOTE */
@@ -10,6 +10,11 @@
 
 #include "blfm_config.h"
 #include "blfm_sensor_hub.h"
+#include "blfm_latency.h"
+#include "blfm_taskmanager.h"
+#include "libc_stubs.h"
+#include "stm32f1xx.h"
+#include <stddef.h>
 
 #if BLFM_ENABLED_ULTRASONIC
 #include "blfm_ultrasonic.h"
@@ -23,9 +28,36 @@
 #include "blfm_temperature.h"
 #endif
 
+#if BLFM_ENABLED_IMU
+#include "blfm_imu.h"
+#endif
+
 #include <stdbool.h>
 
+typedef struct {
+  uint8_t offset;
+  uint8_t size;
+} field_layout_t;
+
+static const field_layout_t field_layout[BLFM_SENSOR_COUNT] = {
+    [BLFM_SENSOR_ULTRASONIC] = {offsetof(blfm_sensor_data_t, ultrasonic),
+                                sizeof(blfm_ultrasonic_data_t)},
+    [BLFM_SENSOR_IMU] = {offsetof(blfm_sensor_data_t, imu),
+                         sizeof(blfm_imu_data_t)},
+    [BLFM_SENSOR_TEMPERATURE] = {offsetof(blfm_sensor_data_t, temperature),
+                                 sizeof(blfm_temperature_data_t)},
+    [BLFM_SENSOR_POTENTIOMETER] = {offsetof(blfm_sensor_data_t, potentiometer),
+                                   sizeof(blfm_potentiometer_data_t)},
+};
+
+// Odd while a write is in progress
+static volatile uint32_t board_seq;
+static blfm_sensor_data_t board;
+
 void blfm_sensor_hub_init(void) {
+  memset(&board, 0, sizeof(board));
+  board_seq = 0;
+
 #if BLFM_ENABLED_ULTRASONIC
   blfm_ultrasonic_init();
 #endif
@@ -37,26 +69,135 @@ void blfm_sensor_hub_init(void) {
 #if BLFM_ENABLED_TEMPERATURE
   blfm_temperature_init();
 #endif
+
+#if BLFM_ENABLED_IMU
+  blfm_imu_init();
+#endif
 }
 
-bool blfm_sensor_hub_read(blfm_sensor_data_t *out) {
-  if (!out) {
-    return false;
+/*
+ * Writers may be several tasks, so they are serialized with a short critical
+ * section. Readers never take it; they retry on a sequence change instead.
+ */
+static void board_write(blfm_sensor_id_t id, const void *value) {
+  TickType_t now = xTaskGetTickCount();
+  uint32_t cycles = DWT->CYCCNT;
+
+  taskENTER_CRITICAL();
+  board_seq++;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  if (value) {
+    memcpy((uint8_t *)&board + field_layout[id].offset, value,
+           field_layout[id].size);
+    board.valid |= BLFM_SENSOR_BIT(id);
+    blfm_latency_origin(&board.corr, BLFM_LATENCY_PATH_SENSOR, cycles, now);
+  } else {
+    board.valid &= ~BLFM_SENSOR_BIT(id);
   }
+  board.timestamp[id] = now;
 
-  bool ok = true;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  board_seq++;
+  taskEXIT_CRITICAL();
+}
 
-#if BLFM_ENABLED_ULTRASONIC
-  ok &= blfm_ultrasonic_read(&out->ultrasonic);
-#endif
+void blfm_sensor_hub_publish(blfm_sensor_id_t id, const void *value) {
+  if (id >= BLFM_SENSOR_COUNT || !value)
+    return;
+  board_write(id, value);
+}
 
-#if BLFM_ENABLED_POTENTIOMETER
-  ok &= blfm_potentiometer_read(&out->potentiometer);
+void blfm_sensor_hub_invalidate(blfm_sensor_id_t id) {
+  if (id >= BLFM_SENSOR_COUNT)
+    return;
+  board_write(id, NULL);
+}
+
+void blfm_sensor_hub_snapshot(blfm_sensor_data_t *out) {
+  if (!out)
+    return;
+
+  uint32_t seq;
+  do {
+    seq = board_seq;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    memcpy(out, &board, sizeof(board));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((seq & 1u) || seq != board_seq);
+}
+
+#if BLFM_ENABLED_ULTRASONIC || BLFM_ENABLED_IMU || BLFM_ENABLED_TEMPERATURE ||  \
+    BLFM_ENABLED_POTENTIOMETER
+static void publish_result(blfm_sensor_id_t id, const void *value, bool ok) {
+  if (ok) {
+    blfm_sensor_hub_publish(id, value);
+  } else {
+    blfm_sensor_hub_invalidate(id);
+  }
+}
 #endif
 
+void blfm_sensor_hub_sample(blfm_sensor_id_t id) {
+  switch (id) {
+#if BLFM_ENABLED_IMU
+  case BLFM_SENSOR_IMU: {
+    blfm_imu_data_t imu;
+    publish_result(id, &imu, blfm_imu_read(&imu));
+    break;
+  }
+#endif
 #if BLFM_ENABLED_TEMPERATURE
-  ok &= blfm_temperature_read(&out->temperature);
+  case BLFM_SENSOR_TEMPERATURE: {
+    blfm_temperature_data_t temperature;
+    publish_result(id, &temperature, blfm_temperature_read(&temperature));
+    break;
+  }
 #endif
+#if BLFM_ENABLED_POTENTIOMETER
+  case BLFM_SENSOR_POTENTIOMETER: {
+    blfm_potentiometer_data_t potentiometer;
+    publish_result(id, &potentiometer,
+                   blfm_potentiometer_read(&potentiometer));
+    break;
+  }
+#endif
+  default:
+    // Disabled, or sampled by its own task
+    break;
+  }
+}
+
+void blfm_sensor_hub_poll(void) {
+  blfm_sensor_hub_sample(BLFM_SENSOR_IMU);
+  blfm_sensor_hub_sample(BLFM_SENSOR_TEMPERATURE);
+  blfm_sensor_hub_sample(BLFM_SENSOR_POTENTIOMETER);
+}
+
+#if BLFM_ENABLED_ULTRASONIC
+// Measuring blocks until the echo ends, so it runs in its own task
+void blfm_sensor_hub_ultrasonic_task(void *pvParameters) {
+  (void)pvParameters;
+  blfm_ultrasonic_data_t data;
 
-  return ok;
+#if BLFM_SENSOR_CYCLIC_EXEC
+  // Released by the ultrasonic slot of the cyclic executive
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    blfm_taskmanager_cycle_begin(BLFM_TASK_ULTRASONIC, xTaskGetTickCount());
+    publish_result(BLFM_SENSOR_ULTRASONIC, &data,
+                   blfm_ultrasonic_measure(&data));
+    blfm_taskmanager_cycle_end(BLFM_TASK_ULTRASONIC);
+  }
+#else
+  TickType_t release = xTaskGetTickCount();
+
+  blfm_taskmanager_cycle_begin(BLFM_TASK_ULTRASONIC, release);
+  for (;;) {
+    publish_result(BLFM_SENSOR_ULTRASONIC, &data,
+                   blfm_ultrasonic_measure(&data));
+    blfm_taskmanager_next_cycle(BLFM_TASK_ULTRASONIC, &release);
+  }
+#endif
 }
+#endif
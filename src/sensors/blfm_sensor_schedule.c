@@ -0,0 +1,185 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_config.h"
+#if BLFM_SENSOR_CYCLIC_EXEC
+
+#include "blfm_sensor_schedule.h"
+#include "FreeRTOS.h"
+#include "blfm_cpuload.h"
+#include "blfm_sensor_hub.h"
+#include "blfm_taskmanager.h"
+#include "stm32f1xx.h"
+#include "task.h"
+
+#define CE_DIVISOR(rate_hz) (BLFM_CE_MINOR_FRAME_HZ / (rate_hz))
+#define CE_PHASE(rate_hz, n) ((n) % CE_DIVISOR(rate_hz))
+
+// Highest priority allowed to call FreeRTOS from an ISR
+#define CE_IRQ_PRIORITY                                                        \
+  (configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - __NVIC_PRIO_BITS))
+
+_Static_assert(BLFM_CE_MINOR_FRAME_US - 1 <= 0xFFFF,
+               "minor frame too long for 16-bit TIM3 at 1 MHz");
+_Static_assert(BLFM_CE_MINOR_FRAME_HZ % BLFM_RATE_IMU_HZ == 0,
+               "IMU rate must divide the minor frame rate");
+_Static_assert(BLFM_CE_MINOR_FRAME_HZ % BLFM_RATE_ULTRASONIC_HZ == 0,
+               "ultrasonic rate must divide the minor frame rate");
+_Static_assert(BLFM_CE_MINOR_FRAME_HZ % BLFM_RATE_POTENTIOMETER_HZ == 0,
+               "potentiometer rate must divide the minor frame rate");
+_Static_assert(BLFM_CE_MINOR_FRAME_HZ % BLFM_RATE_TEMPERATURE_HZ == 0,
+               "temperature rate must divide the minor frame rate");
+_Static_assert(BLFM_CE_MINOR_FRAME_HZ % BLFM_RATE_CONTROL_HZ == 0,
+               "control rate must divide the minor frame rate");
+
+typedef enum {
+  SLOT_SAMPLE,     // Read a sensor inline
+  SLOT_ULTRASONIC, // Release the ultrasonic task; measuring blocks too long
+  SLOT_CONTROL     // Wake the controller
+} slot_kind_t;
+
+typedef struct {
+  uint8_t kind;
+  uint8_t sensor;   // blfm_sensor_id_t, for SLOT_SAMPLE
+  uint16_t divisor; // Runs every divisor minor frames,
+  uint16_t phase;   // in the frames where index % divisor == phase
+} ce_slot_t;
+
+/*
+ * Slow slots get different phases so they spread over minor frames instead
+ * of piling into frame 0. Control comes last so it sees this round's data.
+ */
+static const ce_slot_t schedule[] = {
+#if BLFM_ENABLED_IMU
+    {SLOT_SAMPLE, BLFM_SENSOR_IMU, CE_DIVISOR(BLFM_RATE_IMU_HZ),
+     CE_PHASE(BLFM_RATE_IMU_HZ, 0)},
+#endif
+#if BLFM_ENABLED_ULTRASONIC
+    {SLOT_ULTRASONIC, BLFM_SENSOR_ULTRASONIC,
+     CE_DIVISOR(BLFM_RATE_ULTRASONIC_HZ), CE_PHASE(BLFM_RATE_ULTRASONIC_HZ, 1)},
+#endif
+#if BLFM_ENABLED_POTENTIOMETER
+    {SLOT_SAMPLE, BLFM_SENSOR_POTENTIOMETER,
+     CE_DIVISOR(BLFM_RATE_POTENTIOMETER_HZ),
+     CE_PHASE(BLFM_RATE_POTENTIOMETER_HZ, 2)},
+#endif
+#if BLFM_ENABLED_TEMPERATURE
+    {SLOT_SAMPLE, BLFM_SENSOR_TEMPERATURE,
+     CE_DIVISOR(BLFM_RATE_TEMPERATURE_HZ),
+     CE_PHASE(BLFM_RATE_TEMPERATURE_HZ, 3)},
+#endif
+    {SLOT_CONTROL, 0, CE_DIVISOR(BLFM_RATE_CONTROL_HZ),
+     CE_PHASE(BLFM_RATE_CONTROL_HZ, 4)},
+};
+
+#define SCHEDULE_LENGTH (sizeof(schedule) / sizeof(schedule[0]))
+
+static TaskHandle_t exec_task = NULL;
+static uint32_t next_frame;
+static blfm_sensor_schedule_stats_t stats;
+
+void blfm_sensor_schedule_start(void) {
+  exec_task = xTaskGetCurrentTaskHandle();
+  next_frame = 0;
+
+  RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+
+  TIM3->CR1 = 0;
+  TIM3->PSC = 72 - 1; // 72 MHz / 72 = 1 MHz
+  TIM3->ARR = BLFM_CE_MINOR_FRAME_US - 1;
+  TIM3->CNT = 0;
+  TIM3->EGR = TIM_EGR_UG; // Load PSC now
+  TIM3->SR = 0;
+  TIM3->DIER |= TIM_DIER_UIE;
+
+  NVIC_SetPriority(TIM3_IRQn, CE_IRQ_PRIORITY);
+  NVIC_EnableIRQ(TIM3_IRQn);
+
+  TIM3->CR1 |= TIM_CR1_CEN;
+}
+
+bool blfm_sensor_schedule_run_frame(void) {
+  // One notification per TIM3 update; more than one means we fell behind
+  uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  if (pending == 0)
+    return false;
+
+  blfm_taskmanager_cycle_begin(BLFM_TASK_SENSOR_HUB, xTaskGetTickCount());
+
+  // Skip to the newest frame; the lost ones are not replayed
+  uint32_t frame = (next_frame + pending - 1) % BLFM_CE_MAJOR_FRAME_MINORS;
+  next_frame = (frame + 1) % BLFM_CE_MAJOR_FRAME_MINORS;
+
+  bool control_due = false;
+
+  for (uint8_t i = 0; i < SCHEDULE_LENGTH; i++) {
+    const ce_slot_t *slot = &schedule[i];
+    if (frame % slot->divisor != slot->phase)
+      continue;
+
+    switch (slot->kind) {
+    case SLOT_SAMPLE:
+      blfm_sensor_hub_sample((blfm_sensor_id_t)slot->sensor);
+      break;
+    case SLOT_ULTRASONIC: {
+      TaskHandle_t task = blfm_taskmanager_get_handle(BLFM_TASK_ULTRASONIC);
+      if (task) {
+        xTaskNotifyGive(task);
+      }
+      break;
+    }
+    case SLOT_CONTROL:
+      control_due = true;
+      break;
+    default:
+      break;
+    }
+  }
+
+  uint16_t busy_us = (uint16_t)TIM3->CNT;
+
+  taskENTER_CRITICAL();
+  stats.frames++;
+  stats.overruns += pending - 1;
+  stats.busy_us_last = busy_us;
+  if (busy_us > stats.busy_us_max) {
+    stats.busy_us_max = busy_us;
+  }
+  taskEXIT_CRITICAL();
+
+  blfm_taskmanager_cycle_end(BLFM_TASK_SENSOR_HUB);
+  return control_due;
+}
+
+void blfm_sensor_schedule_get_stats(blfm_sensor_schedule_stats_t *out) {
+  if (!out)
+    return;
+
+  taskENTER_CRITICAL();
+  *out = stats;
+  taskEXIT_CRITICAL();
+}
+
+void TIM3_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_TIM3);
+  BaseType_t woken = pdFALSE;
+
+  if (TIM3->SR & TIM_SR_UIF) {
+    TIM3->SR = ~TIM_SR_UIF;
+    if (exec_task) {
+      vTaskNotifyGiveFromISR(exec_task, &woken);
+    }
+  }
+
+  blfm_cpuload_isr_exit(BLFM_ISR_TIM3, entered);
+  portYIELD_FROM_ISR(woken);
+}
+
+#endif /* BLFM_SENSOR_CYCLIC_EXEC */
@@ -13,18 +13,28 @@
 
 #include "blfm_ultrasonic.h"
 #include "FreeRTOS.h"
+#include "blfm_exti_dispatcher.h"
 #include "blfm_gpio.h"
 #include "blfm_pins.h"
-#include "queue.h"
+#include "blfm_power.h"
+#include "stm32f1xx.h"
 #include "task.h"
 #include <stdbool.h>
 
-#define ULTRASONIC_TASK_STACK_SIZE 256
-#define ULTRASONIC_TASK_PRIORITY 2
-#define ULTRASONIC_QUEUE_LENGTH 1
+_Static_assert(BLFM_ULTRASONIC_NOTIFY_INDEX < configTASK_NOTIFICATION_ARRAY_ENTRIES,
+               "BLFM_ULTRASONIC_NOTIFY_INDEX out of range");
 
-static QueueHandle_t ultrasonic_data_queue = NULL;
-static TaskHandle_t ultrasonic_task_handle = NULL;
+// The HC-SR04 holds echo high for 38 ms when nothing is in range
+#define ECHO_TIMEOUT_MS 50
+
+// Highest priority allowed to call FreeRTOS from an ISR
+#define ECHO_IRQ_PRIORITY                                                      \
+  (configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - __NVIC_PRIO_BITS))
+
+static TaskHandle_t measuring; // Task waiting for the echo, NULL otherwise
+static bool echo_high;
+static uint32_t echo_start;    // CYCCNT at the rising edge
+static uint32_t echo_cycles;   // Width of the echo, 0 until it ends
 
 static void delay_us(uint32_t us) {
   for (uint32_t i = 0; i < us * 8; ++i) {
@@ -32,9 +42,29 @@ static void delay_us(uint32_t us) {
   }
 }
 
-static void vUltrasonicTask(void *pvParameters);
-static bool wait_for_pin(uint32_t port, uint32_t pin, int target_state,
-                         uint32_t timeout_ms);
+// Stamps both edges of the echo and wakes the task at the falling one
+static void echo_exti_handler(void) {
+  uint32_t now = DWT->CYCCNT;
+
+  if (!measuring)
+    return;
+
+  if (blfm_gpio_read_pin((uint32_t)BLFM_ULTRASONIC_ECHO_PORT,
+                         BLFM_ULTRASONIC_ECHO_PIN)) {
+    echo_start = now;
+    echo_high = true;
+    return;
+  }
+  if (!echo_high)
+    return;
+
+  echo_cycles = now - echo_start;
+  BaseType_t hpTaskWoken = pdFALSE;
+  vTaskNotifyGiveIndexedFromISR(measuring, BLFM_ULTRASONIC_NOTIFY_INDEX,
+                                &hpTaskWoken);
+  measuring = NULL;
+  portYIELD_FROM_ISR(hpTaskWoken);
+}
 
 void blfm_ultrasonic_init(void) {
   blfm_gpio_config_output((uint32_t)BLFM_ULTRASONIC_TRIG_PORT,
@@ -47,55 +77,38 @@ void blfm_ultrasonic_init(void) {
   if (!(CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk)) {
     CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
   }
-  DWT->CYCCNT = 0;
   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
-  if (ultrasonic_data_queue == NULL) {
-    ultrasonic_data_queue =
-        xQueueCreate(ULTRASONIC_QUEUE_LENGTH, sizeof(blfm_ultrasonic_data_t));
-    configASSERT(ultrasonic_data_queue != NULL);
-  }
-
-  if (ultrasonic_task_handle == NULL) {
-    BaseType_t result = xTaskCreate(
-        vUltrasonicTask, "UltrasonicTask", ULTRASONIC_TASK_STACK_SIZE, NULL,
-        ULTRASONIC_TASK_PRIORITY, &ultrasonic_task_handle);
-    configASSERT(result == pdPASS);
-    if (result != pdPASS) {
-    }
-  }
-}
+  // EXTI mapping for PB3
+  RCC->APB2ENR |= RCC_APB2ENR_AFIOEN;
+  AFIO->EXTICR[BLFM_ULTRASONIC_ECHO_PIN / 4] &=
+      ~(0xFU << (4 * (BLFM_ULTRASONIC_ECHO_PIN % 4)));
+  AFIO->EXTICR[BLFM_ULTRASONIC_ECHO_PIN / 4] |=
+      AFIO_EXTICR1_EXTI0_PB << (4 * (BLFM_ULTRASONIC_ECHO_PIN % 4));
 
-bool blfm_ultrasonic_read(blfm_ultrasonic_data_t *data) {
-  if (!data || !ultrasonic_data_queue)
-    return false;
+  // Trigger both edges
+  EXTI->IMR |= (1 << BLFM_ULTRASONIC_ECHO_PIN);
+  EXTI->RTSR |= (1 << BLFM_ULTRASONIC_ECHO_PIN);
+  EXTI->FTSR |= (1 << BLFM_ULTRASONIC_ECHO_PIN);
 
-  xTaskNotifyGive(ultrasonic_task_handle);
+  blfm_exti_register_callback(BLFM_ULTRASONIC_ECHO_PIN, echo_exti_handler);
 
-  if (xQueueReceive(ultrasonic_data_queue, data, pdMS_TO_TICKS(50)) == pdPASS) {
-    return true;
-  }
-  return false;
+  NVIC_SetPriority(EXTI3_IRQn, ECHO_IRQ_PRIORITY);
+  NVIC_EnableIRQ(EXTI3_IRQn);
 }
 
-static bool wait_for_pin(uint32_t port, uint32_t pin, int target_state,
-                         uint32_t timeout_ms) {
-  uint32_t start = DWT->CYCCNT;
-  uint32_t timeout_cycles = (SystemCoreClock / 1000) * timeout_ms;
-
-  while (blfm_gpio_read_pin(port, pin) != target_state) {
-    if ((DWT->CYCCNT - start) > timeout_cycles) {
-      return false;
-    }
-  }
-  return true;
-}
-
-static bool blfm_ultrasonic_action(blfm_ultrasonic_data_t *data) {
+bool blfm_ultrasonic_measure(blfm_ultrasonic_data_t *data) {
   if (!data)
     return false;
 
-  uint32_t start, end, duration;
+  // The echo is timed on CYCCNT while the task sleeps
+  blfm_power_hold_clock();
+
+  taskENTER_CRITICAL();
+  echo_high = false;
+  echo_cycles = 0;
+  measuring = xTaskGetCurrentTaskHandle();
+  taskEXIT_CRITICAL();
 
   blfm_gpio_clear_pin((uint32_t)BLFM_ULTRASONIC_TRIG_PORT,
                       BLFM_ULTRASONIC_TRIG_PIN);
@@ -106,35 +119,25 @@ static bool blfm_ultrasonic_action(blfm_ultrasonic_data_t *data) {
   blfm_gpio_clear_pin((uint32_t)BLFM_ULTRASONIC_TRIG_PORT,
                       BLFM_ULTRASONIC_TRIG_PIN);
 
-  if (!wait_for_pin((uint32_t)BLFM_ULTRASONIC_ECHO_PORT,
-                    BLFM_ULTRASONIC_ECHO_PIN, 1, 30)) {
-    return false;
-  }
+  ulTaskNotifyTakeIndexed(BLFM_ULTRASONIC_NOTIFY_INDEX, pdTRUE,
+                          pdMS_TO_TICKS(ECHO_TIMEOUT_MS));
+
+  taskENTER_CRITICAL();
+  measuring = NULL;
+  uint32_t duration = echo_cycles;
+  taskEXIT_CRITICAL();
 
-  start = DWT->CYCCNT;
-  if (!wait_for_pin((uint32_t)BLFM_ULTRASONIC_ECHO_PORT,
-                    BLFM_ULTRASONIC_ECHO_PIN, 0, 30)) {
+  // An echo that ended just after the timeout still notified
+  ulTaskNotifyTakeIndexed(BLFM_ULTRASONIC_NOTIFY_INDEX, pdTRUE, 0);
+  blfm_power_release_clock();
+
+  if (duration == 0)
     return false;
-  }
-  end = DWT->CYCCNT;
 
-  duration = end - start;
   uint32_t us = duration / (SystemCoreClock / 1000000);
   data->distance_mm = (uint16_t)(us / 58);
 
   return true;
 }
 
-static void vUltrasonicTask(void *pvParameters) {
-  (void)pvParameters;
-
-  for (;;) {
-    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-    blfm_ultrasonic_data_t data;
-    if (blfm_ultrasonic_action(&data)) {
-      xQueueOverwrite(ultrasonic_data_queue, &data);
-    }
-  }
-}
-
 #endif /* BLFM_ENABLED_ULTRASONIC */
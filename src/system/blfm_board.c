@@ -16,6 +16,7 @@
 #include "blfm_adc.h"
 #include "blfm_delay.h"
 #include "blfm_pwm.h"
+#include "blfm_power.h"
 
 void blfm_board_init(void) {
   blfm_clock_init();    // System clocks
@@ -33,4 +34,5 @@ void blfm_board_init(void) {
   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
   blfm_delay_init();
+  blfm_power_init();
 }
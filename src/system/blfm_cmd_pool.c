@@ -0,0 +1,164 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_cmd_pool.h"
+#include "FreeRTOS.h"
+#include "libc_stubs.h"
+#include "task.h"
+
+static blfm_actuator_command_t pool_buffers[BLFM_CMD_POOL_SIZE];
+static uint8_t pool_refcount[BLFM_CMD_POOL_SIZE];
+static uint32_t pool_timestamp[BLFM_CMD_POOL_SIZE];
+static blfm_cmd_handle_t last_published = BLFM_CMD_HANDLE_INVALID;
+static blfm_cmd_pool_stats_t pool_stats;
+
+static bool handle_valid(blfm_cmd_handle_t handle) {
+  return handle < BLFM_CMD_POOL_SIZE;
+}
+
+// Must be called inside a critical section
+static void ref_inc(blfm_cmd_handle_t handle) {
+  if (pool_refcount[handle]++ == 0) {
+    pool_stats.in_use++;
+    if (pool_stats.in_use > pool_stats.peak_in_use) {
+      pool_stats.peak_in_use = pool_stats.in_use;
+    }
+  }
+}
+
+// Must be called inside a critical section
+static void ref_dec(blfm_cmd_handle_t handle) {
+  configASSERT(pool_refcount[handle] > 0);
+  if (--pool_refcount[handle] == 0) {
+    pool_stats.in_use--;
+  }
+}
+
+void blfm_cmd_pool_init(void) {
+  memset(pool_buffers, 0, sizeof(pool_buffers));
+  memset(pool_refcount, 0, sizeof(pool_refcount));
+  memset(pool_timestamp, 0, sizeof(pool_timestamp));
+  memset(&pool_stats, 0, sizeof(pool_stats));
+  last_published = BLFM_CMD_HANDLE_INVALID;
+}
+
+blfm_actuator_command_t *blfm_cmd_pool_acquire(blfm_cmd_handle_t *handle) {
+  if (!handle)
+    return NULL;
+
+  blfm_cmd_handle_t slot = BLFM_CMD_HANDLE_INVALID;
+  blfm_cmd_handle_t source = BLFM_CMD_HANDLE_INVALID;
+
+  taskENTER_CRITICAL();
+  pool_stats.acquired++;
+
+  if (handle_valid(last_published) && pool_refcount[last_published] == 1) {
+    // Only the pool still points at the last state: write it in place
+    slot = last_published;
+    ref_inc(slot);
+    pool_stats.reused++;
+  } else {
+    for (uint8_t i = 0; i < BLFM_CMD_POOL_SIZE; i++) {
+      if (pool_refcount[i] == 0) {
+        slot = i;
+        ref_inc(slot);
+        break;
+      }
+    }
+
+    if (!handle_valid(slot)) {
+      pool_stats.exhausted++;
+    } else if (handle_valid(last_published)) {
+      // Pin the source so it cannot be recycled while we copy from it
+      source = last_published;
+      ref_inc(source);
+    }
+  }
+  taskEXIT_CRITICAL();
+
+  *handle = slot;
+  if (!handle_valid(slot))
+    return NULL;
+
+  if (handle_valid(source)) {
+    // Published buffers are read-only, so the copy runs outside the lock
+    memcpy(&pool_buffers[slot], &pool_buffers[source],
+           sizeof(blfm_actuator_command_t));
+
+    taskENTER_CRITICAL();
+    ref_dec(source);
+    pool_stats.cloned++;
+    pool_stats.bytes_copied += sizeof(blfm_actuator_command_t);
+    taskEXIT_CRITICAL();
+  } else if (slot != last_published) {
+    memset(&pool_buffers[slot], 0, sizeof(blfm_actuator_command_t));
+  }
+
+  // Stamps belong to the input that produced a command, not to its successor
+  memset(&pool_buffers[slot].latency, 0, sizeof(blfm_latency_stamps_t));
+
+  return &pool_buffers[slot];
+}
+
+void blfm_cmd_pool_publish(blfm_cmd_handle_t handle) {
+  if (!handle_valid(handle))
+    return;
+
+  pool_timestamp[handle] = xTaskGetTickCount();
+
+  taskENTER_CRITICAL();
+  if (handle != last_published) {
+    ref_inc(handle);
+    if (handle_valid(last_published)) {
+      ref_dec(last_published);
+    }
+    last_published = handle;
+  }
+  taskEXIT_CRITICAL();
+}
+
+blfm_actuator_command_t *blfm_cmd_pool_get(blfm_cmd_handle_t handle) {
+  if (!handle_valid(handle))
+    return NULL;
+  return &pool_buffers[handle];
+}
+
+uint32_t blfm_cmd_pool_get_timestamp(blfm_cmd_handle_t handle) {
+  if (!handle_valid(handle))
+    return 0;
+  return pool_timestamp[handle];
+}
+
+void blfm_cmd_pool_retain(blfm_cmd_handle_t handle) {
+  if (!handle_valid(handle))
+    return;
+
+  taskENTER_CRITICAL();
+  ref_inc(handle);
+  taskEXIT_CRITICAL();
+}
+
+void blfm_cmd_pool_release(blfm_cmd_handle_t handle) {
+  if (!handle_valid(handle))
+    return;
+
+  taskENTER_CRITICAL();
+  ref_dec(handle);
+  taskEXIT_CRITICAL();
+}
+
+void blfm_cmd_pool_get_stats(blfm_cmd_pool_stats_t *out) {
+  if (!out)
+    return;
+
+  taskENTER_CRITICAL();
+  *out = pool_stats;
+  taskEXIT_CRITICAL();
+}
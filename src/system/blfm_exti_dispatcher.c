@@ -8,6 +8,7 @@
  */
 
 #include "blfm_exti_dispatcher.h"
+#include "blfm_cpuload.h"
 #include "blfm_gpio.h"
 #include "blfm_pins.h"
 #include "stm32f1xx.h"
@@ -24,16 +25,30 @@ void blfm_exti_register_callback(uint8_t exti_line,
   }
 }
 
+void EXTI3_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_EXTI3);
+  if (EXTI->PR & (1U << 3)) {
+    EXTI->PR = (1U << 3);
+    if (exti_callbacks[3]) {
+      exti_callbacks[3]();
+    }
+  }
+  blfm_cpuload_isr_exit(BLFM_ISR_EXTI3, entered);
+}
+
 void EXTI4_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_EXTI4);
   if (EXTI->PR & (1U << 4)) {
     EXTI->PR = (1U << 4);
     if (exti_callbacks[4]) {
       exti_callbacks[4]();
     }
   }
+  blfm_cpuload_isr_exit(BLFM_ISR_EXTI4, entered);
 }
 
 void EXTI9_5_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_EXTI9_5);
   for (uint8_t line = 5; line <= 9; ++line) {
     if (EXTI->PR & (1U << line)) {
       EXTI->PR = (1U << line); // clear pending bit once here
@@ -42,4 +57,5 @@ void EXTI9_5_IRQHandler(void) {
       }
     }
   }
+  blfm_cpuload_isr_exit(BLFM_ISR_EXTI9_5, entered);
 }
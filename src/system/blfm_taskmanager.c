@@ -20,11 +20,20 @@
 
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "semphr.h"
 #include "task.h"
+#include <stdbool.h>
 
 #include "blfm_actuator_hub.h"
+#include "blfm_cmd_pool.h"
+#include "blfm_cpuload.h"
 #include "blfm_controller.h"
+#include "blfm_latency.h"
+#include "blfm_monitoring.h"
+#include "blfm_recorder.h"
+#include "blfm_rtos_alloc.h"
 #include "blfm_sensor_hub.h"
+#include "blfm_sensor_schedule.h"
 
 #if BLFM_ENABLED_MODE_BUTTON
 #include "blfm_mode_button.h"
@@ -42,12 +51,25 @@
 #include "blfm_bigsound.h"
 #endif
 
+#if BLFM_ENABLED_LED
+#include "blfm_led.h"
+#endif
+
+#if BLFM_ENABLED_SERVO
+#include "blfm_servomotor.h"
+#endif
+
+#if BLFM_ENABLED_TRACE
+#include "blfm_trace.h"
+#endif
+
 // --- Task declarations ---
 static void vSensorHubTask(void *pvParameters);
 static void vControllerTask(void *pvParameters);
 static void vActuatorHubTask(void *pvParameters);
 
 // --- Event Handlers ---
+static void send_actuator_command(blfm_cmd_handle_t handle);
 static void handle_sensor_data(void);
 
 #if BLFM_ENABLED_BIGSOUND
@@ -66,17 +88,174 @@ static void handle_mode_button_event(void);
 static void handle_esp32_event(void);
 #endif
 
-// --- Task and queue settings ---
-#define SENSOR_HUB_TASK_STACK 256
-#define CONTROLLER_TASK_STACK 256
-#define ACTUATOR_HUB_TASK_STACK 256
+// --- Task table ---
+typedef struct {
+  const char *name;
+  TaskFunction_t entry;  // NULL for tasks of disabled modules
+  uint16_t period_ms;    // 0 for event-driven tasks
+  uint16_t deadline_ms;  // Relative to release
+  uint16_t stack_words;
+  StackType_t *stack;    // Static buffers, NULL when allocated from the heap
+  StaticTask_t *buffer;
+  UBaseType_t priority;  // Fixed, or 0 to derive it from the deadline
+} blfm_task_def_t;
+
+// Gap-filling tasks, below every task with a deadline to meet
+#define BACKGROUND_PRIORITY (tskIDLE_PRIORITY + 1)
+
+#define SENSOR_HUB_STACK_WORDS 256
+#define CONTROLLER_STACK_WORDS 256
+#define ACTUATOR_HUB_STACK_WORDS 256
+#define LED_STACK_WORDS 256
+#define ULTRASONIC_STACK_WORDS 256
+#define SERVO_PWM_STACK_WORDS 128
+#define MONITORING_STACK_WORDS 256
+#define TRACE_STACK_WORDS 256
+#define IR_DECODE_STACK_WORDS 192
+#define RECORD_STACK_WORDS 128
+
+BLFM_TASK_STORAGE(sensor_hub, sensor_hub, SENSOR_HUB_STACK_WORDS);
+BLFM_TASK_STORAGE(controller, controller, CONTROLLER_STACK_WORDS);
+BLFM_TASK_STORAGE(actuator_hub, actuator_hub, ACTUATOR_HUB_STACK_WORDS);
+#if BLFM_ENABLED_LED
+BLFM_TASK_STORAGE(led, led, LED_STACK_WORDS);
+#endif
+#if BLFM_ENABLED_ULTRASONIC
+BLFM_TASK_STORAGE(ultrasonic, ultrasonic, ULTRASONIC_STACK_WORDS);
+#endif
+#if BLFM_ENABLED_SERVO
+BLFM_TASK_STORAGE(servo, servo_pwm, SERVO_PWM_STACK_WORDS);
+#endif
+#if BLFM_ENABLED_MONITORING
+BLFM_TASK_STORAGE(monitoring, monitoring, MONITORING_STACK_WORDS);
+#endif
+#if BLFM_ENABLED_TRACE
+BLFM_TASK_STORAGE(trace, trace, TRACE_STACK_WORDS);
+#endif
+#if BLFM_ENABLED_IR_REMOTE
+BLFM_TASK_STORAGE(ir_remote, ir_decode, IR_DECODE_STACK_WORDS);
+#endif
+#if BLFM_ENABLED_RECORD
+BLFM_TASK_STORAGE(recorder, record, RECORD_STACK_WORDS);
+#endif
 
-#define SENSOR_HUB_TASK_PRIORITY 2
-#define CONTROLLER_TASK_PRIORITY 2
-#define ACTUATOR_HUB_TASK_PRIORITY 2
+#define TASK_MEMORY(name, words)                                               \
+  BLFM_TASK_STACK_WORDS(words), BLFM_TASK_STACK(name), BLFM_TASK_BUFFER(name)
+
+/*
+ * Priorities are not listed here: they are derived deadline-monotonically
+ * from the shorter of the period and the deadline. Only the gap-filling
+ * tasks name theirs, BACKGROUND_PRIORITY.
+ */
+static const blfm_task_def_t task_table[BLFM_TASK_COUNT] = {
+#if BLFM_SENSOR_CYCLIC_EXEC
+    // Released by TIM3; each minor frame must finish within the frame
+    [BLFM_TASK_SENSOR_HUB] = {"SensorHub", vSensorHubTask, 0,
+                              1000 / BLFM_CE_MINOR_FRAME_HZ,
+                              TASK_MEMORY(sensor_hub, SENSOR_HUB_STACK_WORDS)},
+#else
+    [BLFM_TASK_SENSOR_HUB] = {"SensorHub", vSensorHubTask, 100, 100,
+                              TASK_MEMORY(sensor_hub, SENSOR_HUB_STACK_WORDS)},
+#endif
+    [BLFM_TASK_CONTROLLER] = {"Controller", vControllerTask, 0, 20,
+                              TASK_MEMORY(controller, CONTROLLER_STACK_WORDS)},
+    // Display writes take tens of ms, hence the loose deadline
+    [BLFM_TASK_ACTUATOR_HUB] = {"ActuatorHub", vActuatorHubTask, 0, 100,
+                                TASK_MEMORY(actuator_hub,
+                                            ACTUATOR_HUB_STACK_WORDS)},
+#if BLFM_ENABLED_LED
+    // Blocks on its command queue, or until the next blink toggle
+    [BLFM_TASK_LED] = {"LEDTask", blfm_led_task, 0, 10,
+                       TASK_MEMORY(led, LED_STACK_WORDS)},
+#endif
+#if BLFM_ENABLED_ULTRASONIC && BLFM_SENSOR_CYCLIC_EXEC
+    // Released by its slot; done before the slot comes round again
+    [BLFM_TASK_ULTRASONIC] = {"UltrasonicTask",
+                              blfm_sensor_hub_ultrasonic_task, 0,
+                              1000 / BLFM_RATE_ULTRASONIC_HZ,
+                              TASK_MEMORY(ultrasonic, ULTRASONIC_STACK_WORDS)},
+#elif BLFM_ENABLED_ULTRASONIC
+    // HC-SR04 needs ~60 ms between pings; a measurement takes up to 60 ms
+    [BLFM_TASK_ULTRASONIC] = {"UltrasonicTask",
+                              blfm_sensor_hub_ultrasonic_task, 60, 60,
+                              TASK_MEMORY(ultrasonic, ULTRASONIC_STACK_WORDS)},
+#endif
+#if BLFM_ENABLED_SERVO
+    // The pulse must be done within 2.5 ms of the period start
+    [BLFM_TASK_SERVO_PWM] = {"ServoPWM", blfm_servomotor_pwm_task, 20, 3,
+                             TASK_MEMORY(servo_pwm, SERVO_PWM_STACK_WORDS)},
+#endif
+#if BLFM_ENABLED_MONITORING
+    [BLFM_TASK_MONITORING] = {"Monitoring", blfm_monitoring_task,
+                              BLFM_MONITORING_PERIOD_MS,
+                              BLFM_MONITORING_PERIOD_MS,
+                              TASK_MEMORY(monitoring, MONITORING_STACK_WORDS)},
+#endif
+#if BLFM_ENABLED_TRACE
+    // Lowest priority: drains into the UART only in the gaps
+    [BLFM_TASK_TRACE] = {"Trace", blfm_trace_task, 0, 1000,
+                         TASK_MEMORY(trace, TRACE_STACK_WORDS),
+                         BACKGROUND_PRIORITY},
+#endif
+#if BLFM_ENABLED_IR_REMOTE
+    // Below the controller; a frame's last edge waits at most a flush period
+    [BLFM_TASK_IR_DECODE] = {"IRDecode", blfm_ir_remote_task, 0, 30,
+                             TASK_MEMORY(ir_decode, IR_DECODE_STACK_WORDS)},
+#endif
+#if BLFM_ENABLED_RECORD
+    // Same gap-filling role as the trace task
+    [BLFM_TASK_RECORD] = {"Record", blfm_recorder_task, 0, 1000,
+                          TASK_MEMORY(record, RECORD_STACK_WORDS),
+                          BACKGROUND_PRIORITY},
+#endif
+};
+
+static TaskHandle_t task_handles[BLFM_TASK_COUNT];
+static UBaseType_t task_priorities[BLFM_TASK_COUNT];
+static blfm_task_timing_t task_timing[BLFM_TASK_COUNT];
+static TickType_t task_release[BLFM_TASK_COUNT];
+
+static void create_tasks(void);
+
+// --- Queue settings ---
+#define ACTUATOR_CMD_QUEUE_LENGTH 5
+#define EVENT_QUEUE_LENGTH 5
+
+// An input is already dequeued when the controller acquires a buffer, so
+// running out of buffers would lose it rather than merge it
+_Static_assert(BLFM_CMD_POOL_SIZE >= ACTUATOR_CMD_QUEUE_LENGTH + 2,
+               "command pool smaller than the actuator queue plus two");
+
+// Room for every member to be full at once, as xQueueAddToSet requires
+#define CONTROLLER_SET_LENGTH                                                  \
+  (1 + EVENT_QUEUE_LENGTH *                                                    \
+           (BLFM_ENABLED_BIGSOUND + BLFM_ENABLED_IR_REMOTE +                   \
+            BLFM_ENABLED_MODE_BUTTON + BLFM_ENABLED_ESP32))
+
+BLFM_SEMAPHORE_STORAGE(sensor_hub, sensor_update);
+BLFM_QUEUE_STORAGE(actuator_hub, actuator_cmd, ACTUATOR_CMD_QUEUE_LENGTH,
+                   sizeof(blfm_cmd_handle_t));
+BLFM_QUEUE_SET_STORAGE(controller, controller_set, CONTROLLER_SET_LENGTH);
+#if BLFM_ENABLED_BIGSOUND
+BLFM_QUEUE_STORAGE(bigsound, bigsound, EVENT_QUEUE_LENGTH,
+                   sizeof(blfm_bigsound_event_t));
+#endif
+#if BLFM_ENABLED_IR_REMOTE
+BLFM_QUEUE_STORAGE(ir_remote, ir_remote, EVENT_QUEUE_LENGTH,
+                   sizeof(blfm_ir_remote_event_t));
+#endif
+#if BLFM_ENABLED_MODE_BUTTON
+BLFM_QUEUE_STORAGE(mode_button, mode_button, EVENT_QUEUE_LENGTH,
+                   sizeof(blfm_mode_button_event_t));
+#endif
+#if BLFM_ENABLED_ESP32
+BLFM_QUEUE_STORAGE(esp32, esp32, EVENT_QUEUE_LENGTH,
+                   sizeof(blfm_esp32_event_t));
+#endif
 
 // --- Queues ---
-static QueueHandle_t xSensorDataQueue = NULL;
+// Given once per sensor hub cycle; the data itself is on the blackboard
+static SemaphoreHandle_t xSensorUpdateSignal = NULL;
 static QueueHandle_t xActuatorCmdQueue = NULL;
 
 #if BLFM_ENABLED_BIGSOUND
@@ -98,39 +277,53 @@ static QueueHandle_t xESP32Queue = NULL;
 static QueueSetHandle_t xControllerQueueSet = NULL;
 
 void blfm_taskmanager_setup(void) {
-  // Always create sensor + actuator command queues
-  xSensorDataQueue = xQueueCreate(5, sizeof(blfm_sensor_data_t));
-  configASSERT(xSensorDataQueue != NULL);
+  blfm_cpuload_init();
+  blfm_monitoring_init();
+#if BLFM_ENABLED_RECORD
+  blfm_recorder_init();
+#endif
 
-  xActuatorCmdQueue = xQueueCreate(5, sizeof(blfm_actuator_command_t));
+  // Always create sensor signal + actuator command queue
+  xSensorUpdateSignal = BLFM_BINARY_SEMAPHORE_CREATE(sensor_update);
+  configASSERT(xSensorUpdateSignal != NULL);
+
+  // Commands live in the pool; only handles go through the queue
+  blfm_cmd_pool_init();
+  xActuatorCmdQueue = BLFM_QUEUE_CREATE(
+      actuator_cmd, ACTUATOR_CMD_QUEUE_LENGTH, sizeof(blfm_cmd_handle_t));
   configASSERT(xActuatorCmdQueue != NULL);
 
   // Optional queues
 #if BLFM_ENABLED_BIGSOUND
-  xBigSoundQueue = xQueueCreate(5, sizeof(blfm_bigsound_event_t));
+  xBigSoundQueue = BLFM_QUEUE_CREATE(bigsound, EVENT_QUEUE_LENGTH,
+                                     sizeof(blfm_bigsound_event_t));
   configASSERT(xBigSoundQueue != NULL);
 #endif
 
 #if BLFM_ENABLED_IR_REMOTE
-  xIRRemoteQueue = xQueueCreate(5, sizeof(blfm_ir_remote_event_t));
+  xIRRemoteQueue = BLFM_QUEUE_CREATE(ir_remote, EVENT_QUEUE_LENGTH,
+                                     sizeof(blfm_ir_remote_event_t));
   configASSERT(xIRRemoteQueue != NULL);
 #endif
 
 #if BLFM_ENABLED_MODE_BUTTON
-  xModeButtonQueue = xQueueCreate(5, sizeof(blfm_mode_button_event_t));
+  xModeButtonQueue = BLFM_QUEUE_CREATE(mode_button, EVENT_QUEUE_LENGTH,
+                                       sizeof(blfm_mode_button_event_t));
   configASSERT(xModeButtonQueue != NULL);
 #endif
 
 #if BLFM_ENABLED_ESP32
-  xESP32Queue = xQueueCreate(5, sizeof(blfm_esp32_event_t));
+  xESP32Queue = BLFM_QUEUE_CREATE(esp32, EVENT_QUEUE_LENGTH,
+                                  sizeof(blfm_esp32_event_t));
   configASSERT(xESP32Queue != NULL);
 #endif
 
   // Queue set
-  xControllerQueueSet = xQueueCreateSet(10);
+  xControllerQueueSet =
+      BLFM_QUEUE_SET_CREATE(controller_set, CONTROLLER_SET_LENGTH);
   configASSERT(xControllerQueueSet != NULL);
 
-  xQueueAddToSet(xSensorDataQueue, xControllerQueueSet);
+  xQueueAddToSet(xSensorUpdateSignal, xControllerQueueSet);
 
 #if BLFM_ENABLED_BIGSOUND
   xQueueAddToSet(xBigSoundQueue, xControllerQueueSet);
@@ -145,6 +338,23 @@ void blfm_taskmanager_setup(void) {
   xQueueAddToSet(xESP32Queue, xControllerQueueSet);
 #endif
 
+  // Peak depths show whether the lengths above are right; the SensorUpdate
+  // signal coalesces by design and is left out
+  blfm_monitoring_register_queue(xActuatorCmdQueue, "ActuatorCmd");
+  blfm_monitoring_register_queue(xControllerQueueSet, "ControllerSet");
+#if BLFM_ENABLED_BIGSOUND
+  blfm_monitoring_register_queue(xBigSoundQueue, "BigSound");
+#endif
+#if BLFM_ENABLED_IR_REMOTE
+  blfm_monitoring_register_queue(xIRRemoteQueue, "IRRemote");
+#endif
+#if BLFM_ENABLED_MODE_BUTTON
+  blfm_monitoring_register_queue(xModeButtonQueue, "ModeButton");
+#endif
+#if BLFM_ENABLED_ESP32
+  blfm_monitoring_register_queue(xESP32Queue, "ESP32");
+#endif
+
   // Init all modules
   blfm_sensor_hub_init();
   blfm_actuator_hub_init();
@@ -163,65 +373,205 @@ void blfm_taskmanager_setup(void) {
 #endif
 
 #if BLFM_ENABLED_ESP32
-  blfm_esp32_init();
+  blfm_esp32_init(xESP32Queue);
 #endif
 
-  // Tasks (always run sensor and actuator hub)
-  xTaskCreate(vSensorHubTask, "SensorHub", SENSOR_HUB_TASK_STACK, NULL,
-              SENSOR_HUB_TASK_PRIORITY, NULL);
+  // Modules are initialized, so their tasks can start
+  create_tasks();
+}
+
+void blfm_taskmanager_start(void) { vTaskStartScheduler(); }
 
-  xTaskCreate(vControllerTask, "Controller", CONTROLLER_TASK_STACK, NULL,
-              CONTROLLER_TASK_PRIORITY, NULL);
+// --- Task table ---
 
-  xTaskCreate(vActuatorHubTask, "ActuatorHub", ACTUATOR_HUB_TASK_STACK, NULL,
-              ACTUATOR_HUB_TASK_PRIORITY, NULL);
+// A periodic task may have to finish well inside its period
+static uint16_t task_deadline_ms(const blfm_task_def_t *def) {
+  if (def->period_ms && def->period_ms < def->deadline_ms)
+    return def->period_ms;
+  return def->deadline_ms;
 }
 
-void blfm_taskmanager_start(void) { vTaskStartScheduler(); }
+// Shortest deadline gets the highest priority; equal deadlines share a level
+static UBaseType_t deadline_monotonic_priority(blfm_task_id_t id) {
+  uint16_t deadline = task_deadline_ms(&task_table[id]);
+  UBaseType_t rank = 0;
+
+  for (uint8_t i = 0; i < BLFM_TASK_COUNT; i++) {
+    if (!task_table[i].entry || task_table[i].priority ||
+        task_deadline_ms(&task_table[i]) >= deadline)
+      continue;
+
+    // Count each distinct shorter deadline once
+    bool seen = false;
+    for (uint8_t j = 0; j < i; j++) {
+      if (task_table[j].entry && !task_table[j].priority &&
+          task_deadline_ms(&task_table[j]) ==
+              task_deadline_ms(&task_table[i])) {
+        seen = true;
+        break;
+      }
+    }
+    if (!seen)
+      rank++;
+  }
+
+  // Each distinct deadline needs a level above the background tasks; raise
+  // configMAX_PRIORITIES rather than let two share one
+  const UBaseType_t top = configMAX_PRIORITIES - 1;
+  configASSERT(rank < top - BACKGROUND_PRIORITY);
+  return top - rank;
+}
+
+static void create_tasks(void) {
+  for (uint8_t i = 0; i < BLFM_TASK_COUNT; i++) {
+    const blfm_task_def_t *def = &task_table[i];
+    if (!def->entry)
+      continue;
+
+    task_priorities[i] = def->priority
+                             ? def->priority
+                             : deadline_monotonic_priority((blfm_task_id_t)i);
+#if BLFM_STATIC_ALLOCATION
+    task_handles[i] =
+        xTaskCreateStatic(def->entry, def->name, def->stack_words, NULL,
+                          task_priorities[i], def->stack, def->buffer);
+    configASSERT(task_handles[i] != NULL);
+#else
+    BaseType_t result = xTaskCreate(def->entry, def->name, def->stack_words,
+                                    NULL, task_priorities[i], &task_handles[i]);
+    configASSERT(result == pdPASS);
+    (void)result; // configASSERT may compile to nothing
+#endif
+    blfm_cpuload_register_task(task_handles[i], (blfm_task_id_t)i);
+  }
+}
+
+TaskHandle_t blfm_taskmanager_get_handle(blfm_task_id_t id) {
+  if (id >= BLFM_TASK_COUNT)
+    return NULL;
+  return task_handles[id];
+}
+
+UBaseType_t blfm_taskmanager_get_priority(blfm_task_id_t id) {
+  if (id >= BLFM_TASK_COUNT)
+    return tskIDLE_PRIORITY;
+  return task_priorities[id];
+}
+
+uint16_t blfm_taskmanager_get_stack_words(blfm_task_id_t id) {
+  if (id >= BLFM_TASK_COUNT || !task_handles[id])
+    return 0;
+  return task_table[id].stack_words;
+}
+
+void blfm_taskmanager_cycle_begin(blfm_task_id_t id, TickType_t release) {
+  if (id >= BLFM_TASK_COUNT)
+    return;
+
+  uint32_t jitter = (uint32_t)(xTaskGetTickCount() - release);
+
+  taskENTER_CRITICAL();
+  task_release[id] = release;
+  task_timing[id].jitter_last = jitter;
+  if (jitter > task_timing[id].jitter_max) {
+    task_timing[id].jitter_max = jitter;
+  }
+  taskEXIT_CRITICAL();
+}
+
+void blfm_taskmanager_cycle_end(blfm_task_id_t id) {
+  if (id >= BLFM_TASK_COUNT)
+    return;
+
+  TickType_t now = xTaskGetTickCount();
+  TickType_t deadline = pdMS_TO_TICKS(task_table[id].deadline_ms);
+
+  taskENTER_CRITICAL();
+  blfm_task_timing_t *timing = &task_timing[id];
+  uint32_t response = (uint32_t)(now - task_release[id]);
+
+  timing->cycles++;
+  timing->response_last = response;
+  if (response > timing->response_max) {
+    timing->response_max = response;
+  }
+  if (response > deadline) {
+    timing->deadline_misses++;
+  }
+  taskEXIT_CRITICAL();
+}
+
+void blfm_taskmanager_next_cycle(blfm_task_id_t id, TickType_t *release) {
+  if (id >= BLFM_TASK_COUNT || !release)
+    return;
+
+  blfm_taskmanager_cycle_end(id);
+  xTaskDelayUntil(release, pdMS_TO_TICKS(task_table[id].period_ms));
+  blfm_taskmanager_cycle_begin(id, *release);
+}
+
+void blfm_taskmanager_get_timing(blfm_task_id_t id, blfm_task_timing_t *out) {
+  if (id >= BLFM_TASK_COUNT || !out)
+    return;
+
+  taskENTER_CRITICAL();
+  *out = task_timing[id];
+  taskEXIT_CRITICAL();
+}
 
 // --- Tasks ---
 static void vSensorHubTask(void *pvParameters) {
   (void)pvParameters;
-  blfm_sensor_data_t sensor_data;
 
+#if BLFM_SENSOR_CYCLIC_EXEC
+  // One task runs every sensor slot, so sampling costs one switch per frame
+  blfm_sensor_schedule_start();
   for (;;) {
-    if (blfm_sensor_hub_read(&sensor_data)) {
-      xQueueSendToBack(xSensorDataQueue, &sensor_data, 0);
+    if (blfm_sensor_schedule_run_frame()) {
+      xSemaphoreGive(xSensorUpdateSignal);
     }
-    vTaskDelay(pdMS_TO_TICKS(100));
   }
+#else
+  TickType_t release = xTaskGetTickCount();
+
+  blfm_taskmanager_cycle_begin(BLFM_TASK_SENSOR_HUB, release);
+  for (;;) {
+    // Slow sensors publish from their own tasks; this only adds the fast ones
+    blfm_sensor_hub_poll();
+    xSemaphoreGive(xSensorUpdateSignal);
+    blfm_taskmanager_next_cycle(BLFM_TASK_SENSOR_HUB, &release);
+  }
+#endif
 }
 
 static void vControllerTask(void *pvParameters) {
   (void)pvParameters;
 
 #if BLFM_ENABLED_IR_REMOTE
-  blfm_actuator_command_t command;
-#endif
-
-#if BLFM_ENABLED_ESP32
-  blfm_esp32_event_t esp32_event;
+  blfm_cmd_handle_t handle;
+  blfm_actuator_command_t *command;
 #endif
 
   for (;;) {
     QueueSetMemberHandle_t activated =
         xQueueSelectFromSet(xControllerQueueSet, pdMS_TO_TICKS(100));
 
+    // Each handler starts the cycle at its input's tick once it dequeued it
     if (activated == NULL) {
+      blfm_taskmanager_cycle_begin(BLFM_TASK_CONTROLLER, xTaskGetTickCount());
 #if BLFM_ENABLED_IR_REMOTE
-      if (blfm_controller_check_ir_timeout(&command)) {
-        xQueueSendToBack(xActuatorCmdQueue, &command, 0);
+      command = blfm_cmd_pool_acquire(&handle);
+      if (command) {
+        BLFM_RECORD_INPUT(BLFM_RECORD_IR_TIMEOUT, NULL);
+        if (blfm_controller_check_ir_timeout(command)) {
+          send_actuator_command(handle);
+        } else {
+          blfm_cmd_pool_release(handle);
+        }
       }
 #endif
-#if BLFM_ENABLED_ESP32
-      if (blfm_esp32_get_event(&esp32_event)) {
-        xQueueSendToBack(xESP32Queue, &esp32_event, 0);
-      }
-#endif
-      continue;
-    }
-
-    if (activated == xSensorDataQueue) {
+      blfm_taskmanager_cycle_end(BLFM_TASK_CONTROLLER);
+    } else if (activated == xSensorUpdateSignal) {
       handle_sensor_data();
     }
 #if BLFM_ENABLED_BIGSOUND
@@ -250,72 +600,154 @@ static void vControllerTask(void *pvParameters) {
 static void vActuatorHubTask(void *pvParameters) {
   (void)pvParameters;
 
-  blfm_actuator_command_t command;
+  blfm_cmd_handle_t handle;
 
   for (;;) {
-    if (xQueueReceive(xActuatorCmdQueue, &command, pdMS_TO_TICKS(10)) ==
-        pdPASS) {
-      blfm_actuator_hub_apply(&command);
+    // Sleep until the controller publishes something; no polling delay
+    if (xQueueReceive(xActuatorCmdQueue, &handle, portMAX_DELAY) != pdPASS)
+      continue;
+
+#if BLFM_ACTUATOR_LATEST_WINS
+    // Every command is a full state, so only the newest one matters
+    blfm_cmd_handle_t newer;
+    while (xQueueReceive(xActuatorCmdQueue, &newer, 0) == pdPASS) {
+      blfm_actuator_hub_discard_handle(handle);
+      handle = newer;
     }
-    vTaskDelay(pdMS_TO_TICKS(50));
+#endif
+
+    // Released when the controller published the command
+    blfm_taskmanager_cycle_begin(BLFM_TASK_ACTUATOR_HUB,
+                                 blfm_cmd_pool_get_timestamp(handle));
+    blfm_actuator_hub_apply_handle(handle);
+    blfm_taskmanager_cycle_end(BLFM_TASK_ACTUATOR_HUB);
   }
 }
 
 // --- Event Handlers ---
+
+// Hands the caller's reference over to the actuator queue
+static void send_actuator_command(blfm_cmd_handle_t handle) {
+  blfm_latency_publish(blfm_cmd_pool_get(handle));
+  blfm_cmd_pool_publish(handle);
+  if (xQueueSendToBack(xActuatorCmdQueue, &handle, 0) != pdPASS) {
+    blfm_cmd_pool_release(handle);
+  }
+}
+
+// The signal follows the poll's last write, the newest field timestamp; a
+// board nothing was written to yet has no better release than now
+static TickType_t sensor_release(const blfm_sensor_data_t *data) {
+  TickType_t now = xTaskGetTickCount();
+  TickType_t age = portMAX_DELAY;
+
+  for (uint8_t id = 0; id < BLFM_SENSOR_COUNT; id++) {
+    TickType_t field_age = (TickType_t)(now - data->timestamp[id]);
+    if (data->timestamp[id] != 0 && field_age < age) {
+      age = field_age;
+    }
+  }
+  return age == portMAX_DELAY ? now : now - age;
+}
+
 static void handle_sensor_data(void) {
+  static uint16_t last_corr_id;
   blfm_sensor_data_t sensor_data;
-  blfm_actuator_command_t command;
-
-  if (xQueueReceive(xSensorDataQueue, &sensor_data, 0) == pdPASS) {
-    blfm_controller_process(&sensor_data, &command);
-    xQueueSendToBack(xActuatorCmdQueue, &command, 0);
+  blfm_cmd_handle_t handle;
+
+  if (xSemaphoreTake(xSensorUpdateSignal, 0) != pdPASS)
+    return;
+
+  blfm_sensor_hub_snapshot(&sensor_data);
+  blfm_taskmanager_cycle_begin(BLFM_TASK_CONTROLLER,
+                               sensor_release(&sensor_data));
+  blfm_actuator_command_t *command = blfm_cmd_pool_acquire(&handle);
+  if (command) {
+    // A snapshot with no new publish would count the same sample twice
+    if (sensor_data.corr.id != last_corr_id) {
+      last_corr_id = sensor_data.corr.id;
+      blfm_latency_begin(command, &sensor_data.corr);
+    }
+    BLFM_RECORD_INPUT(BLFM_RECORD_SENSOR, &sensor_data);
+    blfm_controller_process(&sensor_data, command);
+    send_actuator_command(handle);
   }
+  blfm_taskmanager_cycle_end(BLFM_TASK_CONTROLLER);
 }
 
 #if BLFM_ENABLED_BIGSOUND
 static void handle_bigsound_event(void) {
   blfm_bigsound_event_t event;
-  blfm_actuator_command_t command;
+  blfm_cmd_handle_t handle;
+
+  if (xQueueReceive(xBigSoundQueue, &event, 0) != pdPASS)
+    return;
 
-  if (xQueueReceive(xBigSoundQueue, &event, 0) == pdPASS) {
-    blfm_controller_process_bigsound(&event, &command);
-    xQueueSendToBack(xActuatorCmdQueue, &command, 0);
+  blfm_taskmanager_cycle_begin(BLFM_TASK_CONTROLLER, event.timestamp);
+  blfm_actuator_command_t *command = blfm_cmd_pool_acquire(&handle);
+  if (command) {
+    BLFM_RECORD_INPUT(BLFM_RECORD_BIGSOUND, &event);
+    blfm_controller_process_bigsound(&event, command);
+    send_actuator_command(handle);
   }
+  blfm_taskmanager_cycle_end(BLFM_TASK_CONTROLLER);
 }
 #endif
 
 #if BLFM_ENABLED_IR_REMOTE
 static void handle_ir_remote_event(void) {
   blfm_ir_remote_event_t event;
-  blfm_actuator_command_t command;
-
-  if (xQueueReceive(xIRRemoteQueue, &event, 0) == pdPASS) {
-    blfm_controller_process_ir_remote(&event, &command);
-    xQueueSendToBack(xActuatorCmdQueue, &command, 0);
+  blfm_cmd_handle_t handle;
+
+  if (xQueueReceive(xIRRemoteQueue, &event, 0) != pdPASS)
+    return;
+
+  blfm_taskmanager_cycle_begin(BLFM_TASK_CONTROLLER, event.timestamp);
+  blfm_actuator_command_t *command = blfm_cmd_pool_acquire(&handle);
+  if (command) {
+    blfm_latency_begin(command, &event.corr);
+    BLFM_RECORD_INPUT(BLFM_RECORD_IR, &event);
+    blfm_controller_process_ir_remote(&event, command);
+    send_actuator_command(handle);
   }
+  blfm_taskmanager_cycle_end(BLFM_TASK_CONTROLLER);
 }
 #endif
 
 #if BLFM_ENABLED_MODE_BUTTON
 static void handle_mode_button_event(void) {
   blfm_mode_button_event_t event;
-  blfm_actuator_command_t command;
+  blfm_cmd_handle_t handle;
+
+  if (xQueueReceive(xModeButtonQueue, &event, 0) != pdPASS)
+    return;
 
-  if (xQueueReceive(xModeButtonQueue, &event, 0) == pdPASS) {
-    blfm_controller_process_mode_button(&event, &command);
-    xQueueSendToBack(xActuatorCmdQueue, &command, 0);
+  blfm_taskmanager_cycle_begin(BLFM_TASK_CONTROLLER, event.timestamp);
+  blfm_actuator_command_t *command = blfm_cmd_pool_acquire(&handle);
+  if (command) {
+    BLFM_RECORD_INPUT(BLFM_RECORD_MODE_BUTTON, &event);
+    blfm_controller_process_mode_button(&event, command);
+    send_actuator_command(handle);
   }
+  blfm_taskmanager_cycle_end(BLFM_TASK_CONTROLLER);
 }
 #endif
 
 #if BLFM_ENABLED_ESP32
 static void handle_esp32_event(void) {
   blfm_esp32_event_t event;
-  blfm_actuator_command_t command;
+  blfm_cmd_handle_t handle;
+
+  if (xQueueReceive(xESP32Queue, &event, 0) != pdPASS)
+    return;
 
-  if (xQueueReceive(xESP32Queue, &event, 0) == pdPASS) {
-    blfm_controller_process_esp32(&event, &command);
-    xQueueSendToBack(xActuatorCmdQueue, &command, 0);
+  blfm_taskmanager_cycle_begin(BLFM_TASK_CONTROLLER, event.timestamp);
+  blfm_actuator_command_t *command = blfm_cmd_pool_acquire(&handle);
+  if (command) {
+    BLFM_RECORD_INPUT(BLFM_RECORD_ESP32, &event);
+    blfm_controller_process_esp32(&event, command);
+    send_actuator_command(handle);
   }
+  blfm_taskmanager_cycle_end(BLFM_TASK_CONTROLLER);
 }
 #endif
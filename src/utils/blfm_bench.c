@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_config.h"
+#if BLFM_ENABLED_BENCH
+
+#include "blfm_bench.h"
+#include "FreeRTOS.h"
+#include "blfm_controller.h"
+#include "blfm_i2c1.h"
+#include "blfm_spi.h"
+#include "blfm_uart.h"
+#include "libc_stubs.h"
+#include "stm32f1xx.h"
+#include <stdbool.h>
+
+#if BLFM_ENABLED_OLED
+#include "blfm_oled.h"
+#endif
+
+#if BLFM_ENABLED_IR_REMOTE
+#include "blfm_ir_decoder.h"
+#endif
+
+#define OLED_ADDR 0x3C
+#define SSD1306_NOP 0xE3
+
+typedef struct {
+  const char *name;
+  void (*setup)(void); // Optional, once before the runs
+  int32_t (*run)(void); // One operation
+} blfm_bench_t;
+
+static uint32_t samples[BLFM_BENCH_RUNS];
+
+/* -------------------- Report -------------------- */
+
+static void put_str(const char *s) {
+  while (*s) {
+    blfm_uart_send_u8((uint8_t)*s++);
+  }
+}
+
+static void put_u32(uint32_t v) {
+  char buf[11];
+  uint8_t n = 0;
+  do {
+    buf[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  while (n) {
+    blfm_uart_send_u8((uint8_t)buf[--n]);
+  }
+}
+
+static void put_i32(int32_t v) {
+  if (v < 0) {
+    blfm_uart_send_u8('-');
+    put_u32((uint32_t)0 - (uint32_t)v);
+  } else {
+    put_u32((uint32_t)v);
+  }
+}
+
+/* -------------------- Benchmarks -------------------- */
+
+static int32_t run_empty(void) { return 0; }
+
+static int32_t run_i2c1_write(void) {
+  static const uint8_t nop[2] = {0x00, SSD1306_NOP};
+  return blfm_i2c1_write(OLED_ADDR, nop, sizeof(nop));
+}
+
+static void setup_spi1(void) { blfm_spi1_init(); }
+
+static int32_t run_spi1_transfer(void) { return blfm_spi1_transfer(0xFF); }
+
+#if BLFM_ENABLED_OLED
+static void setup_oled(void) { blfm_oled_init(); }
+
+static int32_t run_oled_flush(void) {
+  blfm_oled_flush();
+  return 0;
+}
+
+static int32_t run_oled_draw_char(void) {
+  blfm_oled_draw_char(0, 0, 'B');
+  return 0;
+}
+#endif
+
+static blfm_actuator_command_t command;
+static blfm_sensor_data_t sensor = {
+    .valid = BLFM_SENSOR_BIT(BLFM_SENSOR_ULTRASONIC),
+    .ultrasonic = {.distance_mm = 800},
+};
+
+static void setup_controller(void) {
+  blfm_controller_init();
+#if BLFM_ENABLED_IR_REMOTE
+  // Key 2 selects AUTO, the mode in which sensor frames steer the rover
+  blfm_ir_remote_event_t key = {.command = BLFM_IR_CMD_2,
+                                .protocol = BLFM_IR_PROTO_NEC};
+  blfm_controller_process_ir_remote(&key, &command);
+#endif
+}
+
+static int32_t run_controller_process(void) {
+  blfm_controller_process(&sensor, &command);
+  return command.motor.left.speed;
+}
+
+#if BLFM_ENABLED_IR_REMOTE
+static int32_t run_controller_ir_remote(void) {
+  static const blfm_ir_remote_event_t key = {.command = BLFM_IR_CMD_UP,
+                                             .protocol = BLFM_IR_PROTO_NEC};
+  blfm_controller_process_ir_remote(&key, &command);
+  return command.motor.left.speed;
+}
+
+// One NEC frame, then the gap; each run feeds the next pulse of it
+#define NEC_PULSES (2 + 64 + 2)
+static uint16_t nec_us[NEC_PULSES];
+static blfm_ir_decoder_t decoder;
+static uint8_t nec_next;
+
+static void setup_ir_decoder(void) {
+  uint32_t data = 0x00FFu | (0x18u << 16) | ((uint32_t)(~0x18u & 0xFF) << 24);
+  uint8_t n = 0;
+
+  nec_us[n++] = 9000;
+  nec_us[n++] = 4500;
+  for (uint8_t bit = 0; bit < 32; bit++) {
+    nec_us[n++] = 560;
+    nec_us[n++] = (data >> bit) & 1 ? 1690 : 560;
+  }
+  nec_us[n++] = 560;
+  nec_us[n++] = 40000;
+  blfm_ir_decoder_init(&decoder);
+}
+
+static int32_t run_ir_decoder_feed(void) {
+  blfm_ir_frame_t frame;
+  uint8_t k = nec_next;
+  nec_next = (uint8_t)(k + 1 < NEC_PULSES ? k + 1 : 0);
+  return blfm_ir_decoder_feed(&decoder, nec_us[k], (k & 1) == 0, &frame);
+}
+#endif
+
+static char text[32] = "BELFHYM 2025 rover";
+static uint8_t buf_a[64];
+static uint8_t buf_b[64];
+
+static int32_t run_memset_64(void) {
+  memset(buf_a, 0x55, sizeof(buf_a));
+  return buf_a[63];
+}
+
+static int32_t run_memcpy_64(void) {
+  memcpy(buf_b, buf_a, sizeof(buf_b));
+  return buf_b[63];
+}
+
+static int32_t run_strlen_18(void) { return (int32_t)strlen(text); }
+
+static int32_t run_strcpy_strcat(void) {
+  char line[32];
+  strcpy(line, "Dist: ");
+  strcat(line, "123");
+  strcat(line, " mm");
+  return line[0];
+}
+
+static int32_t run_safe_strncpy_16(void) {
+  char line[16];
+  safe_strncpy(line, text, sizeof(line));
+  return line[0];
+}
+
+static const blfm_bench_t benches[] = {
+    {"i2c1.write_2", NULL, run_i2c1_write},
+    {"spi1.transfer", setup_spi1, run_spi1_transfer},
+#if BLFM_ENABLED_OLED
+    {"oled.flush", setup_oled, run_oled_flush},
+    {"oled.draw_char", NULL, run_oled_draw_char},
+#endif
+    {"controller.process", setup_controller, run_controller_process},
+#if BLFM_ENABLED_IR_REMOTE
+    {"controller.ir_remote", NULL, run_controller_ir_remote},
+    {"ir_decoder.feed", setup_ir_decoder, run_ir_decoder_feed},
+#endif
+    {"libc.memset_64", NULL, run_memset_64},
+    {"libc.memcpy_64", NULL, run_memcpy_64},
+    {"libc.strlen_18", NULL, run_strlen_18},
+    {"libc.strcpy_strcat", NULL, run_strcpy_strcat},
+    {"libc.safe_strncpy_16", NULL, run_safe_strncpy_16},
+};
+
+/* -------------------- Runner -------------------- */
+
+// Sorts samples[] and returns the last result; the first call is a warm-up
+// so the flash prefetch and any lazy driver state are settled
+static int32_t measure(int32_t (*run)(void), uint32_t overhead) {
+  int32_t result = run();
+
+  for (uint32_t i = 0; i < BLFM_BENCH_RUNS; i++) {
+    __disable_irq();
+    uint32_t start = DWT->CYCCNT;
+    result = run();
+    uint32_t cycles = DWT->CYCCNT - start;
+    __enable_irq();
+
+    samples[i] = cycles > overhead ? cycles - overhead : 0;
+  }
+
+  // Insertion sort: the run count is small and this is off the clock
+  for (uint32_t i = 1; i < BLFM_BENCH_RUNS; i++) {
+    uint32_t v = samples[i];
+    uint32_t j = i;
+    while (j > 0 && samples[j - 1] > v) {
+      samples[j] = samples[j - 1];
+      j--;
+    }
+    samples[j] = v;
+  }
+  return result;
+}
+
+void blfm_bench_run(void) {
+  uint32_t count = sizeof(benches) / sizeof(benches[0]);
+
+  blfm_uart_flush();
+  measure(run_empty, 0);
+  uint32_t overhead = samples[0];
+
+  put_str("BENCH begin ");
+  put_u32(BLFM_BENCH_RUNS);
+  put_str(" ");
+  put_u32(configCPU_CLOCK_HZ);
+  put_str(" ");
+  put_u32(overhead);
+  put_str("\r\n");
+
+  for (uint32_t i = 0; i < count; i++) {
+    const blfm_bench_t *b = &benches[i];
+    if (b->setup) {
+      b->setup();
+    }
+    // DMA draining the last report line would steal bus cycles
+    blfm_uart_flush();
+    int32_t result = measure(b->run, overhead);
+
+    put_str("BENCH ");
+    put_str(b->name);
+    put_str(" ");
+    put_u32(samples[0]);
+    put_str(" ");
+    put_u32(samples[BLFM_BENCH_RUNS / 2]);
+    put_str(" ");
+    put_u32(samples[BLFM_BENCH_RUNS - 1]);
+    put_str(" ");
+    put_i32(result);
+    put_str("\r\n");
+  }
+
+  put_str("BENCH end ");
+  put_u32(count);
+  put_str("\r\n");
+}
+
+#endif /* BLFM_ENABLED_BENCH */
@@ -0,0 +1,146 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_cpuload.h"
+#include "FreeRTOS.h"
+#include "blfm_config.h"
+#include "blfm_trace.h"
+#include "libc_stubs.h"
+#include "stm32f1xx.h"
+#include "task.h"
+
+#define TICK_COUNTS (configCPU_CLOCK_HZ / configTICK_RATE_HZ)
+
+static blfm_cpuload_entry_t task_entries[BLFM_CPULOAD_TASK_SLOTS];
+static blfm_cpuload_entry_t isr_entries[BLFM_ISR_COUNT];
+static uint32_t context_switches;
+
+static uint8_t current_slot = BLFM_CPULOAD_SLOT_OTHER;
+static uint32_t slice_start;
+static TickType_t init_tick;
+
+static volatile uint8_t isr_depth;
+static volatile uint32_t isr_stolen; // ISR cycles inside the current slice
+
+static void charge(blfm_cpuload_entry_t *entry, uint32_t cycles) {
+  entry->total_cycles += cycles;
+  if (cycles > entry->peak_cycles) {
+    entry->peak_cycles = cycles;
+  }
+}
+
+void blfm_cpuload_init(void) {
+  memset(task_entries, 0, sizeof(task_entries));
+  memset(isr_entries, 0, sizeof(isr_entries));
+  context_switches = 0;
+  current_slot = BLFM_CPULOAD_SLOT_OTHER;
+  isr_stolen = 0;
+  init_tick = xTaskGetTickCount();
+  slice_start = DWT->CYCCNT;
+}
+
+void blfm_cpuload_register_task(TaskHandle_t handle, blfm_task_id_t id) {
+  if (!handle || id >= BLFM_TASK_COUNT)
+    return;
+  // Zero is what untagged tasks carry, so slots are stored one up
+  vTaskSetTaskNumber(handle, (UBaseType_t)id + 1);
+}
+
+uint32_t blfm_cpuload_isr_enter(blfm_isr_id_t id) {
+#if BLFM_ENABLED_TRACE
+  blfm_trace_record(BLFM_TRACE_ISR_ENTER, id, 0);
+#else
+  (void)id;
+#endif
+  isr_depth++;
+  return DWT->CYCCNT;
+}
+
+void blfm_cpuload_isr_exit(blfm_isr_id_t id, uint32_t entered) {
+  uint32_t cycles = DWT->CYCCNT - entered;
+
+  isr_entries[id].activations++;
+  charge(&isr_entries[id], cycles);
+
+  // A nested ISR is already inside the outer one's cycles
+  if (--isr_depth == 0) {
+    isr_stolen += cycles;
+  }
+
+#if BLFM_ENABLED_TRACE
+  blfm_trace_record(BLFM_TRACE_ISR_EXIT, id, 0);
+#endif
+}
+
+// Runs inside vTaskSwitchContext with kernel interrupts masked
+void blfm_cpuload_task_switched_in(uint32_t task_number) {
+  uint32_t now = DWT->CYCCNT;
+  uint8_t slot;
+
+  if (task_number > 0 && task_number <= BLFM_CPULOAD_TASK_SLOTS) {
+    slot = (uint8_t)(task_number - 1);
+  } else if (xTaskGetCurrentTaskHandle() == xTaskGetIdleTaskHandle()) {
+    // The kernel creates the idle task; tag it the first time it runs
+    slot = BLFM_CPULOAD_SLOT_IDLE;
+    vTaskSetTaskNumber(xTaskGetIdleTaskHandle(), slot + 1);
+  } else {
+    slot = BLFM_CPULOAD_SLOT_OTHER;
+  }
+
+  if (slot == current_slot)
+    return;
+
+  uint32_t ran = now - slice_start;
+  ran = ran > isr_stolen ? ran - isr_stolen : 0;
+  charge(&task_entries[current_slot], ran);
+
+  isr_stolen = 0;
+  slice_start = now;
+  current_slot = slot;
+  context_switches++;
+  task_entries[slot].activations++;
+}
+
+static uint8_t idle_percent(uint64_t elapsed, uint64_t busy) {
+  if (elapsed == 0 || busy >= elapsed)
+    return 0;
+
+  uint64_t idle = elapsed - busy;
+  // Scale down so the division stays 32-bit; there is no libgcc
+  while (elapsed > UINT32_MAX / 100) {
+    elapsed >>= 1;
+    idle >>= 1;
+  }
+  return (uint8_t)((uint32_t)idle * 100 / (uint32_t)elapsed);
+}
+
+void blfm_cpuload_get_stats(blfm_cpuload_stats_t *out) {
+  if (!out)
+    return;
+
+  taskENTER_CRITICAL();
+  memcpy(out->tasks, task_entries, sizeof(task_entries));
+  memcpy(out->isrs, isr_entries, sizeof(isr_entries));
+  out->context_switches = context_switches;
+  out->elapsed_cycles =
+      (uint64_t)(xTaskGetTickCount() - init_tick) * TICK_COUNTS;
+  taskEXIT_CRITICAL();
+
+  out->busy_cycles = 0;
+  for (uint8_t i = 0; i < BLFM_CPULOAD_TASK_SLOTS; i++) {
+    if (i != BLFM_CPULOAD_SLOT_IDLE) {
+      out->busy_cycles += out->tasks[i].total_cycles;
+    }
+  }
+  for (uint8_t i = 0; i < BLFM_ISR_COUNT; i++) {
+    out->busy_cycles += out->isrs[i].total_cycles;
+  }
+  out->idle_percent = idle_percent(out->elapsed_cycles, out->busy_cycles);
+}
@@ -0,0 +1,134 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_latency.h"
+#include "FreeRTOS.h"
+#include "libc_stubs.h"
+#include "stm32f1xx.h"
+#include "task.h"
+
+#define CYCLES_PER_US (configCPU_CLOCK_HZ / 1000000)
+#define US_PER_TICK (1000000 / configTICK_RATE_HZ)
+
+// Paths start at 1
+static blfm_latency_hist_t hists[BLFM_LATENCY_PATH_COUNT - 1]
+                                [BLFM_LATENCY_SEG_COUNT];
+static uint16_t next_id;
+
+void blfm_latency_origin(blfm_corr_t *corr, blfm_latency_path_t path,
+                         uint32_t cycles, uint32_t tick) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (++next_id == 0) {
+    next_id = 1;
+  }
+  corr->id = next_id;
+  __set_PRIMASK(primask);
+
+  corr->path = (uint8_t)path;
+  corr->origin.cycles = cycles;
+  corr->origin.tick = tick;
+}
+
+void blfm_latency_stamp(blfm_stamp_t *stamp) {
+  stamp->cycles = DWT->CYCCNT;
+  stamp->tick = xTaskGetTickCount();
+}
+
+void blfm_latency_begin(blfm_actuator_command_t *cmd, const blfm_corr_t *corr) {
+  if (!cmd)
+    return;
+
+  memset(&cmd->latency, 0, sizeof(cmd->latency));
+  if (!corr || corr->id == 0)
+    return;
+
+  cmd->latency.corr = *corr;
+  blfm_latency_stamp(&cmd->latency.dequeued);
+}
+
+void blfm_latency_publish(blfm_actuator_command_t *cmd) {
+  if (cmd && cmd->latency.corr.id != 0) {
+    blfm_latency_stamp(&cmd->latency.published);
+  }
+}
+
+static uint32_t elapsed_us(const blfm_stamp_t *from, const blfm_stamp_t *to) {
+  uint32_t us = (to->cycles - from->cycles) / CYCLES_PER_US;
+  uint32_t ticks = to->tick - from->tick;
+
+  // CYCCNT misses WFI and STOP; a tick gap beyond one says it slept
+  if (ticks > 1) {
+    uint32_t tick_us = (ticks - 1) * US_PER_TICK;
+    if (tick_us > us) {
+      us = tick_us;
+    }
+  }
+  return us;
+}
+
+static void add(blfm_latency_hist_t *hist, uint32_t us) {
+  uint8_t bucket = 0;
+  if (us > 1) {
+    bucket = (uint8_t)(31 - __builtin_clz(us));
+    if (bucket >= BLFM_LATENCY_BUCKETS) {
+      bucket = BLFM_LATENCY_BUCKETS - 1;
+    }
+  }
+
+  hist->count++;
+  if (us > hist->max_us) {
+    hist->max_us = us;
+  }
+  if (hist->bucket[bucket] != UINT16_MAX) {
+    hist->bucket[bucket]++;
+  }
+}
+
+void blfm_latency_applied(const blfm_actuator_command_t *cmd) {
+  const blfm_latency_stamps_t *lat = &cmd->latency;
+  if (lat->corr.id == 0 || lat->corr.path == 0 ||
+      lat->corr.path >= BLFM_LATENCY_PATH_COUNT)
+    return;
+
+  blfm_stamp_t now;
+  blfm_latency_stamp(&now);
+
+  blfm_latency_hist_t *row = hists[lat->corr.path - 1];
+  taskENTER_CRITICAL();
+  add(&row[BLFM_LATENCY_SEG_TO_CONTROLLER],
+      elapsed_us(&lat->corr.origin, &lat->dequeued));
+  add(&row[BLFM_LATENCY_SEG_CONTROLLER],
+      elapsed_us(&lat->dequeued, &lat->published));
+  add(&row[BLFM_LATENCY_SEG_TO_ACTUATOR], elapsed_us(&lat->published, &now));
+  add(&row[BLFM_LATENCY_SEG_TOTAL], elapsed_us(&lat->corr.origin, &now));
+  taskEXIT_CRITICAL();
+}
+
+void blfm_latency_get(blfm_latency_path_t path, blfm_latency_seg_t seg,
+                      blfm_latency_hist_t *out) {
+  if (!out)
+    return;
+  if (path == 0 || path >= BLFM_LATENCY_PATH_COUNT ||
+      seg >= BLFM_LATENCY_SEG_COUNT) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+
+  taskENTER_CRITICAL();
+  *out = hists[path - 1][seg];
+  taskEXIT_CRITICAL();
+}
+
+void blfm_latency_reset(void) {
+  taskENTER_CRITICAL();
+  memset(hists, 0, sizeof(hists));
+  taskEXIT_CRITICAL();
+}
@@ -9,16 +9,168 @@
  */
 
 #include "blfm_monitoring.h"
+#include "blfm_config.h"
+#include "libc_stubs.h"
+#include "task.h"
+
+static blfm_monitoring_report_t report;
+static uint8_t queue_peaks[BLFM_MONITORING_MAX_QUEUES];
+static uint16_t queue_full[BLFM_MONITORING_MAX_QUEUES];
+static int health;
+// Far too big for the monitoring task's stack
+static blfm_cpuload_stats_t cpu;
 
 void blfm_monitoring_init(void) {
-  // Initialize monitoring sensors, variables, counters
+  memset(&report, 0, sizeof(report));
+  memset(queue_peaks, 0, sizeof(queue_peaks));
+  memset(queue_full, 0, sizeof(queue_full));
+  health = 0;
+}
+
+void blfm_monitoring_register_queue(QueueHandle_t queue, const char *name) {
+  if (!queue || report.queue_count >= BLFM_MONITORING_MAX_QUEUES)
+    return;
+
+  uint8_t slot = report.queue_count++;
+  report.queues[slot].name = name;
+  report.queues[slot].length = (uint8_t)(uxQueueMessagesWaiting(queue) +
+                                         uxQueueSpacesAvailable(queue));
+  // Zero is what untracked queues carry, so slots are stored one up
+  vQueueSetQueueNumber(queue, slot + 1);
+}
+
+// Runs inside the kernel's send path, from tasks and ISRs alike
+void blfm_monitoring_queue_send(uint32_t queue_number, uint32_t waiting,
+                                uint32_t length) {
+  if (queue_number == 0 || queue_number > BLFM_MONITORING_MAX_QUEUES)
+    return;
+
+  // The item is not copied in yet; an overwrite keeps the depth at length
+  uint32_t depth = waiting < length ? waiting + 1 : length;
+  uint8_t *peak = &queue_peaks[queue_number - 1];
+  if (depth > *peak) {
+    *peak = (uint8_t)depth;
+  }
+}
+
+// Also runs inside the kernel: a send that found no space, whether it then
+// blocked or gave up. Reaching the length is fine, being turned away is not
+void blfm_monitoring_queue_full(uint32_t queue_number) {
+  if (queue_number == 0 || queue_number > BLFM_MONITORING_MAX_QUEUES)
+    return;
+
+  uint16_t *full = &queue_full[queue_number - 1];
+  if (*full < UINT16_MAX) {
+    (*full)++;
+  }
+}
+
+static void sample_stack(blfm_monitoring_stack_t *stack, TaskHandle_t handle,
+                         uint16_t size_words) {
+  if (!handle) {
+    stack->size_words = 0;
+    stack->free_min = 0;
+    stack->low = false;
+    return;
+  }
+
+  stack->size_words = size_words;
+  stack->free_min = (uint16_t)uxTaskGetStackHighWaterMark(handle);
+  stack->low = stack->free_min <
+               (uint32_t)size_words * BLFM_MONITORING_STACK_MARGIN_PERCENT / 100;
+}
+
+void blfm_monitoring_sample(void) {
+  blfm_monitoring_report_t next = report;
+  int flags = 0;
+
+  for (uint8_t i = 0; i < BLFM_TASK_COUNT; i++) {
+    blfm_task_id_t id = (blfm_task_id_t)i;
+    sample_stack(&next.stacks[i], blfm_taskmanager_get_handle(id),
+                 blfm_taskmanager_get_stack_words(id));
+  }
+  sample_stack(&next.stacks[BLFM_MONITORING_STACK_IDLE],
+               xTaskGetIdleTaskHandle(), configMINIMAL_STACK_SIZE);
+
+  for (uint8_t i = 0; i < BLFM_MONITORING_STACKS; i++) {
+    if (next.stacks[i].low) {
+      flags |= BLFM_HEALTH_STACK_LOW;
+    }
+  }
+
+  taskENTER_CRITICAL();
+  for (uint8_t i = 0; i < next.queue_count; i++) {
+    next.queues[i].peak = queue_peaks[i];
+    next.queues[i].full = queue_full[i];
+  }
+  taskEXIT_CRITICAL();
+
+  for (uint8_t i = 0; i < next.queue_count; i++) {
+    if (next.queues[i].full) {
+      flags |= BLFM_HEALTH_QUEUE_FULL;
+    }
+  }
+
+#if configSUPPORT_DYNAMIC_ALLOCATION
+  HeapStats_t heap;
+  vPortGetHeapStats(&heap);
+  next.heap_free = heap.xAvailableHeapSpaceInBytes;
+  next.heap_min_free = heap.xMinimumEverFreeBytesRemaining;
+  next.heap_largest_block = heap.xSizeOfLargestFreeBlockInBytes;
+  next.heap_fragmentation =
+      heap.xAvailableHeapSpaceInBytes
+          ? (uint8_t)(100 - heap.xSizeOfLargestFreeBlockInBytes * 100 /
+                                heap.xAvailableHeapSpaceInBytes)
+          : 0;
+  if (next.heap_min_free < BLFM_MONITORING_HEAP_MARGIN_BYTES) {
+    flags |= BLFM_HEALTH_HEAP_LOW;
+  }
+#endif
+
+  blfm_cpuload_get_stats(&cpu);
+  for (uint8_t i = 0; i < BLFM_CPULOAD_TASK_SLOTS; i++) {
+    next.task_cycles[i] = cpu.tasks[i].total_cycles;
+  }
+  next.idle_percent = cpu.idle_percent;
+
+  next.samples++;
+
+  taskENTER_CRITICAL();
+  report = next;
+  health = flags;
+  taskEXIT_CRITICAL();
+}
+
+void blfm_monitoring_get_report(blfm_monitoring_report_t *out) {
+  if (!out)
+    return;
+
+  taskENTER_CRITICAL();
+  *out = report;
+  taskEXIT_CRITICAL();
+}
+
+int blfm_monitoring_check_health(void) {
+  return health;
 }
 
 void blfm_monitoring_task(void *params) {
   (void)params;
-  // TODO: Implement blfm_monitoring
+  TickType_t release = xTaskGetTickCount();
+
+  blfm_taskmanager_cycle_begin(BLFM_TASK_MONITORING, release);
+  for (;;) {
+    blfm_monitoring_sample();
+    blfm_taskmanager_next_cycle(BLFM_TASK_MONITORING, &release);
+  }
 }
 
-int blfm_monitoring_check_health(void) {
-  return 0;
+// configCHECK_FOR_STACK_OVERFLOW: the stack is already corrupt, so stop here
+// where a debugger can still see which task it was
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName) {
+  (void)xTask;
+  (void)pcTaskName;
+  taskDISABLE_INTERRUPTS();
+  for (;;)
+    ;
 }
@@ -9,8 +9,330 @@
  */
 
 #include "blfm_power.h"
+#include "FreeRTOS.h"
+#include "blfm_clock.h"
+#include "blfm_cpuload.h"
+#include "blfm_i2c1.h"
+#include "blfm_trace.h"
+#include "blfm_config.h"
+#include "stm32f1xx.h"
+#include "task.h"
+#include <stdbool.h>
 
-void blfm_power_dummy(void) {
-    // TODO: Implement blfm_power
+#if BLFM_POWER_STOP_MODE && BLFM_SENSOR_CYCLIC_EXEC
+#error "STOP mode halts TIM3 and would stall the cyclic executive"
+#endif
+
+#define TICK_COUNTS (configCPU_CLOCK_HZ / configTICK_RATE_HZ)
+#define MAX_SUPPRESSED_TICKS (SysTick_LOAD_RELOAD_Msk / TICK_COUNTS)
+#define CYCLES_PER_MS (configCPU_CLOCK_HZ / 1000)
+
+// SysTick runs from the core clock, as the port sets it up
+#define SYSTICK_STOPPED (SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk)
+#define SYSTICK_RUNNING (SYSTICK_STOPPED | SysTick_CTRL_ENABLE_Msk)
+
+static blfm_power_stats_t power_stats;
+static uint32_t asleep_cycles; // Part of a millisecond not yet in asleep_ms
+static uint8_t clock_holds;
+
+static void account_sleep(uint32_t cycles) {
+  asleep_cycles += cycles;
+  power_stats.asleep_ms += asleep_cycles / CYCLES_PER_MS;
+  asleep_cycles %= CYCLES_PER_MS;
+}
+
+/*
+ * Same algorithm as the port's default tickless idle, except that the time
+ * SysTick spends stopped around the sleep is measured with DWT->CYCCNT
+ * instead of using a fixed estimate, so the tick count does not drift.
+ * Called with interrupts disabled.
+ */
+static void sleep_wfi(TickType_t idle) {
+  if (idle > MAX_SUPPRESSED_TICKS)
+    idle = MAX_SUPPRESSED_TICKS;
+
+  uint32_t stopped_at = DWT->CYCCNT;
+  SysTick->CTRL = SYSTICK_STOPPED;
+
+  uint32_t left = SysTick->VAL;
+  if (left == 0)
+    left = TICK_COUNTS;
+  uint32_t reload = left + TICK_COUNTS * (idle - 1);
+
+  // A tick that fired after interrupts were masked is counted by the sleep
+  if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+    SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+    reload -= TICK_COUNTS;
+  }
+
+  uint32_t stopped = DWT->CYCCNT - stopped_at;
+  if (reload > stopped)
+    reload -= stopped;
+
+  SysTick->LOAD = reload;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SYSTICK_RUNNING;
+
+  __DSB();
+  __WFI();
+  __ISB();
+
+  stopped_at = DWT->CYCCNT;
+  SysTick->CTRL = SYSTICK_STOPPED;
+
+  uint32_t complete;
+  uint32_t next_load;
+  if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+    // Woken by the tick itself; the pending SysTick adds the last tick
+    uint32_t overrun = reload - SysTick->VAL;
+    next_load = (TICK_COUNTS - 1) - overrun;
+    if (next_load > TICK_COUNTS)
+      next_load = TICK_COUNTS - 1;
+    complete = idle - 1;
+    account_sleep(reload + overrun);
+  } else {
+    // Woken early by another interrupt
+    uint32_t left_now = SysTick->VAL;
+    uint32_t elapsed = idle * TICK_COUNTS - left_now;
+    complete = elapsed / TICK_COUNTS;
+    next_load = (complete + 1) * TICK_COUNTS - elapsed;
+    account_sleep(reload - left_now);
+  }
+
+  // Finish the current tick short by however long SysTick was stopped
+  stopped = DWT->CYCCNT - stopped_at;
+  if (next_load > stopped + 1)
+    next_load -= stopped;
+
+  SysTick->LOAD = next_load;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SYSTICK_RUNNING;
+  SysTick->LOAD = TICK_COUNTS - 1;
+
+  vTaskStepTick(complete);
+  power_stats.sleeps++;
+#if BLFM_ENABLED_TRACE
+  blfm_trace_record(BLFM_TRACE_SLEEP, 0, (uint16_t)complete);
+#endif
+}
+
+#if BLFM_POWER_STOP_MODE
+
+// LSE 32.768 kHz divided by 32
+#define RTC_HZ 1024
+#define RTC_PRESCALER (32768 / RTC_HZ)
+#define RTC_ALARM_IRQ_PRIORITY 15
+// Longer idle times are slept in several pieces
+#define MAX_STOP_TICKS (60 * configTICK_RATE_HZ)
+
+static bool rtc_ready;
+static uint32_t rtc_remainder; // RTC counts * tick rate not yet stepped
+
+static void rtc_wait_write(void) {
+  while (!(RTC->CRL & RTC_CRL_RTOFF))
+    ;
+}
+
+// RTC registers read stale values until resynchronised after reset or STOP
+static void rtc_sync(void) {
+  RTC->CRL &= ~RTC_CRL_RSF;
+  while (!(RTC->CRL & RTC_CRL_RSF))
+    ;
+}
+
+static uint32_t rtc_counter(void) {
+  uint16_t high = RTC->CNTH;
+  uint16_t low = RTC->CNTL;
+  if (RTC->CNTH != high) {
+    high = RTC->CNTH;
+    low = RTC->CNTL;
+  }
+  return ((uint32_t)high << 16) | low;
+}
+
+static void rtc_set_alarm(uint32_t at) {
+  rtc_wait_write();
+  RTC->CRL |= RTC_CRL_CNF;
+  RTC->ALRH = at >> 16;
+  RTC->ALRL = at & 0xFFFF;
+  RTC->CRL &= ~RTC_CRL_CNF;
+  rtc_wait_write();
 }
 
+/*
+ * The LSE can take a couple of seconds to start, so the RTC is set up from
+ * the idle task once the crystal is ready instead of stalling boot. Until
+ * then every idle period sleeps in WFI.
+ */
+static bool rtc_start(void) {
+  if (rtc_ready)
+    return true;
+  if (!(RCC->BDCR & RCC_BDCR_LSERDY))
+    return false;
+
+  if (!(RCC->BDCR & RCC_BDCR_RTCEN)) {
+    RCC->BDCR |= RCC_BDCR_RTCSEL_LSE | RCC_BDCR_RTCEN;
+  }
+  rtc_sync();
+
+  rtc_wait_write();
+  RTC->CRL |= RTC_CRL_CNF;
+  RTC->PRLH = 0;
+  RTC->PRLL = RTC_PRESCALER - 1;
+  RTC->CRL &= ~RTC_CRL_CNF;
+  rtc_wait_write();
+
+  // The alarm reaches the NVIC, and wakes STOP, through EXTI line 17
+  EXTI->IMR |= EXTI_IMR_MR17;
+  EXTI->RTSR |= EXTI_RTSR_TR17;
+  NVIC_SetPriority(RTC_Alarm_IRQn, RTC_ALARM_IRQ_PRIORITY);
+  NVIC_EnableIRQ(RTC_Alarm_IRQn);
+
+  rtc_ready = true;
+  return true;
+}
+
+// Called with interrupts disabled and no tick pending
+static void sleep_stop(TickType_t idle) {
+  if (idle > MAX_STOP_TICKS)
+    idle = MAX_STOP_TICKS;
+
+  SysTick->CTRL = SYSTICK_STOPPED;
+
+  // Wake a tick early: restarting the HSE and the PLL takes about that long
+  uint32_t start = rtc_counter();
+  rtc_set_alarm(start + ((idle - 1) * RTC_HZ) / configTICK_RATE_HZ);
+  RTC->CRL &= ~RTC_CRL_ALRF;
+  EXTI->PR = EXTI_PR_PR17;
+
+  PWR->CR &= ~PWR_CR_PDDS;
+  PWR->CR |= PWR_CR_LPDS;
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+
+  __DSB();
+  __WFI();
+  __ISB();
+
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+  // STOP leaves the core on the HSI
+  blfm_clock_init();
+
+  rtc_sync();
+  uint32_t total = (rtc_counter() - start) * configTICK_RATE_HZ + rtc_remainder;
+  uint32_t complete = total / RTC_HZ;
+  rtc_remainder = total % RTC_HZ;
+
+  if (complete >= idle) {
+    // Overslept: step to the deadline and let a pended tick release it
+    complete = idle - 1;
+    rtc_remainder = 0;
+    SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+    account_sleep(TICK_COUNTS);
+  }
+  account_sleep(complete * TICK_COUNTS);
+
+  // The phase of the interrupted tick is lost, at most one tick per STOP
+  SysTick->LOAD = TICK_COUNTS - 1;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SYSTICK_RUNNING;
+
+  vTaskStepTick(complete);
+  power_stats.stops++;
+#if BLFM_ENABLED_TRACE
+  blfm_trace_record(BLFM_TRACE_SLEEP, 0, (uint16_t)complete);
+#endif
+}
+
+void RTC_Alarm_IRQHandler(void) {
+  uint32_t entered = blfm_cpuload_isr_enter(BLFM_ISR_RTC_ALARM);
+  EXTI->PR = EXTI_PR_PR17;
+  RTC->CRL &= ~RTC_CRL_ALRF;
+  blfm_cpuload_isr_exit(BLFM_ISR_RTC_ALARM, entered);
+}
+
+// STOP halts the bus clock under a transaction, which would then time out
+static bool i2c1_busy(void) {
+#if BLFM_I2C1_ASYNC
+  return blfm_i2c1_busy();
+#else
+  return false;
+#endif
+}
+
+#endif /* BLFM_POWER_STOP_MODE */
+
+void blfm_power_init(void) {
+#if BLFM_POWER_STOP_MODE
+  RCC->APB1ENR |= RCC_APB1ENR_PWREN | RCC_APB1ENR_BKPEN;
+  PWR->CR |= PWR_CR_DBP;
+
+  // The backup domain survives resets; drop an RTC left on another clock
+  uint32_t source = RCC->BDCR & RCC_BDCR_RTCSEL;
+  if (source != 0 && source != RCC_BDCR_RTCSEL_LSE) {
+    RCC->BDCR |= RCC_BDCR_BDRST;
+    RCC->BDCR &= ~RCC_BDCR_BDRST;
+  }
+  RCC->BDCR |= RCC_BDCR_LSEON;
+#endif
+}
+
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime) {
+  __disable_irq();
+  __DSB();
+  __ISB();
+
+  if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+    power_stats.aborted++;
+    __enable_irq();
+    return;
+  }
+
+#if BLFM_POWER_STOP_MODE
+  if (xExpectedIdleTime >= pdMS_TO_TICKS(BLFM_POWER_STOP_MIN_MS) &&
+      clock_holds == 0 && !i2c1_busy() &&
+      !(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && rtc_start()) {
+    sleep_stop(xExpectedIdleTime);
+  } else {
+    sleep_wfi(xExpectedIdleTime);
+  }
+#else
+  sleep_wfi(xExpectedIdleTime);
+#endif
+
+  __enable_irq();
+}
+
+// DBG_SLEEP leaves FCLK and HCLK running in sleep mode
+void blfm_power_hold_clock(void) {
+  UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+  if (clock_holds++ == 0) {
+    DBGMCU->CR |= DBGMCU_CR_DBG_SLEEP;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+void blfm_power_release_clock(void) {
+  UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+  // An attached debugger wants the clock kept as well
+  if (clock_holds > 0 && --clock_holds == 0 &&
+      !(CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk)) {
+    DBGMCU->CR &= ~DBGMCU_CR_DBG_SLEEP;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+void blfm_power_get_stats(blfm_power_stats_t *out) {
+  if (!out)
+    return;
+
+  TickType_t uptime = xTaskGetTickCount();
+
+  taskENTER_CRITICAL();
+  *out = power_stats;
+  taskEXIT_CRITICAL();
+
+  uint32_t uptime_ms = (uptime / configTICK_RATE_HZ) * 1000 +
+                       (uptime % configTICK_RATE_HZ) * 1000 / configTICK_RATE_HZ;
+  out->awake_ms = uptime_ms > out->asleep_ms ? uptime_ms - out->asleep_ms : 0;
+}
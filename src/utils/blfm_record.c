@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_record.h"
+#include "libc_stubs.h"
+
+static const uint8_t magic[4] = {'B', 'L', 'R', 'C'};
+
+/* -------------------- Encoding -------------------- */
+
+static uint8_t *put_u8(uint8_t *p, uint8_t v) {
+  *p++ = v;
+  return p;
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+  *p++ = (uint8_t)v;
+  *p++ = (uint8_t)(v >> 8);
+  return p;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+  p = put_u16(p, (uint16_t)v);
+  return put_u16(p, (uint16_t)(v >> 16));
+}
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v) {
+  while (v >= 0x80) {
+    *p++ = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+uint32_t blfm_record_encode_header(uint8_t *buf) {
+  uint8_t *p = buf;
+  for (uint8_t i = 0; i < sizeof(magic); i++) {
+    p = put_u8(p, magic[i]);
+  }
+  p = put_u8(p, BLFM_RECORD_VERSION);
+  p = put_u32(p, BLFM_RECORD_CONFIG);
+  return (uint32_t)(p - buf);
+}
+
+uint32_t blfm_record_encode(const blfm_record_t *rec, uint32_t prev_tick,
+                            uint8_t *buf) {
+  uint8_t *p = buf;
+
+  p = put_u8(p, rec->type);
+  p = put_varint(p, rec->tick - prev_tick);
+
+  switch (rec->type) {
+  case BLFM_RECORD_SENSOR: {
+    const blfm_sensor_data_t *s = &rec->sensor;
+    p = put_u8(p, s->valid);
+    p = put_u16(p, s->ultrasonic.distance_mm);
+    p = put_u16(p, (uint16_t)s->imu.acc_x);
+    p = put_u16(p, (uint16_t)s->imu.acc_y);
+    p = put_u16(p, (uint16_t)s->imu.acc_z);
+    p = put_u16(p, (uint16_t)s->imu.gyro_x);
+    p = put_u16(p, (uint16_t)s->imu.gyro_y);
+    p = put_u16(p, (uint16_t)s->imu.gyro_z);
+    p = put_u32(p, (uint32_t)s->temperature.temperature_mc);
+    p = put_u16(p, s->potentiometer.raw_value);
+    for (uint8_t i = 0; i < BLFM_SENSOR_COUNT; i++) {
+      p = put_u32(p, s->timestamp[i]);
+    }
+    break;
+  }
+  case BLFM_RECORD_IR:
+    p = put_u32(p, rec->ir.timestamp);
+    p = put_u32(p, rec->ir.pulse_us);
+    p = put_u32(p, (uint32_t)rec->ir.command);
+    p = put_u16(p, rec->ir.address);
+    p = put_u8(p, rec->ir.protocol);
+    p = put_u8(p, rec->ir.repeat);
+    break;
+  case BLFM_RECORD_MODE_BUTTON:
+    p = put_u8(p, (uint8_t)rec->mode_button.event_type);
+    p = put_u32(p, rec->mode_button.timestamp);
+    break;
+  case BLFM_RECORD_BIGSOUND:
+    p = put_u8(p, (uint8_t)rec->bigsound.event_type);
+    p = put_u32(p, rec->bigsound.timestamp);
+    break;
+  case BLFM_RECORD_ESP32:
+    p = put_u8(p, (uint8_t)rec->esp32.command);
+    p = put_u8(p, rec->esp32.speed);
+    p = put_u32(p, rec->esp32.timestamp);
+    break;
+  case BLFM_RECORD_DROPPED:
+    p = put_u16(p, rec->dropped);
+    break;
+  case BLFM_RECORD_IR_TIMEOUT:
+  default:
+    break;
+  }
+  return (uint32_t)(p - buf);
+}
+
+/* -------------------- Decoding -------------------- */
+
+// Every getter checks the bounds itself, so a truncated record just fails
+typedef struct {
+  const uint8_t *p;
+  const uint8_t *end;
+  bool short_read;
+} reader_t;
+
+static uint8_t get_u8(reader_t *r) {
+  if (r->p >= r->end) {
+    r->short_read = true;
+    return 0;
+  }
+  return *r->p++;
+}
+
+static uint16_t get_u16(reader_t *r) {
+  uint16_t lo = get_u8(r);
+  return (uint16_t)(lo | (get_u8(r) << 8));
+}
+
+static uint32_t get_u32(reader_t *r) {
+  uint32_t lo = get_u16(r);
+  return lo | ((uint32_t)get_u16(r) << 16);
+}
+
+static uint32_t get_varint(reader_t *r) {
+  uint32_t v = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    uint8_t byte = get_u8(r);
+    v |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      break;
+  }
+  return v;
+}
+
+bool blfm_record_decode_header(const uint8_t *buf, uint32_t len,
+                               uint32_t *config) {
+  reader_t r = {.p = buf, .end = buf + len};
+
+  for (uint8_t i = 0; i < sizeof(magic); i++) {
+    if (get_u8(&r) != magic[i])
+      return false;
+  }
+  if (get_u8(&r) != BLFM_RECORD_VERSION)
+    return false;
+
+  uint32_t cfg = get_u32(&r);
+  if (r.short_read)
+    return false;
+  if (config) {
+    *config = cfg;
+  }
+  return true;
+}
+
+int32_t blfm_record_decode(const uint8_t *buf, uint32_t len,
+                           uint32_t prev_tick, blfm_record_t *rec) {
+  reader_t r = {.p = buf, .end = buf + len};
+
+  memset(rec, 0, sizeof(*rec));
+  rec->type = get_u8(&r);
+  rec->tick = prev_tick + get_varint(&r);
+
+  switch (rec->type) {
+  case BLFM_RECORD_SENSOR: {
+    blfm_sensor_data_t *s = &rec->sensor;
+    s->valid = get_u8(&r);
+    s->ultrasonic.distance_mm = get_u16(&r);
+    s->imu.acc_x = (int16_t)get_u16(&r);
+    s->imu.acc_y = (int16_t)get_u16(&r);
+    s->imu.acc_z = (int16_t)get_u16(&r);
+    s->imu.gyro_x = (int16_t)get_u16(&r);
+    s->imu.gyro_y = (int16_t)get_u16(&r);
+    s->imu.gyro_z = (int16_t)get_u16(&r);
+    s->temperature.temperature_mc = (int32_t)get_u32(&r);
+    s->potentiometer.raw_value = get_u16(&r);
+    for (uint8_t i = 0; i < BLFM_SENSOR_COUNT; i++) {
+      s->timestamp[i] = get_u32(&r);
+    }
+    break;
+  }
+  case BLFM_RECORD_IR:
+    rec->ir.timestamp = get_u32(&r);
+    rec->ir.pulse_us = get_u32(&r);
+    rec->ir.command = (blfm_ir_command_t)get_u32(&r);
+    rec->ir.address = get_u16(&r);
+    rec->ir.protocol = get_u8(&r);
+    rec->ir.repeat = get_u8(&r) != 0;
+    break;
+  case BLFM_RECORD_MODE_BUTTON:
+    rec->mode_button.event_type = (blfm_mode_button_event_type_t)get_u8(&r);
+    rec->mode_button.timestamp = get_u32(&r);
+    break;
+  case BLFM_RECORD_BIGSOUND:
+    rec->bigsound.event_type = (blfm_bigsound_event_type_t)get_u8(&r);
+    rec->bigsound.timestamp = get_u32(&r);
+    break;
+  case BLFM_RECORD_ESP32:
+    rec->esp32.command = (blfm_esp32_command_type_t)get_u8(&r);
+    rec->esp32.speed = get_u8(&r);
+    rec->esp32.timestamp = get_u32(&r);
+    break;
+  case BLFM_RECORD_DROPPED:
+    rec->dropped = get_u16(&r);
+    break;
+  case BLFM_RECORD_IR_TIMEOUT:
+    break;
+  default:
+    return r.short_read ? 0 : -1;
+  }
+
+  if (r.short_read)
+    return 0;
+  return (int32_t)(r.p - buf);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_config.h"
+#if BLFM_ENABLED_RECORD
+
+#if BLFM_ENABLED_TRACE
+#error "The recorder and the trace both stream on USART1; enable one of them"
+#endif
+
+#include "blfm_recorder.h"
+#include "FreeRTOS.h"
+#include "blfm_ringbuf.h"
+#include "blfm_taskmanager.h"
+#include "blfm_uart.h"
+#include "task.h"
+#include <stdbool.h>
+
+_Static_assert((BLFM_RECORD_RING_BYTES & (BLFM_RECORD_RING_BYTES - 1)) == 0,
+               "BLFM_RECORD_RING_BYTES must be a power of two");
+
+static uint8_t storage[BLFM_RECORD_RING_BYTES];
+static blfm_ringbuf_t ring;
+static uint32_t last_tick; // Of the last record that made it into the ring
+static uint32_t dropped_total;
+static uint32_t dropped_unsent;
+
+void blfm_recorder_init(void) {
+  bool ok = blfm_ringbuf_init(&ring, storage, sizeof(storage));
+  configASSERT(ok);
+  (void)ok;
+}
+
+uint32_t blfm_recorder_get_dropped(void) { return dropped_total; }
+
+static bool append(const blfm_record_t *rec) {
+  uint8_t buf[BLFM_RECORD_MAX_BYTES];
+  uint32_t len = blfm_record_encode(rec, last_tick, buf);
+
+  if (blfm_ringbuf_free(&ring) < len)
+    return false;
+
+  blfm_ringbuf_push(&ring, buf, len);
+  last_tick = rec->tick;
+  return true;
+}
+
+void blfm_recorder_log(uint8_t type, const void *input) {
+  blfm_record_t rec = {.type = type, .tick = xTaskGetTickCount()};
+
+  // Losses go in ahead of the record that follows them
+  if (dropped_unsent > 0) {
+    blfm_record_t dropped = {
+        .type = BLFM_RECORD_DROPPED,
+        .tick = rec.tick,
+        .dropped = dropped_unsent > 0xFFFF ? 0xFFFF : (uint16_t)dropped_unsent,
+    };
+    if (!append(&dropped)) {
+      dropped_total++;
+      dropped_unsent++;
+      return;
+    }
+    dropped_unsent = 0;
+  }
+
+  switch (type) {
+  case BLFM_RECORD_SENSOR:
+    rec.sensor = *(const blfm_sensor_data_t *)input;
+    break;
+  case BLFM_RECORD_IR:
+    rec.ir = *(const blfm_ir_remote_event_t *)input;
+    break;
+  case BLFM_RECORD_MODE_BUTTON:
+    rec.mode_button = *(const blfm_mode_button_event_t *)input;
+    break;
+  case BLFM_RECORD_BIGSOUND:
+    rec.bigsound = *(const blfm_bigsound_event_t *)input;
+    break;
+  case BLFM_RECORD_ESP32:
+    rec.esp32 = *(const blfm_esp32_event_t *)input;
+    break;
+  default:
+    break;
+  }
+
+  if (!append(&rec)) {
+    dropped_total++;
+    dropped_unsent++;
+  }
+}
+
+void blfm_recorder_task(void *params) {
+  (void)params;
+
+  uint8_t header[BLFM_RECORD_HEADER_BYTES];
+  uint32_t len = blfm_record_encode_header(header);
+  for (uint32_t i = 0; i < len; i++) {
+    blfm_uart_send_u8(header[i]);
+  }
+
+  for (;;) {
+    blfm_taskmanager_cycle_begin(BLFM_TASK_RECORD, xTaskGetTickCount());
+    const uint8_t *span;
+    // Records may split across writes; only what was queued is consumed
+    while ((len = blfm_ringbuf_read_span(&ring, &span)) > 0) {
+      uint32_t room = blfm_uart_tx_free();
+      if (room == 0)
+        break;
+      len = blfm_uart_write(span, len < room ? len : room);
+      blfm_ringbuf_consume(&ring, len);
+    }
+    blfm_taskmanager_cycle_end(BLFM_TASK_RECORD);
+    vTaskDelay(pdMS_TO_TICKS(BLFM_RECORD_DRAIN_MS));
+  }
+}
+
+#endif /* BLFM_ENABLED_RECORD */
@@ -0,0 +1,126 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_ringbuf.h"
+#include "libc_stubs.h"
+
+// The owner's own index needs no ordering; the other side's needs acquire
+#define LOAD_OWN(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define LOAD_PEER(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define PUBLISH(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+bool blfm_ringbuf_init(blfm_ringbuf_t *rb, uint8_t *storage, uint32_t size) {
+  if (!rb || !storage || size == 0 || (size & (size - 1)) != 0)
+    return false;
+
+  rb->buf = storage;
+  rb->mask = size - 1;
+  rb->head = 0;
+  rb->tail = 0;
+  return true;
+}
+
+uint32_t blfm_ringbuf_used(const blfm_ringbuf_t *rb) {
+  return LOAD_PEER(&rb->head) - LOAD_PEER(&rb->tail);
+}
+
+uint32_t blfm_ringbuf_free(const blfm_ringbuf_t *rb) {
+  return rb->mask + 1 - blfm_ringbuf_used(rb);
+}
+
+/* -------------------- Producer -------------------- */
+
+bool blfm_ringbuf_push_byte(blfm_ringbuf_t *rb, uint8_t byte) {
+  uint32_t head = LOAD_OWN(&rb->head);
+  if (head - LOAD_PEER(&rb->tail) > rb->mask)
+    return false;
+
+  rb->buf[head & rb->mask] = byte;
+  PUBLISH(&rb->head, head + 1);
+  return true;
+}
+
+uint32_t blfm_ringbuf_write_span(blfm_ringbuf_t *rb, uint8_t **span) {
+  uint32_t head = LOAD_OWN(&rb->head);
+  uint32_t space = rb->mask + 1 - (head - LOAD_PEER(&rb->tail));
+  uint32_t offset = head & rb->mask;
+  uint32_t to_end = rb->mask + 1 - offset;
+
+  *span = &rb->buf[offset];
+  return space < to_end ? space : to_end;
+}
+
+void blfm_ringbuf_commit(blfm_ringbuf_t *rb, uint32_t len) {
+  PUBLISH(&rb->head, LOAD_OWN(&rb->head) + len);
+}
+
+uint32_t blfm_ringbuf_push(blfm_ringbuf_t *rb, const uint8_t *data,
+                           uint32_t len) {
+  uint32_t written = 0;
+
+  // At most two spans: up to the end of storage, then from the start
+  for (uint8_t pass = 0; pass < 2 && written < len; pass++) {
+    uint8_t *span;
+    uint32_t n = blfm_ringbuf_write_span(rb, &span);
+    if (n == 0)
+      break;
+    if (n > len - written) {
+      n = len - written;
+    }
+    memcpy(span, data + written, n);
+    blfm_ringbuf_commit(rb, n);
+    written += n;
+  }
+  return written;
+}
+
+/* -------------------- Consumer -------------------- */
+
+bool blfm_ringbuf_pop_byte(blfm_ringbuf_t *rb, uint8_t *byte) {
+  uint32_t tail = LOAD_OWN(&rb->tail);
+  if (LOAD_PEER(&rb->head) == tail)
+    return false;
+
+  *byte = rb->buf[tail & rb->mask];
+  PUBLISH(&rb->tail, tail + 1);
+  return true;
+}
+
+uint32_t blfm_ringbuf_read_span(blfm_ringbuf_t *rb, const uint8_t **span) {
+  uint32_t tail = LOAD_OWN(&rb->tail);
+  uint32_t avail = LOAD_PEER(&rb->head) - tail;
+  uint32_t offset = tail & rb->mask;
+  uint32_t to_end = rb->mask + 1 - offset;
+
+  *span = &rb->buf[offset];
+  return avail < to_end ? avail : to_end;
+}
+
+void blfm_ringbuf_consume(blfm_ringbuf_t *rb, uint32_t len) {
+  PUBLISH(&rb->tail, LOAD_OWN(&rb->tail) + len);
+}
+
+uint32_t blfm_ringbuf_pop(blfm_ringbuf_t *rb, uint8_t *out, uint32_t len) {
+  uint32_t read = 0;
+
+  for (uint8_t pass = 0; pass < 2 && read < len; pass++) {
+    const uint8_t *span;
+    uint32_t n = blfm_ringbuf_read_span(rb, &span);
+    if (n == 0)
+      break;
+    if (n > len - read) {
+      n = len - read;
+    }
+    memcpy(out + read, span, n);
+    blfm_ringbuf_consume(rb, n);
+    read += n;
+  }
+  return read;
+}
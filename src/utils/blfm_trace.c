@@ -0,0 +1,188 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "blfm_config.h"
+#if BLFM_ENABLED_TRACE
+
+#include "blfm_trace.h"
+#include "FreeRTOS.h"
+#include "blfm_cpuload.h"
+#include "blfm_monitoring.h"
+#include "blfm_taskmanager.h"
+#include "blfm_uart.h"
+#include "libc_stubs.h"
+#include "stm32f1xx.h"
+#include "task.h"
+#include <stdbool.h>
+
+// Records sent per frame; the chunk is copied out so the ring frees up early
+#define DRAIN_CHUNK 32
+// "BLTR", count and dropped, then 8 bytes per record
+#define FRAME_HEADER_BYTES 8
+#define FRAME_RECORD_BYTES 8
+
+_Static_assert((BLFM_TRACE_RECORDS & (BLFM_TRACE_RECORDS - 1)) == 0,
+               "BLFM_TRACE_RECORDS must be a power of two");
+_Static_assert(sizeof(blfm_trace_record_t) == 8, "records are 8 bytes");
+
+static const char *const isr_names[BLFM_ISR_COUNT] = {
+    [BLFM_ISR_EXTI3] = "EXTI3",
+    [BLFM_ISR_EXTI4] = "EXTI4",
+    [BLFM_ISR_EXTI9_5] = "EXTI9_5",
+    [BLFM_ISR_TIM3] = "TIM3",
+    [BLFM_ISR_RTC_ALARM] = "RTC_Alarm",
+    [BLFM_ISR_TIM1_UP] = "TIM1_UP",
+    [BLFM_ISR_DMA1_CH4] = "DMA1_CH4",
+    [BLFM_ISR_DMA1_CH5] = "DMA1_CH5",
+    [BLFM_ISR_USART1] = "USART1",
+    [BLFM_ISR_I2C1_EV] = "I2C1_EV",
+    [BLFM_ISR_I2C1_ER] = "I2C1_ER",
+    [BLFM_ISR_DMA1_CH6] = "DMA1_CH6",
+    [BLFM_ISR_DMA1_CH7] = "DMA1_CH7",
+};
+
+static blfm_trace_record_t ring[BLFM_TRACE_RECORDS];
+static volatile uint32_t ring_head; // Written by the recorder only
+static volatile uint32_t ring_tail; // Written by the drain only
+static uint32_t dropped_total;
+static uint32_t dropped_unsent;
+
+void blfm_trace_record(uint8_t type, uint8_t id, uint16_t arg) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  uint32_t head = ring_head;
+  if (head - ring_tail >= BLFM_TRACE_RECORDS) {
+    dropped_total++;
+    dropped_unsent++;
+  } else {
+    blfm_trace_record_t *record = &ring[head & (BLFM_TRACE_RECORDS - 1)];
+    record->cycles = DWT->CYCCNT;
+    record->type = type;
+    record->id = id;
+    record->arg = arg;
+    ring_head = head + 1;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+uint32_t blfm_trace_get_dropped(void) {
+  return dropped_total;
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t val) {
+  *p++ = val & 0xFF;
+  *p++ = val >> 8;
+  return p;
+}
+
+static void send_magic(const char *magic) {
+  for (uint8_t i = 0; i < 4; i++) {
+    blfm_uart_send_u8((uint8_t)magic[i]);
+  }
+}
+
+static void send_name(uint8_t kind, uint8_t id, const char *name) {
+  if (!name)
+    return;
+
+  uint8_t len = (uint8_t)strlen(name);
+  send_magic("BLTN");
+  blfm_uart_send_u8(kind);
+  blfm_uart_send_u8(id);
+  blfm_uart_send_u8(len);
+  for (uint8_t i = 0; i < len; i++) {
+    blfm_uart_send_u8((uint8_t)name[i]);
+  }
+}
+
+// Ids match what the hooks record: task and queue numbers are slot + 1
+static void send_names(void) {
+  for (uint8_t i = 0; i < BLFM_TASK_COUNT; i++) {
+    TaskHandle_t handle = blfm_taskmanager_get_handle((blfm_task_id_t)i);
+    if (handle) {
+      send_name(BLFM_TRACE_NAME_TASK, i + 1, pcTaskGetName(handle));
+    }
+  }
+  send_name(BLFM_TRACE_NAME_TASK, BLFM_CPULOAD_SLOT_IDLE + 1, "IDLE");
+  send_name(BLFM_TRACE_NAME_TASK, 0, "other");
+
+  blfm_monitoring_report_t report;
+  blfm_monitoring_get_report(&report);
+  for (uint8_t i = 0; i < report.queue_count; i++) {
+    send_name(BLFM_TRACE_NAME_QUEUE, i + 1, report.queues[i].name);
+  }
+
+  for (uint8_t i = 0; i < BLFM_ISR_COUNT; i++) {
+    send_name(BLFM_TRACE_NAME_ISR, i, isr_names[i]);
+  }
+}
+
+// Returns false once the ring is empty, or the UART has no room for more
+static bool drain_chunk(void) {
+  uint8_t frame[FRAME_HEADER_BYTES + DRAIN_CHUNK * FRAME_RECORD_BYTES];
+  blfm_trace_record_t chunk[DRAIN_CHUNK];
+  uint16_t count = 0;
+  uint16_t dropped;
+
+  // Take no more than the UART can queue now; the rest stays in the ring
+  uint32_t room = blfm_uart_tx_free();
+  if (room < FRAME_HEADER_BYTES + FRAME_RECORD_BYTES)
+    return false;
+  uint32_t limit = (room - FRAME_HEADER_BYTES) / FRAME_RECORD_BYTES;
+  if (limit > DRAIN_CHUNK) {
+    limit = DRAIN_CHUNK;
+  }
+
+  taskENTER_CRITICAL();
+  uint32_t tail = ring_tail;
+  while (count < limit && tail != ring_head) {
+    chunk[count++] = ring[tail & (BLFM_TRACE_RECORDS - 1)];
+    tail++;
+  }
+  ring_tail = tail;
+  dropped = dropped_unsent > 0xFFFF ? 0xFFFF : (uint16_t)dropped_unsent;
+  dropped_unsent = 0;
+  taskEXIT_CRITICAL();
+
+  if (count == 0 && dropped == 0)
+    return false;
+
+  uint8_t *p = frame;
+  memcpy(p, "BLTR", 4);
+  p = put_u16(p + 4, count);
+  p = put_u16(p, dropped);
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t cycles = chunk[i].cycles;
+    p = put_u16(p, cycles & 0xFFFF);
+    p = put_u16(p, cycles >> 16);
+    *p++ = chunk[i].type;
+    *p++ = chunk[i].id;
+    p = put_u16(p, chunk[i].arg);
+  }
+  blfm_uart_write(frame, (uint32_t)(p - frame));
+  return count == DRAIN_CHUNK;
+}
+
+void blfm_trace_task(void *params) {
+  (void)params;
+
+  send_names();
+  for (;;) {
+    blfm_taskmanager_cycle_begin(BLFM_TASK_TRACE, xTaskGetTickCount());
+    while (drain_chunk())
+      ;
+    blfm_taskmanager_cycle_end(BLFM_TASK_TRACE);
+    vTaskDelay(pdMS_TO_TICKS(BLFM_TRACE_DRAIN_MS));
+  }
+}
+
+#endif /* BLFM_ENABLED_TRACE */
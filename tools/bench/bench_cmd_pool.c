@@ -0,0 +1,146 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Bytes copied per controller event on the actuator command path.
+ *
+ * "by value" replays the old pipeline: the whole blfm_actuator_command_t is
+ * copied into queue storage on send and out again on receive, exactly as
+ * FreeRTOS does for every queue item. "pool" runs the real blfm_cmd_pool with
+ * a one-byte handle queue. Both use the same byte-counting queue model.
+ */
+
+#include "FreeRTOS.h"
+#include "blfm_cmd_pool.h"
+#include "task.h"
+#include <stdio.h>
+#include <string.h>
+
+#define QUEUE_LENGTH 5
+#define EVENTS 10000
+
+typedef struct {
+  uint8_t storage[QUEUE_LENGTH * sizeof(blfm_actuator_command_t)];
+  size_t item_size;
+  unsigned head, count;
+  unsigned long bytes;
+} bench_queue_t;
+
+TickType_t xTaskGetTickCount(void) { return 0; }
+
+static void queue_init(bench_queue_t *q, size_t item_size) {
+  memset(q, 0, sizeof(*q));
+  q->item_size = item_size;
+}
+
+static int queue_send(bench_queue_t *q, const void *item) {
+  if (q->count == QUEUE_LENGTH)
+    return 0;
+  unsigned slot = (q->head + q->count) % QUEUE_LENGTH;
+  memcpy(&q->storage[slot * q->item_size], item, q->item_size);
+  q->bytes += q->item_size;
+  q->count++;
+  return 1;
+}
+
+static int queue_receive(bench_queue_t *q, void *item) {
+  if (q->count == 0)
+    return 0;
+  memcpy(item, &q->storage[q->head * q->item_size], q->item_size);
+  q->bytes += q->item_size;
+  q->head = (q->head + 1) % QUEUE_LENGTH;
+  q->count--;
+  return 1;
+}
+
+// Stand-in for a controller handler: touches a couple of fields
+static void controller_event(blfm_actuator_command_t *cmd, unsigned n) {
+  cmd->servo1.proportional_input = (int16_t)((n % 3) * 1000 - 1000);
+  cmd->led.mode = (n & 8) ? BLFM_LED_MODE_BLINK : BLFM_LED_MODE_OFF;
+}
+
+static volatile int16_t sink;
+
+static void actuator_apply(const blfm_actuator_command_t *cmd) {
+  sink = cmd->servo1.proportional_input;
+}
+
+static unsigned long run_by_value(unsigned burst) {
+  bench_queue_t q;
+  blfm_actuator_command_t produced, consumed;
+  memset(&produced, 0, sizeof(produced));
+  queue_init(&q, sizeof(blfm_actuator_command_t));
+
+  for (unsigned n = 0; n < EVENTS;) {
+    for (unsigned b = 0; b < burst && n < EVENTS; b++, n++) {
+      controller_event(&produced, n);
+      queue_send(&q, &produced);
+    }
+    while (queue_receive(&q, &consumed)) {
+      actuator_apply(&consumed);
+    }
+  }
+  return q.bytes;
+}
+
+static unsigned long run_pool(unsigned burst, blfm_cmd_pool_stats_t *stats) {
+  bench_queue_t q;
+  blfm_cmd_handle_t handle;
+  queue_init(&q, sizeof(blfm_cmd_handle_t));
+  blfm_cmd_pool_init();
+
+  for (unsigned n = 0; n < EVENTS;) {
+    for (unsigned b = 0; b < burst && n < EVENTS; b++, n++) {
+      blfm_actuator_command_t *cmd = blfm_cmd_pool_acquire(&handle);
+      if (!cmd)
+        continue;
+      controller_event(cmd, n);
+      blfm_cmd_pool_publish(handle);
+      if (!queue_send(&q, &handle)) {
+        blfm_cmd_pool_release(handle);
+      }
+    }
+    while (queue_receive(&q, &handle)) {
+      actuator_apply(blfm_cmd_pool_get(handle));
+      blfm_cmd_pool_release(handle);
+    }
+  }
+
+  blfm_cmd_pool_get_stats(stats);
+  return q.bytes + stats->bytes_copied;
+}
+
+int main(void) {
+  static const unsigned bursts[] = {1, 2, 4};
+
+  printf("sizeof(blfm_actuator_command_t) = %zu bytes\n",
+         sizeof(blfm_actuator_command_t));
+  printf("queue storage: by value %zu B (heap), pool %zu B queue + %zu B "
+         "static pool\n\n",
+         QUEUE_LENGTH * sizeof(blfm_actuator_command_t),
+         QUEUE_LENGTH * sizeof(blfm_cmd_handle_t),
+         BLFM_CMD_POOL_SIZE * sizeof(blfm_actuator_command_t));
+
+  printf("%-6s %16s %16s %8s %8s %10s\n", "burst", "by value B/event",
+         "pool B/event", "reused", "cloned", "exhausted");
+
+  for (unsigned i = 0; i < sizeof(bursts) / sizeof(bursts[0]); i++) {
+    blfm_cmd_pool_stats_t stats;
+    unsigned long before = run_by_value(bursts[i]);
+    unsigned long after = run_pool(bursts[i], &stats);
+
+    printf("%-6u %16.1f %16.1f %8lu %8lu %10lu\n", bursts[i],
+           (double)before / EVENTS, (double)after / EVENTS,
+           (unsigned long)stats.reused, (unsigned long)stats.cloned,
+           (unsigned long)stats.exhausted);
+  }
+
+  return 0;
+}
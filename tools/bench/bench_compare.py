@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (C) 2025 Masoud Bolhassani
+#
+# Compare two microbenchmark result files, typically one from the parent
+# commit and one from the change under test: host runs written with `-j`
+# (see tools/bench/microbench.h), in ns, or on-target reports captured by
+# bench_target.py, in cycles. Medians are compared; a benchmark that got
+# slower by more than the threshold is a regression and makes the exit
+# status non-zero. Benchmarks present in only one file are listed but not
+# judged.
+#
+# Usage: tools/bench/bench_compare.py [-t percent] base.json new.json
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    if data.get("format") != 1:
+        sys.exit("%s: unknown result format %r" % (path, data.get("format")))
+    return data, {b["name"]: b for b in data["benchmarks"]}
+
+
+def unit(data):
+    return data.get("unit", "ns")
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-t", "--threshold", type=float, default=10.0,
+                    help="slowdown in percent counted as a regression")
+    ap.add_argument("base")
+    ap.add_argument("new")
+    args = ap.parse_args()
+
+    base_data, base = load(args.base)
+    new_data, new = load(args.new)
+    if unit(base_data) != unit(new_data):
+        sys.exit("cannot compare %s with %s" % (unit(base_data),
+                                                unit(new_data)))
+    if base_data.get("compiler") != new_data.get("compiler"):
+        print("note: different compilers, %s vs %s" %
+              (base_data.get("compiler"), new_data.get("compiler")))
+
+    regressions = 0
+    key = "median_" + unit(base_data)
+    print("%-28s %12s %12s %8s" % ("benchmark", "base " + unit(base_data),
+                                    "new " + unit(new_data), "change"))
+    for name in list(base) + [n for n in new if n not in base]:
+        if name not in new or name not in base:
+            where = args.base if name in base else args.new
+            print("%-28s only in %s" % (name, where))
+            continue
+        b = base[name][key]
+        n = new[name][key]
+        change = (n - b) / b * 100 if b > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  faster"
+        print("%-28s %12g %12g %+7.1f%%%s" % (name, b, n, change, flag))
+
+    if regressions:
+        print("%d benchmark(s) slower by more than %g%%" %
+              (regressions, args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * GPIO, PWM, SPI1 and I2C1 drivers, built with BLFM_HAL_HOST=1, against
+ * the tools/hal peripheral models. Checks what each call does to the
+ * model and how it handles injected faults, and prints the register
+ * reads and writes it costs. Exits non-zero if any check fails.
+ *
+ * The I2C1 engine runs on the same models: the calling task's wait on its
+ * notification plays the interrupts, so a transaction goes through the
+ * whole event, DMA and error interrupt sequence before it returns.
+ */
+
+#include "blfm_config.h"
+#include "FreeRTOS.h"
+#include "blfm_cpuload.h"
+#include "blfm_gpio.h"
+#include "blfm_i2c1.h"
+#include "blfm_pwm.h"
+#include "blfm_spi.h"
+#include "hal_host.h"
+#include "task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IMU_ADDR 0x68
+
+static int failures;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL %s\n", what);
+    failures++;
+  }
+}
+
+// Register accesses summed over every modelled peripheral
+static hal_counts_t total_counts(void) {
+  hal_counts_t total = {0};
+  for (uint8_t p = 0; p < HAL_PERIPH_COUNT; p++) {
+    hal_counts_t c;
+    hal_host_get_counts((hal_periph_t)p, &c);
+    total.reads += c.reads;
+    total.writes += c.writes;
+  }
+  return total;
+}
+
+static void report(const char *op) {
+  hal_counts_t c = total_counts();
+  printf("%-32s %7lu %7lu\n", op, (unsigned long)c.reads,
+         (unsigned long)c.writes);
+  hal_host_clear_counts();
+}
+
+static void bench_gpio(void) {
+  hal_host_reset();
+  blfm_gpio_init();
+  report("gpio init");
+
+  blfm_gpio_config_output((uint32_t)GPIOC, 13);
+  report("gpio config_output");
+  check(((hal_host_peek(&GPIOC->CRH) >> 20) & 0xF) == 0x3, "PC13 output");
+
+  blfm_gpio_set_pin((uint32_t)GPIOC, 13);
+  report("gpio set_pin");
+  check(hal_host_peek(&GPIOC->ODR) & (1u << 13), "PC13 set");
+
+  blfm_gpio_toggle_pin((uint32_t)GPIOC, 13);
+  report("gpio toggle_pin");
+  check(!(hal_host_peek(&GPIOC->ODR) & (1u << 13)), "PC13 toggled");
+
+  blfm_gpio_config_input_pullup((uint32_t)GPIOB, 12);
+  hal_host_gpio_set_input(HAL_PERIPH_GPIOB, 12, false);
+  report("gpio config_input_pullup");
+  check(blfm_gpio_read_pin((uint32_t)GPIOB, 12) == 0, "PB12 driven low");
+  report("gpio read_pin");
+}
+
+static void bench_pwm(void) {
+  hal_host_reset();
+  blfm_pwm_init();
+  report("pwm init");
+
+  blfm_pwm_set_pulse_us(0, 1234);
+  blfm_pwm_generate_cycle();
+#if BLFM_ENABLED_SERVO1
+  uint32_t width = hal_host_gpio_pulse_us(HAL_PERIPH_GPIOA, 0);
+  check(width >= 1234 && width <= 1236, "PA0 pulse width");
+#endif
+  report("pwm generate_cycle (1234 us)");
+}
+
+static uint8_t spi_responder(uint8_t mosi) { return (uint8_t)~mosi; }
+
+static void bench_spi(void) {
+  hal_host_reset();
+  check(blfm_spi1_init() == 0, "spi init");
+  report("spi init");
+
+  check(blfm_spi1_transfer(0xA5) == 0xA5, "spi loopback");
+  report("spi transfer");
+
+  uint8_t tx[4] = {1, 2, 3, 4};
+  uint8_t rx[4];
+  hal_host_spi_set_responder(spi_responder);
+  check(blfm_spi1_write_read(tx, 1, rx, 4) == 0 && rx[0] == 0x00 &&
+            rx[3] == 0x00,
+        "spi write_read");
+  report("spi write_read 1+4");
+
+  hal_host_inject(HAL_FAULT_SPI_NO_RXNE, 0);
+  check(blfm_spi1_transfer(0x11) == 0xFF, "spi lost RXNE times out");
+  report("spi transfer, RXNE lost");
+
+  hal_host_inject(HAL_FAULT_SPI_STALL, 0);
+  check(blfm_spi1_transfer(0x22) == 0xFF, "spi stall times out");
+  check(blfm_spi1_transfer(0x22) == 0xFF, "spi stays stalled");
+  hal_host_clear_counts();
+  blfm_spi1_set_speed(BLFM_SPI_SPEED_MEDIUM);
+  check(blfm_spi1_transfer(0x22) == 0xDD, "spi recovers on SPE toggle");
+  report("spi set_speed + transfer");
+  blfm_spi1_deinit();
+}
+
+static void bench_i2c(void) {
+  uint8_t imu[128];
+  uint8_t buf[6];
+
+  hal_host_reset();
+  for (size_t i = 0; i < sizeof(imu); i++) {
+    imu[i] = (uint8_t)i;
+  }
+  hal_host_i2c_attach(IMU_ADDR, imu, sizeof(imu));
+
+  blfm_i2c1_init();
+  report("i2c init");
+
+  check(blfm_i2c1_write_byte(IMU_ADDR, 0x6B, 0x5A) == 0 && imu[0x6B] == 0x5A,
+        "i2c write_byte");
+  report("i2c write_byte");
+
+  check(blfm_i2c1_read_bytes(IMU_ADDR, 0x3B, buf, 6) == 0 && buf[0] == 0x3B &&
+            buf[5] == 0x40,
+        "i2c read_bytes 6");
+  report("i2c read_bytes 6");
+
+  check(blfm_i2c1_read_bytes(IMU_ADDR, 0x6B, buf, 1) == 0 && buf[0] == 0x5A,
+        "i2c read_bytes 1");
+  report("i2c read_bytes 1");
+
+  check(blfm_i2c1_write_byte(0x3C, 0x00, 0x00) != 0, "i2c absent device");
+  report("i2c write_byte, no device");
+
+  static const struct {
+    hal_fault_t fault;
+    const char *name;
+  } faults[] = {
+      {HAL_FAULT_I2C_NO_START, "i2c write_byte, no START"},
+      {HAL_FAULT_I2C_NACK_ADDR, "i2c write_byte, address NACK"},
+      {HAL_FAULT_I2C_NACK_DATA, "i2c write_byte, data NACK"},
+      {HAL_FAULT_I2C_BTF_STUCK, "i2c write_byte, BTF stuck"},
+  };
+  for (size_t i = 0; i < sizeof(faults) / sizeof(faults[0]); i++) {
+    hal_host_inject(faults[i].fault, 0);
+    check(blfm_i2c1_write_byte(IMU_ADDR, 0x10, 0x01) != 0, faults[i].name);
+    check(hal_host_get_fired(faults[i].fault) == 1, "fault fired");
+    report(faults[i].name);
+  }
+
+  // The bus comes back once the fault is gone
+  check(blfm_i2c1_write_byte(IMU_ADDR, 0x10, 0x77) == 0 && imu[0x10] == 0x77,
+        "i2c after faults");
+  report("i2c write_byte, recovered");
+}
+
+#if BLFM_I2C1_ASYNC
+void I2C1_EV_IRQHandler(void);
+void I2C1_ER_IRQHandler(void);
+void DMA1_Channel6_IRQHandler(void);
+void DMA1_Channel7_IRQHandler(void);
+
+static bool notified;
+static uint32_t irqs_taken;
+
+uint32_t blfm_cpuload_isr_enter(blfm_isr_id_t id) {
+  (void)id;
+  return 0;
+}
+
+void blfm_cpuload_isr_exit(blfm_isr_id_t id, uint32_t entered) {
+  (void)id;
+  (void)entered;
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)(hal_host_now_us() / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return &notified; }
+
+void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index,
+                                   BaseType_t *woken) {
+  (void)task;
+  (void)index;
+  notified = true;
+  *woken = pdTRUE;
+}
+
+// The task blocks: interrupts run until one notifies it, or time runs out
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear,
+                                 TickType_t wait) {
+  (void)index;
+  (void)clear;
+  irqs_taken += hal_host_run_irqs();
+  if (!notified) {
+    hal_host_advance_us(wait * 1000u);
+    return 0;
+  }
+  notified = false;
+  return 1;
+}
+
+static void report_engine(const char *op) {
+  hal_counts_t c = total_counts();
+  printf("%-32s %7lu %7lu %5lu\n", op, (unsigned long)c.reads,
+         (unsigned long)c.writes, (unsigned long)irqs_taken);
+  hal_host_clear_counts();
+  irqs_taken = 0;
+}
+
+static int engine_read(uint8_t addr, uint8_t reg, uint8_t *buf, size_t len) {
+  return blfm_i2c1_transfer(BLFM_I2C1_CLIENT_IMU, addr, &reg, 1, buf, len);
+}
+
+static int engine_write(uint8_t addr, uint8_t reg, uint8_t data) {
+  uint8_t tx[2] = {reg, data};
+  return blfm_i2c1_transfer(BLFM_I2C1_CLIENT_IMU, addr, tx, 2, NULL, 0);
+}
+
+static void bench_i2c_engine(void) {
+  uint8_t imu[128];
+  uint8_t buf[6];
+  blfm_i2c1_stats_t stats;
+
+  hal_host_reset();
+  for (size_t i = 0; i < sizeof(imu); i++) {
+    imu[i] = (uint8_t)i;
+  }
+  hal_host_i2c_attach(IMU_ADDR, imu, sizeof(imu));
+  hal_host_set_irq_handler(I2C1_EV_IRQn, I2C1_EV_IRQHandler);
+  hal_host_set_irq_handler(I2C1_ER_IRQn, I2C1_ER_IRQHandler);
+  hal_host_set_irq_handler(DMA1_Channel6_IRQn, DMA1_Channel6_IRQHandler);
+  hal_host_set_irq_handler(DMA1_Channel7_IRQn, DMA1_Channel7_IRQHandler);
+
+  printf("\n%-32s %7s %7s %5s\n", "engine call", "reads", "writes", "irqs");
+  blfm_i2c1_init();
+  blfm_i2c1_async_init();
+  report_engine("i2c engine init");
+
+  check(engine_write(IMU_ADDR, 0x6B, 0x5A) == BLFM_I2C1_OK &&
+            imu[0x6B] == 0x5A,
+        "engine write 2");
+  report_engine("i2c engine write 2");
+
+  check(engine_read(IMU_ADDR, 0x3B, buf, 6) == BLFM_I2C1_OK &&
+            buf[0] == 0x3B && buf[5] == 0x40,
+        "engine read 1+6");
+  report_engine("i2c engine read 1+6");
+
+  check(engine_read(IMU_ADDR, 0x6B, buf, 1) == BLFM_I2C1_OK && buf[0] == 0x5A,
+        "engine read 1+1");
+  report_engine("i2c engine read 1+1");
+
+  check(engine_write(0x3C, 0x00, 0x00) == BLFM_I2C1_ENACK,
+        "engine absent device");
+  report_engine("i2c engine write, no device");
+
+  static const struct {
+    hal_fault_t fault;
+    int status;
+    const char *name;
+  } faults[] = {
+      {HAL_FAULT_I2C_NO_START, BLFM_I2C1_ETIMEOUT, "i2c engine write, no START"},
+      {HAL_FAULT_I2C_NACK_ADDR, BLFM_I2C1_ENACK, "i2c engine write, addr NACK"},
+      {HAL_FAULT_I2C_NACK_DATA, BLFM_I2C1_ENACK, "i2c engine write, data NACK"},
+      {HAL_FAULT_I2C_BTF_STUCK, BLFM_I2C1_ETIMEOUT, "i2c engine write, BTF stuck"},
+  };
+  for (size_t i = 0; i < sizeof(faults) / sizeof(faults[0]); i++) {
+    hal_host_inject(faults[i].fault, 0);
+    check(engine_write(IMU_ADDR, 0x10, 0x01) == faults[i].status,
+          faults[i].name);
+    check(hal_host_get_fired(faults[i].fault) == 1, "fault fired");
+    check(!blfm_i2c1_busy(), "engine idle after the fault");
+    report_engine(faults[i].name);
+  }
+
+  check(engine_write(IMU_ADDR, 0x10, 0x77) == BLFM_I2C1_OK &&
+            imu[0x10] == 0x77,
+        "engine after faults");
+  report_engine("i2c engine write, recovered");
+
+  blfm_i2c1_get_stats(&stats);
+  check(stats.transfers == 9 && stats.nacks == 3 && stats.timeouts == 2,
+        "engine stats");
+}
+#endif
+
+int main(void) {
+  printf("%-32s %7s %7s\n", "driver call", "reads", "writes");
+  bench_gpio();
+  bench_pwm();
+  bench_spi();
+  bench_i2c();
+#if BLFM_I2C1_ASYNC
+  bench_i2c_engine();
+#endif
+
+  if (failures) {
+    printf("\n%d check(s) failed\n", failures);
+    return EXIT_FAILURE;
+  }
+  printf("\nall driver checks passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * blfm_ir_decoder against the pulse-train corpus in tools/bench/ir_corpus.
+ *
+ * Each file is replayed through a fresh decoder and the frames it produces
+ * must match the file's "expect" lines exactly, so this doubles as the
+ * decoder's regression check. Then the whole corpus is replayed in a loop to
+ * measure edges decoded per second with all protocols running.
+ *
+ * Usage: bench_ir_decoder file.ir...
+ */
+
+#include "blfm_ir_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_PULSES 4096
+#define MAX_EXPECTS 64
+#define MIN_BENCH_SECONDS 1.0
+
+// Stands in for an "idle" token in the pulse array
+#define PULSE_IDLE 0
+
+typedef struct {
+  const char *path;
+  int32_t pulses[MAX_PULSES]; // +mark, -space, PULSE_IDLE
+  unsigned pulse_count;
+  blfm_ir_frame_t expects[MAX_EXPECTS];
+  unsigned expect_count;
+} trace_t;
+
+static int protocol_by_name(const char *name) {
+  for (int i = 0; i < BLFM_IR_PROTO_COUNT; i++) {
+    if (strcmp(name, blfm_ir_decoder_protocol_name(i)) == 0)
+      return i;
+  }
+  return -1;
+}
+
+static int load(trace_t *trace, const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+
+  memset(trace, 0, sizeof(*trace));
+  trace->path = path;
+
+  char token[64];
+  while (fscanf(f, "%63s", token) == 1) {
+    if (token[0] == '#') {
+      int c;
+      while ((c = fgetc(f)) != EOF && c != '\n')
+        ;
+    } else if (strcmp(token, "expect") == 0) {
+      char name[16];
+      unsigned address, command, repeat;
+      if (fscanf(f, "%15s %x %x %u", name, &address, &command, &repeat) != 4 ||
+          protocol_by_name(name) < 0 || trace->expect_count == MAX_EXPECTS) {
+        fprintf(stderr, "%s: bad expect line\n", path);
+        fclose(f);
+        return -1;
+      }
+      blfm_ir_frame_t *e = &trace->expects[trace->expect_count++];
+      e->protocol = (uint8_t)protocol_by_name(name);
+      e->address = (uint16_t)address;
+      e->command = (uint16_t)command;
+      e->repeat = repeat != 0;
+    } else if (trace->pulse_count == MAX_PULSES) {
+      fprintf(stderr, "%s: more than %d pulses\n", path, MAX_PULSES);
+      fclose(f);
+      return -1;
+    } else if (strcmp(token, "idle") == 0) {
+      trace->pulses[trace->pulse_count++] = PULSE_IDLE;
+    } else {
+      trace->pulses[trace->pulse_count++] = (int32_t)strtol(token, NULL, 10);
+    }
+  }
+
+  fclose(f);
+  return 0;
+}
+
+// Returns the number of frames decoded, writing up to max of them
+static unsigned replay(const trace_t *trace, blfm_ir_frame_t *frames,
+                       unsigned max) {
+  blfm_ir_decoder_t dec;
+  blfm_ir_frame_t frame;
+  unsigned count = 0;
+
+  blfm_ir_decoder_init(&dec);
+  for (unsigned i = 0; i < trace->pulse_count; i++) {
+    int32_t p = trace->pulses[i];
+    bool done = p == PULSE_IDLE
+                    ? blfm_ir_decoder_idle(&dec, &frame)
+                    : blfm_ir_decoder_feed(&dec, (uint32_t)(p > 0 ? p : -p),
+                                           p > 0, &frame);
+    if (done) {
+      if (frames && count < max) {
+        frames[count] = frame;
+      }
+      count++;
+    }
+  }
+  return count;
+}
+
+static int check(const trace_t *trace) {
+  blfm_ir_frame_t got[MAX_EXPECTS];
+  unsigned count = replay(trace, got, MAX_EXPECTS);
+  int failures = 0;
+
+  if (count != trace->expect_count) {
+    printf("  %s: %u frames, expected %u\n", trace->path, count,
+           trace->expect_count);
+    failures++;
+  }
+
+  for (unsigned i = 0; i < count && i < trace->expect_count; i++) {
+    const blfm_ir_frame_t *e = &trace->expects[i];
+    const blfm_ir_frame_t *g = &got[i];
+    if (g->protocol != e->protocol || g->address != e->address ||
+        g->command != e->command || g->repeat != e->repeat) {
+      printf("  %s frame %u: got %s 0x%04X 0x%04X %d, expected %s 0x%04X "
+             "0x%04X %d\n",
+             trace->path, i, blfm_ir_decoder_protocol_name(g->protocol),
+             g->address, g->command, g->repeat,
+             blfm_ir_decoder_protocol_name(e->protocol), e->address,
+             e->command, e->repeat);
+      failures++;
+    }
+  }
+  return failures;
+}
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s file.ir...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  unsigned trace_count = (unsigned)argc - 1;
+  trace_t *traces = calloc(trace_count, sizeof(trace_t));
+  if (!traces)
+    return EXIT_FAILURE;
+
+  int failures = 0;
+  unsigned long pulses_per_pass = 0;
+
+  printf("%-36s %8s %8s %8s\n", "trace", "pulses", "frames", "result");
+  for (unsigned i = 0; i < trace_count; i++) {
+    if (load(&traces[i], argv[i + 1]) != 0)
+      return EXIT_FAILURE;
+    int bad = check(&traces[i]);
+    failures += bad;
+    pulses_per_pass += traces[i].pulse_count;
+    printf("%-36s %8u %8u %8s\n", argv[i + 1], traces[i].pulse_count,
+           traces[i].expect_count, bad ? "FAIL" : "ok");
+  }
+
+  // Whole-corpus passes until the clock has run long enough to trust
+  unsigned long passes = 0;
+  unsigned long frames = 0;
+  double start = now_s();
+  double elapsed;
+  do {
+    for (unsigned i = 0; i < trace_count; i++) {
+      frames += replay(&traces[i], NULL, 0);
+    }
+    passes++;
+    elapsed = now_s() - start;
+  } while (elapsed < MIN_BENCH_SECONDS);
+
+  double edges = (double)pulses_per_pass * passes;
+  printf("\n%lu passes, %.0f edges, %lu frames in %.2f s\n", passes, edges,
+         frames, elapsed);
+  printf("%.2f M edges/s, %.0f ns/edge for %d protocols\n",
+         edges / elapsed / 1e6, elapsed / edges * 1e9, BLFM_IR_PROTO_COUNT);
+
+  free(traces);
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
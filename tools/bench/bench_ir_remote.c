@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * blfm_ir_remote's EXTI backend, from the edge interrupt through the decode
+ * task, on a host model of the core clock. The source is compiled into this
+ * file with DWT and GPIOA replaced by plain structs, and the clock holds of
+ * blfm_power.h driving a model of DBGMCU_CR_DBG_SLEEP.
+ *
+ * The decode task runs as the main loop. While it is blocked in
+ * ulTaskNotifyTake the model plays the next edges into the interrupt
+ * handler, and the core either stays busy or sleeps in WFI, where CYCCNT
+ * only counts with DBG_SLEEP set, as on the part. A NEC frame and a repeat
+ * code must decode the same way in both cases, and every clock hold must be
+ * released once the burst is over. Exits non-zero if any check fails.
+ */
+
+#include "blfm_config.h"
+#undef BLFM_ENABLED_IR_REMOTE
+#define BLFM_ENABLED_IR_REMOTE 1
+#undef BLFM_IR_TIMER_CAPTURE
+#define BLFM_IR_TIMER_CAPTURE 0
+
+#include "stm32f1xx.h"
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static DWT_Type host_dwt;
+static GPIO_TypeDef host_gpioa;
+
+#undef DWT
+#define DWT (&host_dwt)
+#undef GPIOA
+#define GPIOA (&host_gpioa)
+
+#include "sensors/blfm_ir_remote.c"
+
+#define CYCLES_PER_US 72
+#define MAX_EDGES 160
+#define MAX_EVENTS 8
+
+// Time the core stays awake around an edge when it otherwise sleeps
+#define WAKE_US 20
+
+typedef struct {
+  uint32_t at_us;
+  bool level;
+} sim_edge_t;
+
+static sim_edge_t edges[MAX_EDGES];
+static unsigned edge_count;
+static unsigned next_edge;
+
+static uint64_t now_us;
+static bool sleeping; // Core in WFI whenever the decode task is blocked
+static int clock_holds;
+static bool notified;
+static jmp_buf script_done;
+
+static blfm_ir_remote_event_t events[MAX_EVENTS];
+static unsigned event_count;
+
+static int failures;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL %s\n", what);
+    failures++;
+  }
+}
+
+/* -------------------- Clock and kernel model -------------------- */
+
+void blfm_power_hold_clock(void) { clock_holds++; }
+
+void blfm_power_release_clock(void) { clock_holds--; }
+
+// CYCCNT follows the core clock, which WFI gates unless it is held
+static void advance_to(uint64_t us) {
+  uint64_t span = us - now_us;
+  if (sleeping && clock_holds <= 0) {
+    span = span < WAKE_US ? span : WAKE_US;
+  }
+  host_dwt.CYCCNT += (uint32_t)(span * CYCLES_PER_US);
+  now_us = us;
+}
+
+TickType_t xTaskGetTickCount(void) { return (TickType_t)(now_us / 1000); }
+
+TickType_t xTaskGetTickCountFromISR(void) { return xTaskGetTickCount(); }
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return &notified; }
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+  (void)task;
+  notified = true;
+  *woken = pdTRUE;
+}
+
+// Blocks the decode task: plays edges until it is notified or times out
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) {
+  (void)clear;
+  uint64_t deadline = wait == portMAX_DELAY ? UINT64_MAX : now_us + wait * 1000;
+
+  while (!notified) {
+    if (next_edge == edge_count) {
+      if (deadline == UINT64_MAX)
+        longjmp(script_done, 1);
+      advance_to(deadline);
+      return 0;
+    }
+
+    const sim_edge_t *edge = &edges[next_edge];
+    if (edge->at_us > deadline) {
+      advance_to(deadline);
+      return 0;
+    }
+
+    advance_to(edge->at_us);
+    next_edge++;
+    host_gpioa.IDR = edge->level ? GPIO_IDR_IDR8 : 0;
+    ir_exti_handler();
+  }
+
+  notified = false;
+  return 1;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item,
+                            TickType_t wait) {
+  (void)queue;
+  (void)wait;
+  if (event_count == MAX_EVENTS)
+    return pdFAIL;
+  events[event_count++] = *(const blfm_ir_remote_event_t *)item;
+  return pdPASS;
+}
+
+/* -------------------- Firmware stubs -------------------- */
+
+void blfm_taskmanager_cycle_begin(blfm_task_id_t id, TickType_t release) {
+  (void)id;
+  (void)release;
+}
+
+void blfm_taskmanager_cycle_end(blfm_task_id_t id) { (void)id; }
+
+void blfm_latency_origin(blfm_corr_t *corr, blfm_latency_path_t path,
+                         uint32_t cycles, uint32_t tick) {
+  (void)path;
+  (void)cycles;
+  (void)tick;
+  memset(corr, 0, sizeof(*corr));
+}
+
+void blfm_exti_register_callback(uint8_t exti_line,
+                                 blfm_exti_callback_t callback) {
+  (void)exti_line;
+  (void)callback;
+}
+
+void blfm_gpio_config_input_pullup(uint32_t port, uint32_t pin) {
+  (void)port;
+  (void)pin;
+}
+
+/* -------------------- Script -------------------- */
+
+// The line idles high; a mark pulls it low
+static uint32_t script_us;
+
+static void pulse(uint32_t mark_us, uint32_t space_us) {
+  edges[edge_count++] = (sim_edge_t){script_us, false};
+  script_us += mark_us;
+  edges[edge_count++] = (sim_edge_t){script_us, true};
+  script_us += space_us;
+}
+
+static void build_script(void) {
+  // Address 0x00 and command 0x18 with their complements, LSB first
+  uint32_t data = 0xFF00u | (0x18u << 16) | (0xE7u << 24);
+
+  edge_count = 0;
+  script_us = 1000;
+  pulse(9000, 4500);
+  for (uint8_t bit = 0; bit < 32; bit++) {
+    pulse(562, (data >> bit) & 1 ? 1687 : 562);
+  }
+  pulse(562, 40000);
+
+  // Repeat code, well inside the repeat window
+  pulse(9000, 2250);
+  pulse(562, 0);
+}
+
+static void run(bool sleep_between_edges) {
+  static const char *const names[] = {"awake", "asleep"};
+  const char *name = names[sleep_between_edges];
+
+  host_dwt.CYCCNT = 0;
+  clock_holds = 0;
+  host_gpioa.IDR = GPIO_IDR_IDR8;
+  now_us = 0;
+  sleeping = sleep_between_edges;
+  notified = false;
+  next_edge = 0;
+  event_count = 0;
+  last_edge_time = 0;
+  last_edge_tick = 0;
+  last_valid_command_tick = 0;
+  wake_pending = false;
+  memset(&stats, 0, sizeof(stats));
+
+  blfm_ir_decoder_init(&decoder);
+  blfm_ringbuf_init(&edge_ring, edge_storage, sizeof(edge_storage));
+  ir_controller_queue = &events;
+
+  if (!setjmp(script_done)) {
+    blfm_ir_remote_task(NULL);
+  }
+
+  char what[64];
+  snprintf(what, sizeof(what), "%s: two events", name);
+  check(event_count == 2, what);
+  for (unsigned i = 0; i < event_count && i < 2; i++) {
+    snprintf(what, sizeof(what), "%s: event %u is NEC 0xFF00 0x18", name, i);
+    check(events[i].protocol == BLFM_IR_PROTO_NEC &&
+              events[i].address == 0xFF00 && events[i].command == 0x18,
+          what);
+    snprintf(what, sizeof(what), "%s: event %u repeat flag", name, i);
+    check(events[i].repeat == (i == 1), what);
+  }
+  snprintf(what, sizeof(what), "%s: clock released after the burst", name);
+  check(clock_holds == 0, what);
+
+  printf("%-8s %8lu %8u %8lu\n", name, (unsigned long)stats.edges,
+         event_count, (unsigned long)stats.batches);
+}
+
+int main(void) {
+  build_script();
+
+  printf("%-8s %8s %8s %8s\n", "core", "edges", "events", "batches");
+  run(false);
+  run(true);
+
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
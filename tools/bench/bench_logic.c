@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Microbenchmarks of the pure-logic hot paths, one operation being one call.
+ * The controller, servo and OLED sources are compiled into this file so
+ * their static helpers can be timed directly, and against the firmware's own
+ * libc_stubs routines rather than the host's. The ultrasonic obstacle
+ * avoidance, the alarm and the OLED are forced on so their code is built
+ * whatever blfm_config.h says; the OLED's I2C and the PWM output are stubbed,
+ * so only the logic is timed.
+ *
+ * See microbench.h for the options and the JSON output.
+ */
+
+#include "microbench.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libc_stub_names.h"
+
+#include "blfm_config.h"
+#undef BLFM_ENABLED_ULTRASONIC
+#define BLFM_ENABLED_ULTRASONIC 1
+#undef BLFM_ENABLED_MOTOR
+#define BLFM_ENABLED_MOTOR 1
+#undef BLFM_ENABLED_ALARM
+#define BLFM_ENABLED_ALARM 1
+#include "controls/blfm_controller.c"
+#include "actuators/blfm_servomotor.c"
+#undef BLFM_ENABLED_OLED
+#define BLFM_ENABLED_OLED 1
+#include "actuators/blfm_oled.c"
+
+#include "blfm_ir_decoder.h"
+
+/* -------------------- Firmware stubs -------------------- */
+
+TickType_t xTaskGetTickCount(void) { return 0; }
+
+void blfm_gpio_toggle_pin(uint32_t port, uint32_t pin) {
+  (void)port;
+  (void)pin;
+}
+
+// Volatile, or the servo benchmarks would be optimised down to nothing
+static volatile uint16_t pwm_pulse_us[4];
+
+void blfm_pwm_init(void) {}
+
+void blfm_pwm_set_pulse_us(uint8_t channel, uint16_t us) {
+  pwm_pulse_us[channel & 3] = us;
+}
+
+void blfm_pwm_generate_cycle(void) {}
+
+void blfm_taskmanager_cycle_begin(blfm_task_id_t id, TickType_t release) {
+  (void)id;
+  (void)release;
+}
+
+void blfm_taskmanager_next_cycle(blfm_task_id_t id, TickType_t *release) {
+  (void)id;
+  (void)release;
+}
+
+int blfm_i2c1_client_write(blfm_i2c1_client_t client, uint8_t addr,
+                           const uint8_t *data, size_t len) {
+  (void)client;
+  (void)addr;
+  (void)data;
+  (void)len;
+  return 0;
+}
+
+/* -------------------- Controller -------------------- */
+
+static void run_motor_by_angle(uint64_t iters) {
+  static const int angles[8] = {-180, -135, -90, -30, 0, 60, 120, 200};
+  blfm_motor_command_t out;
+
+  MICROBENCH_USE(&out);
+  for (uint64_t i = 0; i < iters; i++) {
+    set_motor_motion_by_angle(angles[i & 7], 200, &out);
+    MICROBENCH_CLOBBER();
+  }
+}
+
+#define SENSOR_FRAMES 16
+static blfm_sensor_data_t sensor_frames[SENSOR_FRAMES];
+static blfm_actuator_command_t controller_cmd;
+
+static void setup_controller(void) {
+  for (uint8_t i = 0; i < SENSOR_FRAMES; i++) {
+    blfm_sensor_data_t *s = &sensor_frames[i];
+    blfm_stub_memset(s, 0, sizeof(*s));
+    s->valid = 0x0F;
+    s->ultrasonic.distance_mm = (uint16_t)(i * 150);
+    s->temperature.temperature_mc = 24000 + i * 10;
+    s->potentiometer.raw_value = (uint16_t)(i * 256);
+  }
+  // Manual mode skips the obstacle state machine, the part worth timing
+  blfm_controller_change_mode(BLFM_MODE_AUTO, &controller_cmd);
+}
+
+// AUTO mode, the distances sweep the obstacle state machine through its states
+static void run_controller_process(uint64_t iters) {
+  MICROBENCH_USE(&controller_cmd);
+  for (uint64_t i = 0; i < iters; i++) {
+    const blfm_sensor_data_t *in = &sensor_frames[i % SENSOR_FRAMES];
+    blfm_controller_process(in, &controller_cmd);
+    MICROBENCH_CLOBBER();
+  }
+}
+
+#if BLFM_ENABLED_IR_REMOTE
+static void run_controller_ir_remote(uint64_t iters) {
+  static const blfm_ir_command_t keys[8] = {
+      BLFM_IR_CMD_2,    BLFM_IR_CMD_UP, BLFM_IR_CMD_LEFT, BLFM_IR_CMD_4,
+      BLFM_IR_CMD_OK,   BLFM_IR_CMD_6,  BLFM_IR_CMD_DOWN, BLFM_IR_CMD_1,
+  };
+  blfm_ir_remote_event_t ev = {.protocol = BLFM_IR_PROTO_NEC};
+
+  MICROBENCH_USE(&controller_cmd);
+  for (uint64_t i = 0; i < iters; i++) {
+    ev.command = keys[i & 7];
+    blfm_controller_process_ir_remote(&ev, &controller_cmd);
+    MICROBENCH_CLOBBER();
+  }
+}
+#endif
+
+/* -------------------- IR decoder -------------------- */
+
+// One NEC frame, address 0x00 command 0x18, then the inter-frame gap
+#define NEC_PULSES (2 + 64 + 2)
+static uint32_t nec_us[NEC_PULSES];
+
+static void setup_ir(void) {
+  uint32_t data = 0x00FFu | (0x18u << 16) | ((uint32_t)(~0x18u & 0xFF) << 24);
+  uint8_t n = 0;
+
+  nec_us[n++] = 9000;
+  nec_us[n++] = 4500;
+  for (uint8_t bit = 0; bit < 32; bit++) {
+    nec_us[n++] = 560;
+    nec_us[n++] = (data >> bit) & 1 ? 1690 : 560;
+  }
+  nec_us[n++] = 560;
+  nec_us[n++] = 40000;
+
+  // Make sure the train decodes, or the timing means nothing
+  blfm_ir_decoder_t dec;
+  blfm_ir_frame_t frame;
+  bool got = false;
+  blfm_ir_decoder_init(&dec);
+  for (uint8_t i = 0; i < NEC_PULSES; i++) {
+    got |= blfm_ir_decoder_feed(&dec, nec_us[i], (i & 1) == 0, &frame);
+  }
+  assert(got && frame.protocol == BLFM_IR_PROTO_NEC && frame.command == 0x18);
+}
+
+static void run_ir_decoder_feed(uint64_t iters) {
+  static blfm_ir_decoder_t dec;
+  blfm_ir_frame_t frame;
+  uint32_t frames = 0;
+
+  blfm_ir_decoder_init(&dec);
+  for (uint64_t i = 0; i < iters; i++) {
+    uint32_t k = (uint32_t)(i % NEC_PULSES);
+    frames += blfm_ir_decoder_feed(&dec, nec_us[k], (k & 1) == 0, &frame);
+  }
+  MICROBENCH_USE(frames);
+}
+
+/* -------------------- Servo -------------------- */
+
+#if BLFM_ENABLED_SERVO
+static void run_angle_to_pulse(uint64_t iters) {
+  uint32_t sum = 0;
+  for (uint64_t i = 0; i < iters; i++) {
+    int8_t angle = (int8_t)((int)(i % 201) - 100);
+    MICROBENCH_USE(angle);
+    sum += angle_to_pulse_us(angle);
+  }
+  MICROBENCH_USE(sum);
+}
+
+static void run_proportional_servo(uint64_t iters) {
+  blfm_servomotor_command_t cmd = {0};
+  for (uint64_t i = 0; i < iters; i++) {
+    cmd.proportional_input = (int16_t)((int)(i % 2001) - 1000);
+    process_proportional_servo((uint8_t)(i & 3), &cmd);
+    MICROBENCH_CLOBBER();
+  }
+}
+#endif
+
+/* -------------------- OLED -------------------- */
+
+static void run_oled_draw_char(uint64_t iters) {
+  for (uint64_t i = 0; i < iters; i++) {
+    blfm_oled_draw_char((uint8_t)((i & 15) * 8), (uint8_t)((i >> 4) & 3),
+                        (char)(32 + i % 96));
+    MICROBENCH_CLOBBER();
+  }
+}
+
+/* -------------------- libc_stubs -------------------- */
+
+static char text[64] = "BELFHYM 2025 rover";
+static uint8_t src_buf[256];
+static uint8_t dst_buf[256];
+
+static void run_memset_64(uint64_t iters) {
+  for (uint64_t i = 0; i < iters; i++) {
+    blfm_stub_memset(dst_buf, (int)i, 64);
+    MICROBENCH_CLOBBER();
+  }
+}
+
+static void run_memcpy_64(uint64_t iters) {
+  for (uint64_t i = 0; i < iters; i++) {
+    blfm_stub_memcpy(dst_buf, src_buf, 64);
+    MICROBENCH_CLOBBER();
+  }
+}
+
+static void run_memcpy_command(uint64_t iters) {
+  static blfm_actuator_command_t a, b;
+  for (uint64_t i = 0; i < iters; i++) {
+    blfm_stub_memcpy(&a, &b, sizeof(a));
+    MICROBENCH_CLOBBER();
+  }
+}
+
+static void run_strlen(uint64_t iters) {
+  size_t sum = 0;
+  for (uint64_t i = 0; i < iters; i++) {
+    MICROBENCH_CLOBBER();
+    sum += blfm_stub_strlen(text);
+  }
+  MICROBENCH_USE(sum);
+}
+
+static void run_strcpy_strcat(uint64_t iters) {
+  char buf[32];
+  for (uint64_t i = 0; i < iters; i++) {
+    blfm_stub_strcpy(buf, "Dist: ");
+    blfm_stub_strcat(buf, "123");
+    blfm_stub_strcat(buf, " mm");
+    MICROBENCH_CLOBBER();
+  }
+}
+
+static void run_safe_strncpy(uint64_t iters) {
+  char buf[BLFM_OLED_MAX_BIG_TEXT_LEN];
+  for (uint64_t i = 0; i < iters; i++) {
+    blfm_stub_safe_strncpy(buf, text, sizeof(buf));
+    MICROBENCH_CLOBBER();
+  }
+}
+
+static const microbench_t benches[] = {
+    {"controller.motor_by_angle", NULL, run_motor_by_angle},
+    {"controller.process", setup_controller, run_controller_process},
+#if BLFM_ENABLED_IR_REMOTE
+    {"controller.ir_remote", NULL, run_controller_ir_remote},
+#endif
+    {"ir_decoder.feed", setup_ir, run_ir_decoder_feed},
+#if BLFM_ENABLED_SERVO
+    {"servo.angle_to_pulse_us", NULL, run_angle_to_pulse},
+    {"servo.proportional", NULL, run_proportional_servo},
+#endif
+    {"oled.draw_char", NULL, run_oled_draw_char},
+    {"libc.memset_64", NULL, run_memset_64},
+    {"libc.memcpy_64", NULL, run_memcpy_64},
+    {"libc.memcpy_command", NULL, run_memcpy_command},
+    {"libc.strlen_18", NULL, run_strlen},
+    {"libc.strcpy_strcat", NULL, run_strcpy_strcat},
+    {"libc.safe_strncpy_16", NULL, run_safe_strncpy},
+};
+
+int main(int argc, char **argv) {
+  return microbench_main(argc, argv, benches,
+                         sizeof(benches) / sizeof(benches[0]));
+}
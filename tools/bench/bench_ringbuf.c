@@ -0,0 +1,251 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * blfm_ringbuf under two real threads.
+ *
+ * The stress pass streams a counting byte pattern through the ring with the
+ * producer and consumer each picking byte, bulk or span calls at random, and
+ * fails on the first byte out of sequence. The throughput pass times each
+ * call style on its own, next to a mutex-per-byte queue standing in for one
+ * xQueueSendFromISR per byte.
+ */
+
+#include "blfm_ringbuf.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RING_SIZE 256
+#define STRESS_BYTES (16u * 1024 * 1024)
+#define THROUGHPUT_BYTES (64u * 1024 * 1024)
+#define CHUNK_MAX 64
+
+typedef enum { MODE_BYTE, MODE_BULK, MODE_SPAN, MODE_MIXED } bench_mode_t;
+
+typedef struct {
+  blfm_ringbuf_t ring;
+  uint8_t storage[RING_SIZE];
+  uint32_t total;
+  bench_mode_t mode;
+  uint32_t errors;
+} run_t;
+
+static uint32_t xorshift(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+static bench_mode_t pick(bench_mode_t mode, uint32_t *rng) {
+  return mode == MODE_MIXED ? (bench_mode_t)(xorshift(rng) % 3) : mode;
+}
+
+static void *producer(void *arg) {
+  run_t *run = arg;
+  uint32_t rng = 0x12345678;
+  uint32_t sent = 0;
+  uint8_t chunk[CHUNK_MAX];
+
+  while (sent < run->total) {
+    uint32_t want = 1 + xorshift(&rng) % CHUNK_MAX;
+    if (want > run->total - sent) {
+      want = run->total - sent;
+    }
+
+    uint32_t n = 0;
+    switch (pick(run->mode, &rng)) {
+    case MODE_BYTE:
+      n = blfm_ringbuf_push_byte(&run->ring, (uint8_t)sent) ? 1 : 0;
+      break;
+    case MODE_BULK:
+      for (uint32_t i = 0; i < want; i++) {
+        chunk[i] = (uint8_t)(sent + i);
+      }
+      n = blfm_ringbuf_push(&run->ring, chunk, want);
+      break;
+    default: {
+      uint8_t *span;
+      n = blfm_ringbuf_write_span(&run->ring, &span);
+      if (n > want) {
+        n = want;
+      }
+      for (uint32_t i = 0; i < n; i++) {
+        span[i] = (uint8_t)(sent + i);
+      }
+      blfm_ringbuf_commit(&run->ring, n);
+      break;
+    }
+    }
+    if (n == 0) {
+      sched_yield(); // Full; on a single core the consumer must get to run
+    }
+    sent += n;
+  }
+  return NULL;
+}
+
+static void *consumer(void *arg) {
+  run_t *run = arg;
+  uint32_t rng = 0x9E3779B9;
+  uint32_t received = 0;
+  uint8_t chunk[CHUNK_MAX];
+
+  while (received < run->total) {
+    uint32_t n = 0;
+    const uint8_t *data = chunk;
+
+    switch (pick(run->mode, &rng)) {
+    case MODE_BYTE:
+      n = blfm_ringbuf_pop_byte(&run->ring, chunk) ? 1 : 0;
+      break;
+    case MODE_BULK:
+      n = blfm_ringbuf_pop(&run->ring, chunk, 1 + xorshift(&rng) % CHUNK_MAX);
+      break;
+    default:
+      n = blfm_ringbuf_read_span(&run->ring, &data);
+      break;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+      if (data[i] != (uint8_t)(received + i) && run->errors++ == 0) {
+        fprintf(stderr, "byte %u: got %u, want %u\n", received + i, data[i],
+                (uint8_t)(received + i));
+      }
+    }
+    if (data != chunk) {
+      blfm_ringbuf_consume(&run->ring, n);
+    }
+    if (n == 0) {
+      sched_yield();
+    }
+    received += n;
+  }
+  return NULL;
+}
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double run_threads(void *run, void *(*prod)(void *),
+                          void *(*cons)(void *)) {
+  pthread_t p, c;
+  double start = now_s();
+  pthread_create(&c, NULL, cons, run);
+  pthread_create(&p, NULL, prod, run);
+  pthread_join(p, NULL);
+  pthread_join(c, NULL);
+  return now_s() - start;
+}
+
+static double ring_run(bench_mode_t mode, uint32_t total, uint32_t *errors) {
+  static run_t run;
+  memset(&run, 0, sizeof(run));
+  blfm_ringbuf_init(&run.ring, run.storage, RING_SIZE);
+  run.total = total;
+  run.mode = mode;
+
+  double secs = run_threads(&run, producer, consumer);
+  *errors = run.errors;
+  return secs;
+}
+
+/* -------------------- Mutex-per-byte baseline -------------------- */
+
+typedef struct {
+  pthread_mutex_t lock;
+  uint8_t storage[RING_SIZE];
+  uint32_t head, tail, total;
+} locked_t;
+
+static volatile uint8_t sink;
+
+static void *locked_producer(void *arg) {
+  locked_t *q = arg;
+  for (uint32_t sent = 0; sent < q->total;) {
+    pthread_mutex_lock(&q->lock);
+    if (q->head - q->tail < RING_SIZE) {
+      q->storage[q->head++ % RING_SIZE] = (uint8_t)sent++;
+    }
+    pthread_mutex_unlock(&q->lock);
+    if (q->head - q->tail == RING_SIZE) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+static void *locked_consumer(void *arg) {
+  locked_t *q = arg;
+  for (uint32_t received = 0; received < q->total;) {
+    pthread_mutex_lock(&q->lock);
+    if (q->head != q->tail) {
+      sink = q->storage[q->tail++ % RING_SIZE];
+      received++;
+    }
+    pthread_mutex_unlock(&q->lock);
+    if (q->head == q->tail) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+static double locked_run(uint32_t total) {
+  static locked_t q;
+  memset(&q, 0, sizeof(q));
+  pthread_mutex_init(&q.lock, NULL);
+  q.total = total;
+  double secs = run_threads(&q, locked_producer, locked_consumer);
+  pthread_mutex_destroy(&q.lock);
+  return secs;
+}
+
+int main(void) {
+  static const struct {
+    const char *name;
+    bench_mode_t mode;
+    uint32_t total;
+  } modes[] = {
+      {"byte", MODE_BYTE, THROUGHPUT_BYTES / 8},
+      {"bulk", MODE_BULK, THROUGHPUT_BYTES},
+      {"span", MODE_SPAN, THROUGHPUT_BYTES},
+  };
+  uint32_t errors;
+  int failed = 0;
+
+  double secs = ring_run(MODE_MIXED, STRESS_BYTES, &errors);
+  printf("stress: %u MiB mixed calls, %u errors (%.2f s)\n",
+         STRESS_BYTES >> 20, errors, secs);
+  failed |= errors != 0;
+
+  printf("\n%-14s %10s %12s\n", "mode", "MiB", "MiB/s");
+  for (unsigned i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+    secs = ring_run(modes[i].mode, modes[i].total, &errors);
+    failed |= errors != 0;
+    printf("%-14s %10u %12.1f\n", modes[i].name, modes[i].total >> 20,
+           (modes[i].total >> 20) / secs);
+  }
+
+  uint32_t locked_total = THROUGHPUT_BYTES / 64;
+  secs = locked_run(locked_total);
+  printf("%-14s %10u %12.1f\n", "mutex/byte", locked_total >> 20,
+         (locked_total >> 20) / secs);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (C) 2025 Masoud Bolhassani
+#
+# Capture the report of an on-target benchmark build (BLFM_ENABLED_BENCH,
+# see include/blfm_bench.h) from the USART1 serial port, or from a file it
+# was logged to, and write it as JSON in cycles. With -b the run is
+# compared with a baseline through bench_compare.py, and the exit status
+# says whether anything got slower.
+#
+# Usage: tools/bench/bench_target.py [-o out.json] [-b base.json] [-t percent]
+#                                    [-s baud] /dev/ttyUSB0 | capture.txt
+#   Reset the board after starting the script; the report is sent once.
+
+import argparse
+import json
+import os
+import stat
+import subprocess
+import sys
+
+try:
+    import termios
+except ImportError:
+    termios = None
+
+
+def open_serial(path, baud):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = 0                                      # iflag
+    attrs[1] = 0                                      # oflag
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attrs[3] = 0                                      # lflag
+    attrs[4] = attrs[5] = getattr(termios, "B%d" % baud)
+    attrs[6][termios.VMIN] = 1
+    attrs[6][termios.VTIME] = 0
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return os.fdopen(fd, "rb", buffering=0)
+
+
+def lines(path, baud):
+    if termios and stat.S_ISCHR(os.stat(path).st_mode):
+        f = open_serial(path, baud)
+    else:
+        f = open(path, "rb")
+    line = bytearray()
+    with f:
+        while True:
+            c = f.read(1)
+            if not c:
+                if line:
+                    yield line.decode("ascii", "replace").strip()
+                return
+            if c == b"\n":
+                yield line.decode("ascii", "replace").strip()
+                line = bytearray()
+            else:
+                line += c
+
+
+def parse(path, baud):
+    report = None
+    for line in lines(path, baud):
+        # Anything before the first BEGIN is boot noise
+        words = line.split()
+        if len(words) < 2 or words[0] != "BENCH":
+            continue
+        if words[1] == "begin":
+            runs, cpu_hz, overhead = (int(w) for w in words[2:5])
+            report = {"format": 1, "unit": "cycles", "target": "stm32f103",
+                      "runs": runs, "cpu_hz": cpu_hz,
+                      "overhead_cycles": overhead, "benchmarks": []}
+        elif report is None:
+            continue
+        elif words[1] == "end":
+            if int(words[2]) != len(report["benchmarks"]):
+                sys.exit("%s: report lost lines" % path)
+            return report
+        else:
+            name = words[1]
+            lo, median, hi, result = (int(w) for w in words[2:6])
+            report["benchmarks"].append({
+                "name": name, "min_cycles": lo, "median_cycles": median,
+                "max_cycles": hi, "result": result})
+    sys.exit("%s: no complete BENCH report" % path)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-o", "--out", help="write the report as JSON")
+    ap.add_argument("-b", "--baseline", help="compare with this report")
+    ap.add_argument("-t", "--threshold", type=float, default=2.0,
+                    help="slowdown in percent counted as a regression")
+    ap.add_argument("-s", "--baud", type=int, default=115200,
+                    help="BLFM_UART_BAUD of the build")
+    ap.add_argument("source", help="serial port or captured output")
+    args = ap.parse_args()
+
+    report = parse(args.source, args.baud)
+    hz = report["cpu_hz"]
+    print("%d runs at %d MHz, %d cycles of overhead taken off" %
+          (report["runs"], hz // 1000000, report["overhead_cycles"]))
+    print("%-28s %10s %10s %10s %10s  %s" % ("benchmark", "min", "median",
+                                             "max", "median us", "result"))
+    for b in report["benchmarks"]:
+        print("%-28s %10d %10d %10d %10.2f  %d" %
+              (b["name"], b["min_cycles"], b["median_cycles"],
+               b["max_cycles"], b["median_cycles"] * 1e6 / hz, b["result"]))
+
+    out = args.out
+    if args.baseline and not out:
+        out = os.path.join(os.environ.get("TMPDIR", "/tmp"),
+                           "bench_target.json")
+    if out:
+        with open(out, "w") as f:
+            json.dump(report, f, indent=2)
+            f.write("\n")
+
+    if args.baseline:
+        compare = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                               "bench_compare.py")
+        print()
+        return subprocess.call([sys.executable, compare, "-t",
+                                str(args.threshold), args.baseline, out])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (C) 2025 Masoud Bolhassani
+#
+# Regenerate tools/bench/ir_corpus/*.ir, the pulse trains bench_ir_decoder
+# replays for regression. Frames are built from the protocol timings, then
+# distorted the way a TSOP-style receiver does: marks come out longer and
+# spaces shorter by a fixed bias, plus random jitter. Seeded, so the output
+# is stable.
+#
+# File format, whitespace separated:
+#   # comment to end of line
+#   expect <protocol> <address> <command> <repeat>   frames, in order
+#   +<us>  a mark      -<us>  a space      idle  the line went quiet
+#
+# Usage: tools/bench/gen_ir_corpus.py [outdir]
+
+import os
+import random
+import sys
+
+MARK_BIAS = 60
+JITTER = 50
+
+
+class Train:
+    def __init__(self, seed):
+        self.rng = random.Random(seed)
+        self.pulses = []
+        self.expects = []
+
+    def mark(self, us):
+        self.pulses.append(us + MARK_BIAS + self.rng.randint(-JITTER, JITTER))
+
+    def space(self, us):
+        self.pulses.append(-(us - MARK_BIAS + self.rng.randint(-JITTER, JITTER)))
+
+    def idle(self):
+        self.pulses.append("idle")
+
+    def expect(self, proto, address, command, repeat=False):
+        self.expects.append((proto, address, command, int(repeat)))
+
+    def write(self, path, comment):
+        with open(path, "w") as f:
+            f.write("# %s\n# Generated by tools/bench/gen_ir_corpus.py\n"
+                    % comment)
+            for e in self.expects:
+                f.write("expect %s 0x%04X 0x%04X %d\n" % e)
+            line = []
+            for p in self.pulses:
+                token = p if isinstance(p, str) else \
+                    ("+%d" % p if p > 0 else "%d" % p)
+                line.append(token)
+                if len(line) == 12:
+                    f.write(" ".join(line) + "\n")
+                    line = []
+            if line:
+                f.write(" ".join(line) + "\n")
+
+
+def distance_frame(t, hdr, bits, nbits):
+    t.mark(hdr[0])
+    t.space(hdr[1])
+    for i in range(nbits):
+        t.mark(560)
+        t.space(1690 if (bits >> i) & 1 else 560)
+    t.mark(560)
+
+
+def nec(t, address, command):
+    distance_frame(t, (9000, 4500),
+                   address | command << 16 | (command ^ 0xFF) << 24, 32)
+    t.space(40000)
+    t.expect("NEC", address, command)
+
+
+def nec_repeat(t, address, command):
+    t.mark(9000)
+    t.space(2250)
+    t.mark(560)
+    t.space(96000)
+    t.expect("NEC", address, command, True)
+
+
+def samsung(t, address, command):
+    distance_frame(t, (4500, 4500),
+                   address | command << 16 | (command ^ 0xFF) << 24, 32)
+    t.space(47000)
+    t.expect("Samsung", address, command)
+
+
+def sony(t, address, command, nbits):
+    t.mark(2400)
+    t.space(600)
+    data = command | address << 7
+    for i in range(nbits):
+        t.mark(1200 if (data >> i) & 1 else 600)
+        if i < nbits - 1:
+            t.space(600)
+    t.space(25000)
+    t.expect("Sony", address, command)
+
+
+def biphase(t, halves):
+    # halves: list of (is_mark, us); merge runs of one level, then distort
+    merged = []
+    for mark, us in halves:
+        if merged and merged[-1][0] == mark:
+            merged[-1][1] += us
+        else:
+            merged.append([mark, us])
+    for mark, us in merged:
+        if mark:
+            t.mark(us)
+        else:
+            t.space(us)
+
+
+def rc5(t, address, command, toggle, repeat):
+    unit = 889
+    bits = [1, 1, toggle] + [(address >> i) & 1 for i in range(4, -1, -1)] + \
+        [(command >> i) & 1 for i in range(5, -1, -1)]
+    halves = [(False, 20000)]
+    for b in bits:
+        # RC5 one: space then mark
+        halves += [(not b, unit), (bool(b), unit)]
+    halves.append((False, 90000))
+    biphase(t, halves)
+    t.expect("RC5", address, command, repeat)
+
+
+def rc6(t, address, command, toggle, repeat):
+    unit = 444
+    halves = [(False, 20000), (True, 6 * unit), (False, 2 * unit)]
+    bits = [1, 0, 0, 0, toggle] + \
+        [(address >> i) & 1 for i in range(7, -1, -1)] + \
+        [(command >> i) & 1 for i in range(7, -1, -1)]
+    for i, b in enumerate(bits):
+        width = 2 * unit if i == 4 else unit
+        # RC6 one: mark then space
+        halves += [(bool(b), width), (not b, width)]
+    halves.append((False, 90000))
+    biphase(t, halves)
+    t.expect("RC6", address, command, repeat)
+
+
+def main():
+    outdir = sys.argv[1] if len(sys.argv) > 1 else \
+        os.path.join(os.path.dirname(os.path.abspath(__file__)), "ir_corpus")
+    os.makedirs(outdir, exist_ok=True)
+
+    # The rover's remote: NEC address 0x00 (0xFF00 with its complement)
+    t = Train(1)
+    for cmd in (0x18, 0x52, 0x08, 0x5A, 0x1C, 0x45, 0x16, 0x0D):
+        nec(t, 0xFF00, cmd)
+    nec(t, 0xFF00, 0x18)
+    nec_repeat(t, 0xFF00, 0x18)
+    nec_repeat(t, 0xFF00, 0x18)
+    t.idle()
+    t.write(os.path.join(outdir, "nec.ir"), "NEC frames and repeat codes")
+
+    t = Train(2)
+    for cmd in (0x02, 0x07, 0x0B, 0x60, 0x61):
+        samsung(t, 0x0707, cmd)
+    t.idle()
+    t.write(os.path.join(outdir, "samsung.ir"), "Samsung32 frames")
+
+    t = Train(3)
+    sony(t, 0x01, 0x15, 12)
+    sony(t, 0x01, 0x12, 12)
+    sony(t, 0x3A, 0x4B, 15)
+    sony(t, 0x1A5C, 0x33, 20)
+    t.idle()
+    t.write(os.path.join(outdir, "sony.ir"), "Sony SIRC 12, 15 and 20 bit")
+
+    t = Train(4)
+    rc5(t, 0x00, 0x0C, 0, False)
+    rc5(t, 0x00, 0x0C, 0, True)
+    rc5(t, 0x05, 0x35, 1, False)
+    rc5(t, 0x14, 0x01, 0, False)
+    t.idle()
+    t.write(os.path.join(outdir, "rc5.ir"), "RC5 with toggle changes")
+
+    t = Train(5)
+    rc6(t, 0x00, 0x0C, 0, False)
+    rc6(t, 0x00, 0x0C, 0, True)
+    rc6(t, 0x04, 0xA7, 1, False)
+    t.idle()
+    t.write(os.path.join(outdir, "rc6.ir"), "RC6 mode 0")
+
+    # Several remotes in one stream, with glitches between frames
+    t = Train(6)
+    nec(t, 0xFF00, 0x1C)
+    t.mark(120)
+    t.space(3000)
+    samsung(t, 0x0707, 0x02)
+    sony(t, 0x01, 0x15, 12)
+    t.mark(300)
+    t.space(8000)
+    rc5(t, 0x00, 0x10, 1, False)
+    rc6(t, 0x00, 0x10, 1, False)
+    nec(t, 0xFF00, 0x08)
+    t.idle()
+    t.write(os.path.join(outdir, "mixed.ir"), "Mixed protocols with glitches")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,40 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Minimal FreeRTOS stand-in for single-threaded host benchmarks.
+ * Only what the benchmarked modules touch is provided.
+ */
+
+#ifndef BLFM_BENCH_FREERTOS_H
+#define BLFM_BENCH_FREERTOS_H
+
+#include <assert.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+#define configASSERT(x) assert(x)
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define configCPU_CLOCK_HZ 72000000UL
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 2
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY 191
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+#endif // BLFM_BENCH_FREERTOS_H
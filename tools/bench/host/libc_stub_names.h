@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_BENCH_LIBC_STUB_NAMES_H
+#define BLFM_BENCH_LIBC_STUB_NAMES_H
+
+/*
+ * src/system/libc_stubs.c under names that do not clash with the host libc,
+ * so benchmarks measure the routines the firmware links. Included ahead of
+ * libc_stubs.c and of any firmware source a benchmark pulls in.
+ */
+
+#define memset blfm_stub_memset
+#define memcpy blfm_stub_memcpy
+#define strcpy blfm_stub_strcpy
+#define strcat blfm_stub_strcat
+#define strlen blfm_stub_strlen
+#define abs blfm_stub_abs
+#define safe_strncpy blfm_stub_safe_strncpy
+#define __libc_init_array blfm_stub_libc_init_array
+
+#endif // BLFM_BENCH_LIBC_STUB_NAMES_H
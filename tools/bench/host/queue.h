@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_BENCH_QUEUE_H
+#define BLFM_BENCH_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item,
+                            TickType_t wait);
+
+#endif // BLFM_BENCH_QUEUE_H
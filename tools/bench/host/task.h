@@ -0,0 +1,31 @@
+
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_BENCH_TASK_H
+#define BLFM_BENCH_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear,
+                                 TickType_t wait);
+void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index,
+                                   BaseType_t *woken);
+
+#endif // BLFM_BENCH_TASK_H
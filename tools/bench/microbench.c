@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#include "microbench.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_SAMPLES 1001
+// Doubling stops here even if the operation is too fast to time
+#define MAX_ITERS (1ull << 32)
+
+typedef struct {
+  uint32_t samples;
+  double warmup_s;
+  double sample_s;
+  const char *json_path;
+} options_t;
+
+typedef struct {
+  uint64_t iters; // Operations per sample
+  uint32_t samples;
+  double min_ns, median_ns, mean_ns, p90_ns, max_ns, stddev_ns;
+} stats_t;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double time_run(const microbench_t *b, uint64_t iters) {
+  double start = now_s();
+  b->run(iters);
+  return now_s() - start;
+}
+
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of a sorted array
+static double percentile(const double *sorted, uint32_t n, double p) {
+  uint32_t rank = (uint32_t)ceil(p * n);
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void measure(const microbench_t *b, const options_t *opt,
+                    stats_t *out) {
+  static double ns[MAX_SAMPLES];
+
+  if (b->setup) {
+    b->setup();
+  }
+
+  // Grow the batch until one lasts a sample period
+  uint64_t iters = 1;
+  while (iters < MAX_ITERS && time_run(b, iters) < opt->sample_s) {
+    iters *= 2;
+  }
+
+  double start = now_s();
+  while (now_s() - start < opt->warmup_s) {
+    b->run(iters);
+  }
+
+  double sum = 0;
+  for (uint32_t i = 0; i < opt->samples; i++) {
+    ns[i] = time_run(b, iters) * 1e9 / (double)iters;
+    sum += ns[i];
+  }
+
+  double mean = sum / opt->samples;
+  double var = 0;
+  for (uint32_t i = 0; i < opt->samples; i++) {
+    var += (ns[i] - mean) * (ns[i] - mean);
+  }
+  qsort(ns, opt->samples, sizeof(ns[0]), cmp_double);
+
+  *out = (stats_t){
+      .iters = iters,
+      .samples = opt->samples,
+      .min_ns = ns[0],
+      .median_ns = percentile(ns, opt->samples, 0.5),
+      .mean_ns = mean,
+      .p90_ns = percentile(ns, opt->samples, 0.9),
+      .max_ns = ns[opt->samples - 1],
+      .stddev_ns = opt->samples > 1 ? sqrt(var / (opt->samples - 1)) : 0,
+  };
+}
+
+static bool selected(const char *name, int argc, char **argv) {
+  if (argc == 0)
+    return true;
+  for (int i = 0; i < argc; i++) {
+    if (strstr(name, argv[i]))
+      return true;
+  }
+  return false;
+}
+
+static void json_write(FILE *f, const microbench_t *benches,
+                       const stats_t *stats, const bool *ran, size_t count,
+                       const options_t *opt) {
+  fprintf(f, "{\n  \"format\": 1,\n  \"compiler\": \"%s\",\n", __VERSION__);
+  fprintf(f, "  \"samples\": %u,\n  \"sample_ms\": %g,\n", opt->samples,
+          opt->sample_s * 1e3);
+  fprintf(f, "  \"benchmarks\": [");
+
+  bool first = true;
+  for (size_t i = 0; i < count; i++) {
+    if (!ran[i])
+      continue;
+    const stats_t *s = &stats[i];
+    fprintf(f,
+            "%s\n    {\"name\": \"%s\", \"iters\": %llu, \"min_ns\": %.3f, "
+            "\"median_ns\": %.3f, \"mean_ns\": %.3f, \"p90_ns\": %.3f, "
+            "\"max_ns\": %.3f, \"stddev_ns\": %.3f}",
+            first ? "" : ",", benches[i].name, (unsigned long long)s->iters,
+            s->min_ns, s->median_ns, s->mean_ns, s->p90_ns, s->max_ns,
+            s->stddev_ns);
+    first = false;
+  }
+  fprintf(f, "\n  ]\n}\n");
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [-n samples] [-w warmup_ms] [-t sample_ms] "
+          "[-j out.json] [name...]\n",
+          prog);
+  exit(EXIT_FAILURE);
+}
+
+int microbench_main(int argc, char **argv, const microbench_t *benches,
+                    size_t count) {
+  options_t opt = {
+      .samples = 31,
+      .warmup_s = 0.02,
+      .sample_s = 0.002,
+  };
+  int c;
+
+  while ((c = getopt(argc, argv, "n:w:t:j:")) != -1) {
+    switch (c) {
+    case 'n':
+      opt.samples = (uint32_t)strtoul(optarg, NULL, 0);
+      if (opt.samples == 0 || opt.samples > MAX_SAMPLES)
+        usage(argv[0]);
+      break;
+    case 'w':
+      opt.warmup_s = strtod(optarg, NULL) / 1e3;
+      break;
+    case 't':
+      opt.sample_s = strtod(optarg, NULL) / 1e3;
+      break;
+    case 'j':
+      opt.json_path = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  stats_t *stats = calloc(count, sizeof(*stats));
+  bool *ran = calloc(count, sizeof(*ran));
+  if (!stats || !ran)
+    return EXIT_FAILURE;
+
+  printf("%-28s %10s %10s %10s %10s %10s %8s\n", "benchmark", "min ns",
+         "median ns", "mean ns", "p90 ns", "max ns", "cv %");
+  for (size_t i = 0; i < count; i++) {
+    if (!selected(benches[i].name, argc - optind, argv + optind))
+      continue;
+    measure(&benches[i], &opt, &stats[i]);
+    ran[i] = true;
+
+    const stats_t *s = &stats[i];
+    printf("%-28s %10.2f %10.2f %10.2f %10.2f %10.2f %8.1f\n",
+           benches[i].name, s->min_ns, s->median_ns, s->mean_ns, s->p90_ns,
+           s->max_ns, s->mean_ns > 0 ? 100 * s->stddev_ns / s->mean_ns : 0);
+  }
+
+  int rc = EXIT_SUCCESS;
+  if (opt.json_path) {
+    FILE *f = fopen(opt.json_path, "w");
+    if (f) {
+      json_write(f, benches, stats, ran, count, &opt);
+      fclose(f);
+    } else {
+      perror(opt.json_path);
+      rc = EXIT_FAILURE;
+    }
+  }
+
+  free(stats);
+  free(ran);
+  return rc;
+}
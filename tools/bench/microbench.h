@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef BLFM_MICROBENCH_H
+#define BLFM_MICROBENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Host microbenchmark runner. Each benchmark runs its operation iters times
+ * per call; the runner sizes iters so one sample lasts long enough for the
+ * clock, warms the code and caches up, then takes a fixed number of samples
+ * and reports ns per operation as min, median, mean, p90, max and standard
+ * deviation. -j also writes the results as JSON for bench_compare.py.
+ *
+ * Usage: <bench> [-n samples] [-w warmup_ms] [-t sample_ms] [-j out.json]
+ *                [name-substring...]
+ */
+
+typedef struct {
+  const char *name;
+  void (*setup)(void);          // Optional, once before warm-up
+  void (*run)(uint64_t iters);
+} microbench_t;
+
+// Stops the compiler from keeping values in registers across it, or from
+// dropping stores it thinks nobody reads
+#define MICROBENCH_CLOBBER() __asm__ volatile("" ::: "memory")
+
+// Forces a result to be computed without storing it anywhere. Given an
+// address, makes the object visible to every later MICROBENCH_CLOBBER().
+#define MICROBENCH_USE(x) __asm__ volatile("" ::"g"(x) : "memory")
+
+int microbench_main(int argc, char **argv, const microbench_t *benches,
+                    size_t count);
+
+#endif // BLFM_MICROBENCH_H
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * DMA1 model, bytes only. An enabled channel moves one item each time its
+ * peripheral requests one and counts CNDTR down; at zero it sets TCIF and
+ * GIF, which with TCIE raise its interrupt. Only the I2C1 requests are
+ * wired: I2C1_TX to channel 6, I2C1_RX to channel 7. Memory addresses are
+ * the tokens blfm_hal_host_dma_addr() hands out for host buffers.
+ */
+
+#include "hal_model.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHANNELS 7
+// Host buffers a driver can have handed to channels at once
+#define MAX_BUFFERS 8
+#define TOKEN_BASE 0x20000000u
+#define TOKEN_SPAN 0x10000u // CNDTR counts 16 bits
+
+#define REG_ISR HAL_REG(DMA_TypeDef, ISR)
+#define REG_IFCR HAL_REG(DMA_TypeDef, IFCR)
+// Each channel's CCR, CNDTR, CPAR and CMAR follow the controller's two
+#define REG_CCR(ch) ((DMA1_Channel1_BASE - DMA1_BASE) / 4 + ((ch) - 1) * 5)
+#define REG_CNDTR(ch) (REG_CCR(ch) + 1)
+#define REG_CPAR(ch) (REG_CCR(ch) + 2)
+#define REG_CMAR(ch) (REG_CCR(ch) + 3)
+#define DONE_FLAGS(ch) ((DMA_ISR_GIF1 | DMA_ISR_TCIF1) << (((ch) - 1) * 4))
+
+static volatile uint8_t *buffers[MAX_BUFFERS];
+static uint8_t next_buffer;
+static uint32_t moved[CHANNELS + 1]; // Items since the channel was enabled
+
+uint32_t blfm_hal_host_dma_addr(const volatile void *buf) {
+  uint8_t slot = next_buffer;
+  next_buffer = (uint8_t)((next_buffer + 1) % MAX_BUFFERS);
+  buffers[slot] = (volatile uint8_t *)buf;
+  return TOKEN_BASE + slot * TOKEN_SPAN;
+}
+
+static volatile uint8_t *resolve(uint32_t cmar, uint32_t offset) {
+  uint32_t slot = (cmar - TOKEN_BASE) / TOKEN_SPAN;
+  if (cmar < TOKEN_BASE || slot >= MAX_BUFFERS || !buffers[slot]) {
+    fprintf(stderr, "hal: DMA from 0x%08lx, not a BLFM_DMA_ADDR() token\n",
+            (unsigned long)cmar);
+    abort();
+  }
+  return buffers[slot] + (cmar - TOKEN_BASE) % TOKEN_SPAN + offset;
+}
+
+static bool requested(uint8_t ch) {
+  hal_model_t *i2c = hal_model(HAL_PERIPH_I2C1);
+  if (ch == 6)
+    return hal_i2c_dma_request(i2c, true);
+  if (ch == 7)
+    return hal_i2c_dma_request(i2c, false);
+  return false;
+}
+
+void hal_dma_reset(hal_model_t *model) {
+  (void)model;
+  memset(buffers, 0, sizeof(buffers));
+  next_buffer = 0;
+  memset(moved, 0, sizeof(moved));
+}
+
+void hal_dma_write(hal_model_t *model, uint32_t index, uint32_t value) {
+  if (index == REG_IFCR) {
+    model->regs[REG_ISR] &= ~value;
+    return;
+  }
+
+  for (uint8_t ch = 1; ch <= CHANNELS; ch++) {
+    if (index == REG_CCR(ch) && (value & DMA_CCR_EN) &&
+        !(model->regs[index] & DMA_CCR_EN)) {
+      moved[ch] = 0;
+    }
+  }
+  model->regs[index] = value;
+}
+
+void hal_dma_run(hal_model_t *model) {
+  for (uint8_t ch = 1; ch <= CHANNELS; ch++) {
+    uint32_t ccr = model->regs[REG_CCR(ch)];
+    uint32_t *cndtr = &model->regs[REG_CNDTR(ch)];
+
+    while ((ccr & DMA_CCR_EN) && *cndtr > 0 && requested(ch)) {
+      volatile uint8_t *mem = resolve(model->regs[REG_CMAR(ch)],
+                                      (ccr & DMA_CCR_MINC) ? moved[ch] : 0);
+      uint32_t cpar = model->regs[REG_CPAR(ch)];
+
+      if (ccr & DMA_CCR_DIR) {
+        hal_bus_write(cpar, *mem);
+      } else {
+        // The end of transfer is what I2C_CR2_LAST watches for
+        if (ch == 7 && *cndtr == 1) {
+          hal_i2c_dma_last(hal_model(HAL_PERIPH_I2C1));
+        }
+        *mem = (uint8_t)hal_bus_read(cpar);
+      }
+      moved[ch]++;
+      if (--*cndtr == 0) {
+        model->regs[REG_ISR] |= DONE_FLAGS(ch);
+      }
+    }
+  }
+}
+
+bool hal_dma_irq_pending(const hal_model_t *model, uint8_t ch) {
+  return (model->regs[REG_ISR] & (DMA_ISR_TCIF1 << ((ch - 1) * 4))) &&
+         (model->regs[REG_CCR(ch)] & DMA_CCR_TCIE);
+}
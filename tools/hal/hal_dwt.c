@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Cycle counter model. CYCCNT follows the model clock at 72 MHz while
+ * CYCCNTENA is set, and like a TIM counter poll each read moves the clock
+ * on by 1 us, so a driver spinning on it sees time pass.
+ */
+
+#include "hal_model.h"
+
+#define CORE_CLOCK_MHZ 72
+
+#define REG_CTRL HAL_REG(DWT_Type, CTRL)
+#define REG_CYCCNT HAL_REG(DWT_Type, CYCCNT)
+
+static uint32_t offset; // CYCCNT minus model cycles
+
+static uint32_t cycles(void) {
+  return (uint32_t)(hal_host_now_us() * CORE_CLOCK_MHZ);
+}
+
+void hal_dwt_reset(hal_model_t *model) {
+  (void)model;
+  offset = 0;
+}
+
+uint32_t hal_dwt_read(hal_model_t *model, uint32_t index) {
+  if (index != REG_CYCCNT)
+    return model->regs[index];
+
+  if (model->regs[REG_CTRL] & DWT_CTRL_CYCCNTENA_Msk) {
+    hal_host_advance_us(1);
+    model->regs[REG_CYCCNT] = cycles() + offset;
+  }
+  return model->regs[REG_CYCCNT];
+}
+
+void hal_dwt_write(hal_model_t *model, uint32_t index, uint32_t value) {
+  if (index == REG_CYCCNT) {
+    offset = value - cycles();
+  } else if (index == REG_CTRL &&
+             (value & ~model->regs[REG_CTRL] & DWT_CTRL_CYCCNTENA_Msk)) {
+    // Counting resumes from where it stood
+    offset = model->regs[REG_CYCCNT] - cycles();
+  }
+  model->regs[index] = value;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * GPIO port model: CRL/CRH pick inputs and outputs, BSRR/BRR land in ODR,
+ * IDR reads outputs back and inputs from hal_host_gpio_set_input(). Output
+ * edges are stamped with the model clock to measure pulses.
+ */
+
+#include "hal_model.h"
+#include <string.h>
+
+#define PORT_COUNT 3
+#define PIN_COUNT 16
+
+#define REG_CRL HAL_REG(GPIO_TypeDef, CRL)
+#define REG_CRH HAL_REG(GPIO_TypeDef, CRH)
+#define REG_IDR HAL_REG(GPIO_TypeDef, IDR)
+#define REG_ODR HAL_REG(GPIO_TypeDef, ODR)
+#define REG_BSRR HAL_REG(GPIO_TypeDef, BSRR)
+#define REG_BRR HAL_REG(GPIO_TypeDef, BRR)
+
+static uint16_t input_level[PORT_COUNT];
+static uint64_t rise_us[PORT_COUNT][PIN_COUNT];
+static uint32_t pulse_us[PORT_COUNT][PIN_COUNT];
+
+uint8_t hal_gpio_port(const hal_model_t *model) {
+  return (uint8_t)((model->base - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE));
+}
+
+static uint16_t output_mask(const hal_model_t *model) {
+  uint16_t mask = 0;
+  for (uint8_t pin = 0; pin < PIN_COUNT; pin++) {
+    uint32_t cr = model->regs[pin < 8 ? REG_CRL : REG_CRH];
+    // MODE bits non-zero: output or alternate function
+    if ((cr >> ((pin % 8) * 4)) & 0x3) {
+      mask |= 1u << pin;
+    }
+  }
+  return mask;
+}
+
+static void set_odr(hal_model_t *model, uint32_t odr) {
+  uint8_t port = hal_gpio_port(model);
+  uint16_t changed = (uint16_t)(model->regs[REG_ODR] ^ odr);
+  uint64_t now = hal_host_now_us();
+
+  for (uint8_t pin = 0; pin < PIN_COUNT; pin++) {
+    if (!(changed & (1u << pin)))
+      continue;
+    if (odr & (1u << pin)) {
+      rise_us[port][pin] = now;
+    } else {
+      pulse_us[port][pin] = (uint32_t)(now - rise_us[port][pin]);
+    }
+  }
+  model->regs[REG_ODR] = odr & 0xFFFF;
+}
+
+void hal_gpio_reset(hal_model_t *model) {
+  // Every pin a floating input
+  model->regs[REG_CRL] = 0x44444444;
+  model->regs[REG_CRH] = 0x44444444;
+}
+
+uint32_t hal_gpio_read(hal_model_t *model, uint32_t index) {
+  if (index == REG_IDR) {
+    uint16_t outputs = output_mask(model);
+    uint16_t inputs = input_level[hal_gpio_port(model)];
+    return (model->regs[REG_ODR] & outputs) | (inputs & ~outputs);
+  }
+  // BSRR and BRR are write-only
+  if (index == REG_BSRR || index == REG_BRR)
+    return 0;
+  return model->regs[index];
+}
+
+void hal_gpio_write(hal_model_t *model, uint32_t index, uint32_t value) {
+  uint32_t odr = model->regs[REG_ODR];
+
+  if (index == REG_BSRR) {
+    // Set wins over reset for the same pin
+    set_odr(model, (odr & ~(value >> 16)) | (value & 0xFFFF));
+  } else if (index == REG_BRR) {
+    set_odr(model, odr & ~(value & 0xFFFF));
+  } else if (index == REG_ODR) {
+    set_odr(model, value);
+  } else if (index != REG_IDR) {
+    model->regs[index] = value;
+  }
+}
+
+void hal_gpio_clear_pins(void) {
+  memset(input_level, 0xFF, sizeof(input_level));
+  memset(rise_us, 0, sizeof(rise_us));
+  memset(pulse_us, 0, sizeof(pulse_us));
+}
+
+void hal_host_gpio_set_input(hal_periph_t port, uint8_t pin, bool level) {
+  if (port < HAL_PERIPH_GPIOA || port > HAL_PERIPH_GPIOC || pin >= PIN_COUNT)
+    return;
+
+  uint8_t p = (uint8_t)(port - HAL_PERIPH_GPIOA);
+  if (level) {
+    input_level[p] |= 1u << pin;
+  } else {
+    input_level[p] &= ~(1u << pin);
+  }
+}
+
+uint32_t hal_host_gpio_pulse_us(hal_periph_t port, uint8_t pin) {
+  if (port < HAL_PERIPH_GPIOA || port > HAL_PERIPH_GPIOC || pin >= PIN_COUNT)
+    return 0;
+  return pulse_us[port - HAL_PERIPH_GPIOA][pin];
+}
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Dispatch of blfm_hal.h accesses to the peripheral models, access
+ * counters, fault arming, interrupt lines and the model clock.
+ */
+
+#include "hal_model.h"
+#include "blfm_delay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static hal_model_t models[HAL_PERIPH_COUNT] = {
+    [HAL_PERIPH_RCC] = {.name = "RCC", .base = RCC_BASE},
+    [HAL_PERIPH_AFIO] = {.name = "AFIO", .base = AFIO_BASE},
+    [HAL_PERIPH_GPIOA] = {.name = "GPIOA",
+                          .base = GPIOA_BASE,
+                          .reset = hal_gpio_reset,
+                          .read = hal_gpio_read,
+                          .write = hal_gpio_write},
+    [HAL_PERIPH_GPIOB] = {.name = "GPIOB",
+                          .base = GPIOB_BASE,
+                          .reset = hal_gpio_reset,
+                          .read = hal_gpio_read,
+                          .write = hal_gpio_write},
+    [HAL_PERIPH_GPIOC] = {.name = "GPIOC",
+                          .base = GPIOC_BASE,
+                          .reset = hal_gpio_reset,
+                          .read = hal_gpio_read,
+                          .write = hal_gpio_write},
+    [HAL_PERIPH_TIM4] = {.name = "TIM4",
+                         .base = TIM4_BASE,
+                         .reset = hal_tim_reset,
+                         .read = hal_tim_read,
+                         .write = hal_tim_write},
+    [HAL_PERIPH_SPI1] = {.name = "SPI1",
+                         .base = SPI1_BASE,
+                         .reset = hal_spi_reset,
+                         .read = hal_spi_read,
+                         .write = hal_spi_write},
+    [HAL_PERIPH_I2C1] = {.name = "I2C1",
+                         .base = I2C1_BASE,
+                         .reset = hal_i2c_reset,
+                         .read = hal_i2c_read,
+                         .write = hal_i2c_write},
+    [HAL_PERIPH_DMA1] = {.name = "DMA1",
+                         .base = DMA1_BASE,
+                         .reset = hal_dma_reset,
+                         .write = hal_dma_write},
+    [HAL_PERIPH_DWT] = {.name = "DWT",
+                        .base = DWT_BASE,
+                        .reset = hal_dwt_reset,
+                        .read = hal_dwt_read,
+                        .write = hal_dwt_write},
+    [HAL_PERIPH_COREDEBUG] = {.name = "CoreDebug", .base = CoreDebug_BASE},
+};
+
+// Enough for every line of the part
+#define IRQ_LINES 64
+// Handlers run back to back beyond this are a line that never clears
+#define IRQ_STORM 10000
+
+static struct {
+  hal_irq_handler_t handler;
+  bool enabled;
+  uint32_t priority;
+} irqs[IRQ_LINES];
+
+static struct {
+  bool armed;
+  uint32_t skip;
+  uint32_t fired;
+} faults[HAL_FAULT_COUNT];
+
+static uint64_t now_us;
+
+static hal_model_t *find_model(uintptr_t addr, uint32_t *index) {
+  for (uint8_t i = 0; i < HAL_PERIPH_COUNT; i++) {
+    hal_model_t *model = &models[i];
+    if (addr >= model->base &&
+        addr < model->base + HAL_REG_WORDS * sizeof(uint32_t)) {
+      *index = (uint32_t)(addr - model->base) / sizeof(uint32_t);
+      return model;
+    }
+  }
+  return NULL;
+}
+
+static hal_model_t *lookup(const volatile uint32_t *reg, uint32_t *index,
+                           const char *what) {
+  hal_model_t *model = find_model((uintptr_t)reg, index);
+  if (!model) {
+    fprintf(stderr, "hal: %s of unmodelled register 0x%08lx\n", what,
+            (unsigned long)(uintptr_t)reg);
+    abort();
+  }
+  return model;
+}
+
+uint32_t blfm_hal_host_read(const volatile uint32_t *reg) {
+  uint32_t index;
+  hal_model_t *model = lookup(reg, &index, "read");
+
+  model->counts.reads++;
+  model->reg_counts[index].reads++;
+  return model->read ? model->read(model, index) : model->regs[index];
+}
+
+void blfm_hal_host_write(volatile uint32_t *reg, uint32_t value) {
+  uint32_t index;
+  hal_model_t *model = lookup(reg, &index, "write");
+
+  model->counts.writes++;
+  model->reg_counts[index].writes++;
+  if (model->write) {
+    model->write(model, index, value);
+  } else {
+    model->regs[index] = value;
+  }
+}
+
+void hal_host_reset(void) {
+  now_us = 0;
+  for (uint8_t i = 0; i < IRQ_LINES; i++) {
+    irqs[i].enabled = false;
+  }
+  for (uint8_t i = 0; i < HAL_PERIPH_COUNT; i++) {
+    hal_model_t *model = &models[i];
+    memset(model->regs, 0, sizeof(model->regs));
+    if (model->reset) {
+      model->reset(model);
+    }
+  }
+  hal_host_clear_counts();
+  hal_gpio_clear_pins();
+  hal_i2c_detach_all();
+  hal_host_spi_set_responder(NULL);
+  memset(faults, 0, sizeof(faults));
+}
+
+void hal_host_get_counts(hal_periph_t periph, hal_counts_t *out) {
+  if (periph < HAL_PERIPH_COUNT && out) {
+    *out = models[periph].counts;
+  }
+}
+
+void hal_host_get_reg_counts(const volatile uint32_t *reg, hal_counts_t *out) {
+  uint32_t index;
+  hal_model_t *model = lookup(reg, &index, "count");
+  if (out) {
+    *out = model->reg_counts[index];
+  }
+}
+
+void hal_host_clear_counts(void) {
+  for (uint8_t i = 0; i < HAL_PERIPH_COUNT; i++) {
+    memset(&models[i].counts, 0, sizeof(models[i].counts));
+    memset(models[i].reg_counts, 0, sizeof(models[i].reg_counts));
+  }
+}
+
+uint32_t hal_host_peek(const volatile uint32_t *reg) {
+  uint32_t index;
+  return lookup(reg, &index, "peek")->regs[index];
+}
+
+void hal_host_inject(hal_fault_t fault, uint32_t skip) {
+  if (fault < HAL_FAULT_COUNT) {
+    faults[fault].armed = true;
+    faults[fault].skip = skip;
+  }
+}
+
+uint32_t hal_host_get_fired(hal_fault_t fault) {
+  return fault < HAL_FAULT_COUNT ? faults[fault].fired : 0;
+}
+
+bool hal_fault_take(hal_fault_t fault) {
+  if (!faults[fault].armed)
+    return false;
+
+  if (faults[fault].skip > 0) {
+    faults[fault].skip--;
+    return false;
+  }
+  faults[fault].armed = false;
+  faults[fault].fired++;
+  return true;
+}
+
+hal_model_t *hal_model(hal_periph_t periph) { return &models[periph]; }
+
+uint32_t hal_bus_read(uint32_t addr) {
+  uint32_t index;
+  hal_model_t *model = lookup((const volatile uint32_t *)(uintptr_t)addr,
+                              &index, "DMA read");
+  return model->read ? model->read(model, index) : model->regs[index];
+}
+
+void hal_bus_write(uint32_t addr, uint32_t value) {
+  uint32_t index;
+  hal_model_t *model = lookup((const volatile uint32_t *)(uintptr_t)addr,
+                              &index, "DMA write");
+  if (model->write) {
+    model->write(model, index, value);
+  } else {
+    model->regs[index] = value;
+  }
+}
+
+void blfm_hal_host_irq_enable(IRQn_Type irq, uint32_t priority) {
+  if (irq >= 0 && irq < IRQ_LINES) {
+    irqs[irq].enabled = true;
+    irqs[irq].priority = priority;
+  }
+}
+
+void hal_host_set_irq_handler(IRQn_Type irq, hal_irq_handler_t handler) {
+  if (irq >= 0 && irq < IRQ_LINES) {
+    irqs[irq].handler = handler;
+  }
+}
+
+static bool line_pending(IRQn_Type irq) {
+  switch (irq) {
+  case I2C1_EV_IRQn:
+    return hal_i2c_irq_pending(&models[HAL_PERIPH_I2C1], false);
+  case I2C1_ER_IRQn:
+    return hal_i2c_irq_pending(&models[HAL_PERIPH_I2C1], true);
+  case DMA1_Channel6_IRQn:
+    return hal_dma_irq_pending(&models[HAL_PERIPH_DMA1], 6);
+  case DMA1_Channel7_IRQn:
+    return hal_dma_irq_pending(&models[HAL_PERIPH_DMA1], 7);
+  default:
+    return false;
+  }
+}
+
+uint32_t hal_host_run_irqs(void) {
+  uint32_t taken = 0;
+
+  for (;;) {
+    hal_dma_run(&models[HAL_PERIPH_DMA1]);
+
+    int next = -1;
+    for (int i = 0; i < IRQ_LINES; i++) {
+      if (irqs[i].enabled && irqs[i].handler && line_pending((IRQn_Type)i) &&
+          (next < 0 || irqs[i].priority < irqs[next].priority)) {
+        next = i;
+      }
+    }
+    if (next < 0)
+      return taken;
+
+    if (++taken > IRQ_STORM) {
+      fprintf(stderr, "hal: IRQ %d stays pending\n", next);
+      abort();
+    }
+    irqs[next].handler();
+  }
+}
+
+uint64_t hal_host_now_us(void) { return now_us; }
+
+void hal_host_advance_us(uint32_t us) { now_us += us; }
+
+// The delay driver counts SysTick; here the model clock stands in for it
+void blfm_delay_init(void) {}
+
+void blfm_delay_us(uint32_t us) { now_us += us; }
+
+void blfm_delay_ms(uint32_t ms) { now_us += (uint64_t)ms * 1000u; }
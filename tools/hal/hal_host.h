@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include "blfm_hal.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Host backend of blfm_hal.h. Each modelled peripheral owns a virtual
+ * register file at its real base address; drivers built with
+ * BLFM_HAL_HOST=1 read and write it through the models below. Touching an
+ * address no model owns aborts the run.
+ */
+
+typedef enum {
+  HAL_PERIPH_RCC,
+  HAL_PERIPH_AFIO,
+  HAL_PERIPH_GPIOA,
+  HAL_PERIPH_GPIOB,
+  HAL_PERIPH_GPIOC,
+  HAL_PERIPH_TIM4,
+  HAL_PERIPH_SPI1,
+  HAL_PERIPH_I2C1,
+  HAL_PERIPH_DMA1,
+  HAL_PERIPH_DWT,
+  HAL_PERIPH_COREDEBUG,
+  HAL_PERIPH_COUNT
+} hal_periph_t;
+
+typedef struct {
+  uint32_t reads;
+  uint32_t writes;
+} hal_counts_t;
+
+typedef enum {
+  HAL_FAULT_I2C_NO_START,  // START request: SB never sets, bus held low
+  HAL_FAULT_I2C_NACK_ADDR, // Address byte: no device answers, AF
+  HAL_FAULT_I2C_NACK_DATA, // Data byte: device refuses it, AF
+  HAL_FAULT_I2C_BTF_STUCK, // Data byte: BTF never sets until STOP
+  HAL_FAULT_SPI_NO_RXNE,   // DR write: the received byte is lost
+  HAL_FAULT_SPI_STALL,     // DR write: TXE and RXNE stay clear until SPE drops
+  HAL_FAULT_COUNT
+} hal_fault_t;
+
+/** Reset values in every register file; counters, faults and devices cleared. */
+void hal_host_reset(void);
+
+void hal_host_get_counts(hal_periph_t periph, hal_counts_t *out);
+void hal_host_get_reg_counts(const volatile uint32_t *reg, hal_counts_t *out);
+void hal_host_clear_counts(void);
+
+/** Register file contents, without side effects and without counting. */
+uint32_t hal_host_peek(const volatile uint32_t *reg);
+
+/**
+ * Arms a fault for the (skip + 1)th time its trigger, listed above, comes
+ * round. Fires once.
+ */
+void hal_host_inject(hal_fault_t fault, uint32_t skip);
+uint32_t hal_host_get_fired(hal_fault_t fault);
+
+/** Model time: TIM and CYCCNT polls and blfm_delay_us() advance it. */
+uint64_t hal_host_now_us(void);
+void hal_host_advance_us(uint32_t us);
+
+/**
+ * Interrupts. A line enabled with BLFM_IRQ_ENABLE() and given a handler
+ * here runs while its model holds it pending: DMA transfers complete, then
+ * handlers run in priority order, lowest line first among equals, until no
+ * line is pending. Returns the number of handlers run.
+ */
+typedef void (*hal_irq_handler_t)(void);
+void hal_host_set_irq_handler(IRQn_Type irq, hal_irq_handler_t handler);
+uint32_t hal_host_run_irqs(void);
+
+// ===============================================================
+// Peripheral side
+// ===============================================================
+/** Level an input pin reads; inputs idle high. */
+void hal_host_gpio_set_input(hal_periph_t port, uint8_t pin, bool level);
+/** Width of the last completed high pulse on an output pin. */
+uint32_t hal_host_gpio_pulse_us(hal_periph_t port, uint8_t pin);
+
+/**
+ * Register-file slave: the first byte of a write selects the register, the
+ * rest are stored from there on, reads continue from the selected one.
+ */
+void hal_host_i2c_attach(uint8_t addr, uint8_t *mem, size_t len);
+
+/** Byte the slave shifts back for each byte sent; NULL loops MOSI back. */
+typedef uint8_t (*hal_spi_responder_t)(uint8_t mosi);
+void hal_host_spi_set_responder(hal_spi_responder_t responder);
+
+#endif // HAL_HOST_H
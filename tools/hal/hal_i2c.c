@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * I2C master model following the reference manual's event sequence:
+ * START sets SB, SR1 read then DR write sends the address, ADDR sets on
+ * ACK (AF on NACK), SR1 then SR2 read clears ADDR. A transmitter then sees
+ * TXE and BTF after every byte; a receiver sees RXNE with the next byte
+ * from the slave until ACK is cleared. Bytes complete instantly.
+ *
+ * With DMAEN set TXE and RXNE request DMA1 instead, and LAST has the byte
+ * at the end of the receive transfer NACKed. The event and error lines
+ * follow ITEVTEN, ITBUFEN and ITERREN as in the reference manual.
+ */
+
+#include "hal_model.h"
+
+#define MAX_DEVICES 4
+
+#define REG_CR1 HAL_REG(I2C_TypeDef, CR1)
+#define REG_CR2 HAL_REG(I2C_TypeDef, CR2)
+#define REG_DR HAL_REG(I2C_TypeDef, DR)
+#define REG_SR1 HAL_REG(I2C_TypeDef, SR1)
+#define REG_SR2 HAL_REG(I2C_TypeDef, SR2)
+
+typedef struct {
+  uint8_t addr;
+  uint8_t *mem;
+  size_t len;
+  size_t pointer;
+  bool pointer_set;
+} i2c_device_t;
+
+static i2c_device_t devices[MAX_DEVICES];
+static uint8_t device_count;
+
+static struct {
+  i2c_device_t *device; // Addressed slave, NULL when none answered
+  bool sr1_read;        // First half of the SB and ADDR clear sequences
+  bool nack_sent;       // Receiver: ACK was clear, no more bytes follow
+  bool btf_stuck;
+} bus;
+
+static i2c_device_t *find_device(uint8_t addr) {
+  for (uint8_t i = 0; i < device_count; i++) {
+    if (devices[i].addr == addr)
+      return &devices[i];
+  }
+  return NULL;
+}
+
+static void receive_next(hal_model_t *model) {
+  i2c_device_t *dev = bus.device;
+  if (!dev || bus.nack_sent)
+    return;
+
+  model->regs[REG_DR] = dev->mem[dev->pointer % dev->len];
+  dev->pointer++;
+  model->regs[REG_SR1] |= I2C_SR1_RXNE;
+  if (!(model->regs[REG_CR1] & I2C_CR1_ACK)) {
+    bus.nack_sent = true;
+  }
+}
+
+static void transmit(hal_model_t *model, uint8_t byte) {
+  i2c_device_t *dev = bus.device;
+  uint32_t *sr1 = &model->regs[REG_SR1];
+
+  *sr1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF);
+  if (hal_fault_take(HAL_FAULT_I2C_NACK_DATA)) {
+    *sr1 |= I2C_SR1_AF;
+    return;
+  }
+  if (hal_fault_take(HAL_FAULT_I2C_BTF_STUCK)) {
+    bus.btf_stuck = true;
+  }
+
+  if (!dev->pointer_set) {
+    dev->pointer = byte;
+    dev->pointer_set = true;
+  } else {
+    dev->mem[dev->pointer % dev->len] = byte;
+    dev->pointer++;
+  }
+  *sr1 |= I2C_SR1_TXE | (bus.btf_stuck ? 0 : I2C_SR1_BTF);
+}
+
+static void send_address(hal_model_t *model, uint8_t byte) {
+  uint32_t *sr1 = &model->regs[REG_SR1];
+  bool read = byte & 0x01;
+
+  *sr1 &= ~I2C_SR1_SB;
+  bus.device = find_device(byte >> 1);
+  if (!bus.device || hal_fault_take(HAL_FAULT_I2C_NACK_ADDR)) {
+    bus.device = NULL;
+    *sr1 |= I2C_SR1_AF;
+    return;
+  }
+
+  if (read) {
+    model->regs[REG_SR2] &= ~I2C_SR2_TRA;
+  } else {
+    model->regs[REG_SR2] |= I2C_SR2_TRA;
+    bus.device->pointer_set = false;
+  }
+  bus.nack_sent = false;
+  *sr1 |= I2C_SR1_ADDR;
+}
+
+static void stop(hal_model_t *model) {
+  model->regs[REG_SR1] &= ~(I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_TXE |
+                            I2C_SR1_BTF);
+  model->regs[REG_SR2] &= ~(I2C_SR2_MSL | I2C_SR2_BUSY | I2C_SR2_TRA);
+  bus.device = NULL;
+  bus.btf_stuck = false;
+}
+
+void hal_i2c_reset(hal_model_t *model) {
+  (void)model;
+  bus.device = NULL;
+  bus.sr1_read = false;
+  bus.nack_sent = false;
+  bus.btf_stuck = false;
+}
+
+uint32_t hal_i2c_read(hal_model_t *model, uint32_t index) {
+  uint32_t *sr1 = &model->regs[REG_SR1];
+
+  if (index == REG_SR1) {
+    bus.sr1_read = true;
+    return *sr1;
+  }
+
+  if (index == REG_SR2) {
+    uint32_t sr2 = model->regs[REG_SR2];
+    if (bus.sr1_read && (*sr1 & I2C_SR1_ADDR)) {
+      *sr1 &= ~I2C_SR1_ADDR;
+      if (sr2 & I2C_SR2_TRA) {
+        *sr1 |= I2C_SR1_TXE;
+      } else {
+        receive_next(model);
+      }
+    }
+    bus.sr1_read = false;
+    return sr2;
+  }
+
+  if (index == REG_DR && (*sr1 & I2C_SR1_RXNE)) {
+    uint32_t data = model->regs[REG_DR];
+    *sr1 &= ~(I2C_SR1_RXNE | I2C_SR1_BTF);
+    receive_next(model);
+    return data;
+  }
+  return model->regs[index];
+}
+
+void hal_i2c_write(hal_model_t *model, uint32_t index, uint32_t value) {
+  if (index == REG_CR1) {
+    if (value & I2C_CR1_SWRST) {
+      for (uint32_t i = 0; i < HAL_REG_WORDS; i++) {
+        model->regs[i] = 0;
+      }
+      hal_i2c_reset(model);
+      model->regs[REG_CR1] = value;
+      return;
+    }
+
+    // START and STOP clear themselves once acted on
+    model->regs[REG_CR1] = value & ~(I2C_CR1_START | I2C_CR1_STOP);
+    if (!(value & I2C_CR1_PE))
+      return;
+
+    if (value & I2C_CR1_STOP) {
+      stop(model);
+    }
+    if (value & I2C_CR1_START) {
+      if (hal_fault_take(HAL_FAULT_I2C_NO_START)) {
+        model->regs[REG_CR1] |= I2C_CR1_START;
+        return;
+      }
+      model->regs[REG_SR1] &= ~(I2C_SR1_TXE | I2C_SR1_BTF | I2C_SR1_AF);
+      model->regs[REG_SR1] |= I2C_SR1_SB;
+      model->regs[REG_SR2] |= I2C_SR2_MSL | I2C_SR2_BUSY;
+      bus.btf_stuck = false;
+    }
+    return;
+  }
+
+  if (index == REG_DR) {
+    uint32_t sr1 = model->regs[REG_SR1];
+    if ((sr1 & I2C_SR1_SB) && bus.sr1_read) {
+      send_address(model, (uint8_t)value);
+    } else if (bus.device && (model->regs[REG_SR2] & I2C_SR2_TRA) &&
+               !(sr1 & I2C_SR1_ADDR)) {
+      transmit(model, (uint8_t)value);
+    }
+    bus.sr1_read = false;
+    return;
+  }
+
+  if (index == REG_SR1) {
+    // Error flags are cleared by writing 0
+    model->regs[REG_SR1] &= value | ~(I2C_SR1_AF | I2C_SR1_BERR |
+                                      I2C_SR1_ARLO | I2C_SR1_OVR);
+    return;
+  }
+
+  model->regs[index] = value;
+}
+
+bool hal_i2c_irq_pending(const hal_model_t *model, bool error) {
+  uint32_t cr2 = model->regs[REG_CR2];
+  uint32_t sr1 = model->regs[REG_SR1];
+
+  if (error)
+    return (cr2 & I2C_CR2_ITERREN) &&
+           (sr1 & (I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | I2C_SR1_OVR |
+                   I2C_SR1_PECERR | I2C_SR1_TIMEOUT | I2C_SR1_SMBALERT));
+
+  if (!(cr2 & I2C_CR2_ITEVTEN))
+    return false;
+  return (sr1 & (I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_ADD10 | I2C_SR1_STOPF |
+                 I2C_SR1_BTF)) ||
+         ((cr2 & I2C_CR2_ITBUFEN) && (sr1 & (I2C_SR1_TXE | I2C_SR1_RXNE)));
+}
+
+bool hal_i2c_dma_request(const hal_model_t *model, bool tx) {
+  uint32_t sr1 = model->regs[REG_SR1];
+
+  if (!(model->regs[REG_CR2] & I2C_CR2_DMAEN) || !bus.device)
+    return false;
+  if (tx)
+    return (model->regs[REG_SR2] & I2C_SR2_TRA) && (sr1 & I2C_SR1_TXE) &&
+           !(sr1 & I2C_SR1_ADDR);
+  return (sr1 & I2C_SR1_RXNE) != 0;
+}
+
+void hal_i2c_dma_last(hal_model_t *model) {
+  if (model->regs[REG_CR2] & I2C_CR2_LAST) {
+    bus.nack_sent = true;
+  }
+}
+
+void hal_i2c_detach_all(void) { device_count = 0; }
+
+void hal_host_i2c_attach(uint8_t addr, uint8_t *mem, size_t len) {
+  if (device_count == MAX_DEVICES || !mem || len == 0)
+    return;
+
+  devices[device_count++] = (i2c_device_t){
+      .addr = addr,
+      .mem = mem,
+      .len = len,
+  };
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef HAL_MODEL_H
+#define HAL_MODEL_H
+
+#include "hal_host.h"
+
+// Words of register file per peripheral, enough for the largest (DMA1)
+#define HAL_REG_WORDS 36
+
+// Register file index of a CMSIS register
+#define HAL_REG(type, reg) (offsetof(type, reg) / sizeof(uint32_t))
+
+typedef struct hal_model hal_model_t;
+
+/*
+ * One peripheral. A model without a read or write hook behaves as plain
+ * memory; hooks see the access after it has been counted.
+ */
+struct hal_model {
+  const char *name;
+  uintptr_t base;
+  uint32_t regs[HAL_REG_WORDS];
+  hal_counts_t counts;
+  hal_counts_t reg_counts[HAL_REG_WORDS];
+  void (*reset)(hal_model_t *model);
+  uint32_t (*read)(hal_model_t *model, uint32_t index);
+  void (*write)(hal_model_t *model, uint32_t index, uint32_t value);
+};
+
+/** True when an armed fault reaches its trigger now; disarms it. */
+bool hal_fault_take(hal_fault_t fault);
+
+hal_model_t *hal_model(hal_periph_t periph);
+
+/** Peripheral side accesses, as a DMA channel makes them; not counted. */
+uint32_t hal_bus_read(uint32_t addr);
+void hal_bus_write(uint32_t addr, uint32_t value);
+
+uint8_t hal_gpio_port(const hal_model_t *model);
+void hal_gpio_reset(hal_model_t *model);
+uint32_t hal_gpio_read(hal_model_t *model, uint32_t index);
+void hal_gpio_write(hal_model_t *model, uint32_t index, uint32_t value);
+void hal_gpio_clear_pins(void);
+
+void hal_tim_reset(hal_model_t *model);
+uint32_t hal_tim_read(hal_model_t *model, uint32_t index);
+void hal_tim_write(hal_model_t *model, uint32_t index, uint32_t value);
+
+void hal_spi_reset(hal_model_t *model);
+uint32_t hal_spi_read(hal_model_t *model, uint32_t index);
+void hal_spi_write(hal_model_t *model, uint32_t index, uint32_t value);
+
+void hal_i2c_reset(hal_model_t *model);
+uint32_t hal_i2c_read(hal_model_t *model, uint32_t index);
+void hal_i2c_write(hal_model_t *model, uint32_t index, uint32_t value);
+void hal_i2c_detach_all(void);
+bool hal_i2c_irq_pending(const hal_model_t *model, bool error);
+bool hal_i2c_dma_request(const hal_model_t *model, bool tx);
+void hal_i2c_dma_last(hal_model_t *model);
+
+void hal_dma_reset(hal_model_t *model);
+void hal_dma_write(hal_model_t *model, uint32_t index, uint32_t value);
+void hal_dma_run(hal_model_t *model);
+bool hal_dma_irq_pending(const hal_model_t *model, uint8_t channel);
+
+void hal_dwt_reset(hal_model_t *model);
+uint32_t hal_dwt_read(hal_model_t *model, uint32_t index);
+void hal_dwt_write(hal_model_t *model, uint32_t index, uint32_t value);
+
+#endif // HAL_MODEL_H
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * SPI master model. A DR write with SPE set clocks one frame out and the
+ * responder's answer in at once: TXE stays set, RXNE sets, OVR if the
+ * last answer was never read.
+ */
+
+#include "hal_model.h"
+
+#define REG_CR1 HAL_REG(SPI_TypeDef, CR1)
+#define REG_SR HAL_REG(SPI_TypeDef, SR)
+#define REG_DR HAL_REG(SPI_TypeDef, DR)
+
+static hal_spi_responder_t responder;
+static bool stalled;
+
+void hal_host_spi_set_responder(hal_spi_responder_t fn) { responder = fn; }
+
+void hal_spi_reset(hal_model_t *model) {
+  model->regs[REG_SR] = SPI_SR_TXE;
+  stalled = false;
+}
+
+uint32_t hal_spi_read(hal_model_t *model, uint32_t index) {
+  if (index == REG_SR && stalled)
+    return model->regs[REG_SR] & ~(SPI_SR_TXE | SPI_SR_RXNE);
+
+  if (index == REG_DR) {
+    model->regs[REG_SR] &= ~SPI_SR_RXNE;
+  }
+  return model->regs[index];
+}
+
+void hal_spi_write(hal_model_t *model, uint32_t index, uint32_t value) {
+  if (index == REG_CR1) {
+    model->regs[REG_CR1] = value;
+    if (!(value & SPI_CR1_SPE)) {
+      stalled = false;
+    }
+    return;
+  }
+
+  if (index != REG_DR) {
+    model->regs[index] = value;
+    return;
+  }
+
+  if (!(model->regs[REG_CR1] & SPI_CR1_SPE) || stalled)
+    return;
+
+  if (hal_fault_take(HAL_FAULT_SPI_STALL)) {
+    stalled = true;
+    return;
+  }
+  if (hal_fault_take(HAL_FAULT_SPI_NO_RXNE))
+    return;
+
+  uint8_t mosi = (uint8_t)value;
+  if (model->regs[REG_SR] & SPI_SR_RXNE) {
+    model->regs[REG_SR] |= SPI_SR_OVR;
+  }
+  model->regs[REG_DR] = responder ? responder(mosi) : mosi;
+  model->regs[REG_SR] |= SPI_SR_RXNE;
+}
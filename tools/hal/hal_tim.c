@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * General purpose timer model, counter only. Each CNT read while CEN is
+ * set moves the model clock on by 1 us, so a driver polling CNT sees time
+ * pass at the rate its prescaler asks for.
+ */
+
+#include "hal_model.h"
+
+#define TIMER_CLOCK_MHZ 72
+
+#define REG_CR1 HAL_REG(TIM_TypeDef, CR1)
+#define REG_CNT HAL_REG(TIM_TypeDef, CNT)
+#define REG_PSC HAL_REG(TIM_TypeDef, PSC)
+#define REG_ARR HAL_REG(TIM_TypeDef, ARR)
+
+static uint64_t start_us;
+static uint32_t start_cnt;
+
+static uint32_t counter(const hal_model_t *model) {
+  if (!(model->regs[REG_CR1] & TIM_CR1_CEN))
+    return model->regs[REG_CNT];
+
+  uint64_t ticks = (hal_host_now_us() - start_us) * TIMER_CLOCK_MHZ /
+                   (model->regs[REG_PSC] + 1);
+  uint32_t period = model->regs[REG_ARR] + 1;
+  return (uint32_t)((start_cnt + ticks) % period);
+}
+
+static void restart(hal_model_t *model, uint32_t cnt) {
+  start_us = hal_host_now_us();
+  start_cnt = cnt;
+  model->regs[REG_CNT] = cnt;
+}
+
+void hal_tim_reset(hal_model_t *model) {
+  model->regs[REG_ARR] = 0xFFFF;
+  restart(model, 0);
+}
+
+uint32_t hal_tim_read(hal_model_t *model, uint32_t index) {
+  if (index != REG_CNT)
+    return model->regs[index];
+
+  if (model->regs[REG_CR1] & TIM_CR1_CEN) {
+    hal_host_advance_us(1);
+  }
+  model->regs[REG_CNT] = counter(model);
+  return model->regs[REG_CNT];
+}
+
+void hal_tim_write(hal_model_t *model, uint32_t index, uint32_t value) {
+  if (index == REG_CNT) {
+    restart(model, value & 0xFFFF);
+    return;
+  }
+
+  if (index == REG_CR1) {
+    // Freeze or restart the count where it stands
+    uint32_t cnt = counter(model);
+    model->regs[REG_CR1] = value;
+    restart(model, cnt);
+    return;
+  }
+
+  model->regs[index] = value;
+}
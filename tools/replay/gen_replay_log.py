@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (C) 2025 Masoud Bolhassani
+#
+# Regenerate tools/replay/logs/drive.blrc, a synthetic controller input log
+# in the recorder's format (include/blfm_record.h): a minute of sensor frames
+# at 10 Hz with the distance sweeping through the obstacle thresholds, the
+# remote's mode, drive and servo keys with held repeats, bounced mode button
+# presses and idle IR timeout checks. Only inputs of modules enabled in
+# include/blfm_config.h go in, and the header carries that configuration.
+# Seeded, so the output is stable.
+#
+# Usage: tools/replay/gen_replay_log.py [outfile]
+
+import os
+import random
+import re
+import struct
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..")
+
+# Bit order of BLFM_RECORD_CONFIG
+CONFIG_FLAGS = ["ULTRASONIC", "POTENTIOMETER", "TEMPERATURE", "IMU", "LED",
+                "MOTOR", "DISPLAY", "ALARM", "SERVO", "OLED", "BIGSOUND",
+                "IR_REMOTE", "MODE_BUTTON", "ESP32"]
+
+SENSOR, IR, MODE_BUTTON, BIGSOUND, ESP32, IR_TIMEOUT = range(1, 7)
+
+NEC = 0
+KEYS = {"1": 0x45, "2": 0x46, "3": 0x47, "4": 0x44, "5": 0x40, "6": 0x43,
+        "8": 0x15, "9": 0x09, "0": 0x19, "up": 0x18, "down": 0x52,
+        "left": 0x08, "right": 0x5A, "ok": 0x1C}
+REPEAT = 0xFFFFFFFF
+
+
+def read_config():
+    path = os.path.join(ROOT, "include", "blfm_config.h")
+    with open(path) as f:
+        text = f.read()
+    enabled = {}
+    for name in CONFIG_FLAGS:
+        m = re.search(r"#define BLFM_ENABLED_%s (\d)" % name, text)
+        enabled[name] = bool(m and int(m.group(1)))
+    return enabled
+
+
+def varint(v):
+    out = bytearray()
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+    return bytes(out)
+
+
+class Log:
+    def __init__(self, enabled):
+        self.enabled = enabled
+        self.events = []  # (tick, order, type, payload)
+
+    def add(self, tick, type_, payload=b""):
+        self.events.append((tick, len(self.events), type_, payload))
+
+    def sensor(self, tick, distance_mm, temperature_mc, pot, imu):
+        payload = struct.pack("<BH6hiH4I", 0x0F, distance_mm, *imu,
+                              temperature_mc, pot, tick, tick, tick, tick)
+        self.add(tick, SENSOR, payload)
+
+    def ir(self, tick, key, repeat=False):
+        command = REPEAT if repeat else KEYS[key]
+        payload = struct.pack("<IIIHBB", tick, 0, command, 0x00FF, NEC,
+                              int(repeat))
+        self.add(tick, IR, payload)
+
+    def button(self, tick):
+        self.add(tick, MODE_BUTTON, struct.pack("<BI", 0, tick))
+
+    def encode(self):
+        mask = sum(1 << i for i, name in enumerate(CONFIG_FLAGS)
+                   if self.enabled[name])
+        out = bytearray(b"BLRC" + struct.pack("<BI", 1, mask))
+        prev = 0
+        for tick, _, type_, payload in sorted(self.events):
+            out += bytes([type_]) + varint(tick - prev) + payload
+            prev = tick
+        return bytes(out)
+
+
+def build(enabled):
+    rng = random.Random(19)
+    log = Log(enabled)
+
+    # Sensor hub: every 100 ms, distance sweeping 2 m down to 5 mm and back
+    for i in range(600):
+        tick = 1000 + i * 100 + rng.randint(0, 3)
+        phase = i % 120
+        distance = 2000 - phase * 33 if phase < 60 else 20 + (phase - 60) * 33
+        distance = max(5, distance + rng.randint(-15, 15))
+        imu = [rng.randint(-300, 300) for _ in range(6)]
+        log.sensor(tick, distance, 24000 + rng.randint(-500, 500),
+                   rng.randint(0, 4095), imu)
+
+    if enabled["IR_REMOTE"]:
+        script = ["2", "1", "up", "left", "right", "down", "ok", "4", "5",
+                  "6", "8", "9", "0", "3", "up", "1", "up", "ok", "2", "1"]
+        tick = 2050
+        for key in script:
+            log.ir(tick, key)
+            # Held keys send NEC repeat codes every 108 ms
+            for r in range(rng.randint(0, 4)):
+                log.ir(tick + 108 * (r + 1), key, repeat=True)
+            tick += rng.randint(1500, 3500)
+
+        # The controller task's 100 ms idle wakeups that found no input
+        for i in range(40):
+            log.add(1050 + i * 1500 + rng.randint(0, 40), IR_TIMEOUT)
+
+    if enabled["MODE_BUTTON"]:
+        for i in range(12):
+            tick = 3000 + i * 4700 + rng.randint(0, 200)
+            log.button(tick)
+            if i % 3 == 0:
+                # Contact bounce inside the 100 ms debounce
+                log.button(tick + rng.randint(5, 60))
+
+    return log
+
+
+def main():
+    out = sys.argv[1] if len(sys.argv) > 1 else os.path.join(
+        os.path.dirname(os.path.abspath(__file__)), "logs", "drive.blrc")
+    data = build(read_config()).encode()
+    os.makedirs(os.path.dirname(out) or ".", exist_ok=True)
+    with open(out, "wb") as f:
+        f.write(data)
+    print("%s: %d bytes" % (out, len(data)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Runs a controller input log (blfm_record.h) back through
+ * blfm_controller_process*() as fast as the host goes. The tick count the
+ * controller reads is the tick each input was taken at, and the command
+ * carries over between inputs as it does through the command pool, so the
+ * stream of actuator commands is the one the rover produced.
+ *
+ * -w writes that stream as a golden file; -g checks it against one, bit for
+ * bit, and exits non-zero on the first difference. The latency stamps at
+ * the end of the command are timing, not decisions, and are left out.
+ *
+ * Golden format, host byte order: "BLRG" version:u8 command_bytes:u32,
+ * then index:u32 command[command_bytes] for every input that changed the
+ * command, index being the input's position in the log.
+ *
+ * Usage: replay [-w golden | -g golden] [-f] log
+ *   -f  replay a log recorded with a different module configuration
+ */
+
+#include "blfm_controller.h"
+#include "blfm_gpio.h"
+#include "blfm_record.h"
+#include "task.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GOLDEN_VERSION 1
+#define COMMAND_BYTES offsetof(blfm_actuator_command_t, latency)
+
+static const char golden_magic[4] = {'B', 'L', 'R', 'G'};
+
+static const char *const type_names[] = {
+    [BLFM_RECORD_SENSOR] = "sensor",
+    [BLFM_RECORD_IR] = "ir",
+    [BLFM_RECORD_MODE_BUTTON] = "mode_button",
+    [BLFM_RECORD_BIGSOUND] = "bigsound",
+    [BLFM_RECORD_ESP32] = "esp32",
+    [BLFM_RECORD_IR_TIMEOUT] = "ir_timeout",
+    [BLFM_RECORD_DROPPED] = "dropped",
+};
+#define TYPE_COUNT (sizeof(type_names) / sizeof(type_names[0]))
+
+// Top-level command members, to say where two commands differ
+#define FIELD(name) {#name, offsetof(blfm_actuator_command_t, name)}
+static const struct {
+  const char *name;
+  size_t offset;
+} fields[] = {
+    FIELD(motor),  FIELD(display), FIELD(oled),   FIELD(led),
+    FIELD(alarm),  FIELD(radio),   FIELD(servo1), FIELD(servo2),
+    FIELD(servo3), FIELD(servo4),  FIELD(stepmotor),
+};
+
+static uint32_t now_tick;
+static uint32_t debug_led_toggles;
+
+TickType_t xTaskGetTickCount(void) { return now_tick; }
+
+// The mode button handler's only output besides the command
+void blfm_gpio_toggle_pin(uint32_t port, uint32_t pin) {
+  (void)port;
+  (void)pin;
+  debug_led_toggles++;
+}
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint8_t *load(const char *path, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return NULL;
+  }
+
+  size_t cap = 1 << 16;
+  uint8_t *buf = malloc(cap);
+  *len = 0;
+  size_t n;
+  while (buf && (n = fread(buf + *len, 1, cap - *len, f)) > 0) {
+    *len += n;
+    if (*len == cap) {
+      cap *= 2;
+      buf = realloc(buf, cap);
+    }
+  }
+  fclose(f);
+  return buf;
+}
+
+static const char *field_at(size_t offset) {
+  const char *name = "?";
+  for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+    if (fields[i].offset <= offset) {
+      name = fields[i].name;
+    }
+  }
+  return name;
+}
+
+/* -------------------- Golden file -------------------- */
+
+typedef struct {
+  FILE *f;
+  bool writing;
+  bool have_next;
+  uint32_t next_index;
+  uint8_t next[COMMAND_BYTES];
+  uint8_t expected[COMMAND_BYTES];
+} golden_t;
+
+static bool golden_read_next(golden_t *g) {
+  g->have_next = fread(&g->next_index, sizeof(g->next_index), 1, g->f) == 1 &&
+                 fread(g->next, sizeof(g->next), 1, g->f) == 1;
+  return g->have_next;
+}
+
+static bool golden_open(golden_t *g, const char *path, bool writing) {
+  memset(g, 0, sizeof(*g));
+  g->writing = writing;
+  g->f = fopen(path, writing ? "wb" : "rb");
+  if (!g->f) {
+    perror(path);
+    return false;
+  }
+
+  uint32_t bytes = COMMAND_BYTES;
+  uint8_t version = GOLDEN_VERSION;
+  if (writing) {
+    fwrite(golden_magic, sizeof(golden_magic), 1, g->f);
+    fwrite(&version, 1, 1, g->f);
+    fwrite(&bytes, sizeof(bytes), 1, g->f);
+    return true;
+  }
+
+  char magic[4];
+  uint32_t file_bytes;
+  if (fread(magic, sizeof(magic), 1, g->f) != 1 ||
+      memcmp(magic, golden_magic, sizeof(magic)) != 0 ||
+      fread(&version, 1, 1, g->f) != 1 || version != GOLDEN_VERSION ||
+      fread(&file_bytes, sizeof(file_bytes), 1, g->f) != 1) {
+    fprintf(stderr, "%s: not a golden file\n", path);
+    return false;
+  }
+  if (file_bytes != bytes) {
+    fprintf(stderr,
+            "%s: commands are %u bytes, here %u; blfm_actuator_command_t "
+            "changed, record it again\n",
+            path, (unsigned)file_bytes, (unsigned)bytes);
+    return false;
+  }
+  golden_read_next(g);
+  return true;
+}
+
+// Returns false when the command differs from the golden stream
+static bool golden_step(golden_t *g, uint32_t index, const uint8_t *cmd,
+                        const uint8_t *prev) {
+  if (g->writing) {
+    if (memcmp(cmd, prev, COMMAND_BYTES) != 0) {
+      fwrite(&index, sizeof(index), 1, g->f);
+      fwrite(cmd, COMMAND_BYTES, 1, g->f);
+    }
+    return true;
+  }
+
+  if (g->have_next && g->next_index == index) {
+    memcpy(g->expected, g->next, COMMAND_BYTES);
+    golden_read_next(g);
+  }
+  return memcmp(cmd, g->expected, COMMAND_BYTES) == 0;
+}
+
+/* -------------------- Replay -------------------- */
+
+static void dispatch(const blfm_record_t *rec, blfm_actuator_command_t *cmd) {
+  switch (rec->type) {
+  case BLFM_RECORD_SENSOR:
+    blfm_controller_process(&rec->sensor, cmd);
+    break;
+#if BLFM_ENABLED_IR_REMOTE
+  case BLFM_RECORD_IR:
+    blfm_controller_process_ir_remote(&rec->ir, cmd);
+    break;
+  case BLFM_RECORD_IR_TIMEOUT:
+    blfm_controller_check_ir_timeout(cmd);
+    break;
+#endif
+#if BLFM_ENABLED_MODE_BUTTON
+  case BLFM_RECORD_MODE_BUTTON:
+    blfm_controller_process_mode_button(&rec->mode_button, cmd);
+    break;
+#endif
+#if BLFM_ENABLED_BIGSOUND
+  case BLFM_RECORD_BIGSOUND:
+    blfm_controller_process_bigsound(&rec->bigsound, cmd);
+    break;
+#endif
+#if BLFM_ENABLED_ESP32
+  case BLFM_RECORD_ESP32:
+    blfm_controller_process_esp32(&rec->esp32, cmd);
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: replay [-w golden | -g golden] [-f] log\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  const char *golden_path = NULL;
+  bool writing = false;
+  bool force = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "w:g:f")) != -1) {
+    switch (opt) {
+    case 'w':
+    case 'g':
+      if (golden_path)
+        usage();
+      golden_path = optarg;
+      writing = opt == 'w';
+      break;
+    case 'f':
+      force = true;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind != argc - 1)
+    usage();
+  const char *log_path = argv[optind];
+
+  size_t len;
+  uint8_t *log = load(log_path, &len);
+  if (!log)
+    return EXIT_FAILURE;
+
+  // A UART capture may start with boot noise ahead of the header
+  size_t pos = 0;
+  uint32_t config = 0;
+  while (pos < len &&
+         !blfm_record_decode_header(log + pos, (uint32_t)(len - pos), &config)) {
+    pos++;
+  }
+  if (pos == len) {
+    fprintf(stderr, "%s: no record header\n", log_path);
+    return EXIT_FAILURE;
+  }
+  pos += BLFM_RECORD_HEADER_BYTES;
+  if (config != BLFM_RECORD_CONFIG) {
+    fprintf(stderr,
+            "%s: recorded with module mask 0x%04x, built with 0x%04x%s\n",
+            log_path, (unsigned)config, (unsigned)BLFM_RECORD_CONFIG,
+            force ? "" : "; -f to replay anyway");
+    if (!force)
+      return EXIT_FAILURE;
+  }
+
+  golden_t golden;
+  if (golden_path && !golden_open(&golden, golden_path, writing))
+    return EXIT_FAILURE;
+
+  static blfm_actuator_command_t cmd;
+  blfm_actuator_command_t prev;
+  uint32_t counts[TYPE_COUNT] = {0};
+  uint32_t inputs = 0;
+  uint32_t changes = 0;
+  uint32_t dropped = 0;
+  uint32_t first_tick = 0;
+  bool ok = true;
+
+  blfm_controller_init();
+  double start = now_s();
+
+  while (pos < len) {
+    blfm_record_t rec;
+    int32_t used = blfm_record_decode(log + pos, (uint32_t)(len - pos),
+                                      now_tick, &rec);
+    if (used == 0) {
+      fprintf(stderr, "%s: log ends mid-record\n", log_path);
+      break;
+    }
+    if (used < 0) {
+      fprintf(stderr, "%s: unknown record type %u at byte %zu\n", log_path,
+              rec.type, pos);
+      ok = false;
+      break;
+    }
+    pos += (size_t)used;
+    if (inputs == 0) {
+      first_tick = rec.tick;
+    }
+    now_tick = rec.tick;
+    counts[rec.type]++;
+
+    if (rec.type == BLFM_RECORD_DROPPED) {
+      dropped += rec.dropped;
+      continue;
+    }
+
+    prev = cmd;
+    dispatch(&rec, &cmd);
+    if (memcmp(&cmd, &prev, COMMAND_BYTES) != 0) {
+      changes++;
+    }
+
+    if (golden_path &&
+        !golden_step(&golden, inputs, (const uint8_t *)&cmd,
+                     (const uint8_t *)&prev)) {
+      const uint8_t *a = (const uint8_t *)&cmd;
+      size_t at = 0;
+      while (a[at] == golden.expected[at]) {
+        at++;
+      }
+      printf("MISMATCH input %u (%s, tick %u): %s differs at command byte "
+             "%zu\n",
+             (unsigned)inputs, type_names[rec.type], (unsigned)rec.tick,
+             field_at(at), at);
+      ok = false;
+      break;
+    }
+    inputs++;
+  }
+
+  double elapsed = now_s() - start;
+
+  printf("%s: %u inputs over %u ticks, %u command changes, %u LED toggles\n",
+         log_path, (unsigned)inputs, (unsigned)(now_tick - first_tick),
+         (unsigned)changes, (unsigned)debug_led_toggles);
+  for (size_t t = 1; t < TYPE_COUNT; t++) {
+    if (counts[t]) {
+      printf("  %-12s %u\n", type_names[t], (unsigned)counts[t]);
+    }
+  }
+  if (dropped) {
+    printf("  %u input(s) lost on the target; the replay has gaps\n",
+           (unsigned)dropped);
+  }
+  printf("replayed in %.3f ms, %.1f M inputs/s\n", elapsed * 1e3,
+         elapsed > 0 ? inputs / elapsed / 1e6 : 0.0);
+
+  if (golden_path) {
+    if (!writing && ok && golden.have_next) {
+      printf("MISMATCH golden continues past input %u\n",
+             (unsigned)golden.next_index);
+      ok = false;
+    }
+    fclose(golden.f);
+    if (ok) {
+      printf("%s %s\n", writing ? "wrote" : "matches", golden_path);
+    }
+  }
+  free(log);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
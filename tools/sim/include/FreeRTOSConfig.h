@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*
+ * Kernel configuration for `make sim` on the FreeRTOS POSIX port. Everything
+ * the firmware can observe matches include/FreeRTOSConfig.h: tick rate,
+ * priority count, tick width and the trace hooks. The rest is what the port
+ * needs: pthread sized stacks, a bigger heap, no tickless idle and no
+ * interrupt priorities.
+ */
+
+#include <stdint.h>
+#include "blfm_config.h"
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_IDLE_HOOK                     0
+#define configUSE_TICK_HOOK                     0
+#define configCPU_CLOCK_HZ                      ((uint32_t)72000000)
+#define configTICK_RATE_HZ                      ((TickType_t)1000)
+#define configMAX_PRIORITIES                    10
+#define configTICK_TYPE_WIDTH_IN_BITS           TICK_TYPE_WIDTH_32_BITS
+#define configMAX_TASK_NAME_LEN                 16
+#define configUSE_TRACE_FACILITY                1
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TICKLESS_IDLE                 0
+
+/* Added to every task row; glibc alone needs more than the target stacks */
+#define BLFM_SIM_STACK_WORDS                    4096
+#define BLFM_TASK_STACK_WORDS(words)            ((words) + BLFM_SIM_STACK_WORDS)
+#define configMINIMAL_STACK_SIZE                ((uint16_t)BLFM_SIM_STACK_WORDS)
+#define configTOTAL_HEAP_SIZE                   ((size_t)(1024 * 1024))
+
+#define configUSE_MUTEXES                       1
+#define configQUEUE_REGISTRY_SIZE               0
+#define configCHECK_FOR_STACK_OVERFLOW          2
+#define configUSE_RECURSIVE_MUTEXES             0
+#define configUSE_MALLOC_FAILED_HOOK            0
+
+/* The simulator always allocates from the heap */
+#define BLFM_STATIC_ALLOCATION                  0
+#define configSUPPORT_STATIC_ALLOCATION         0
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+
+#define configUSE_TIMERS                        0
+#define configUSE_QUEUE_SETS 1
+
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskDelayUntil 1
+#define INCLUDE_vTaskDelete 1
+#define INCLUDE_xSemaphoreGetMutexHolder 1
+#define INCLUDE_vTaskSuspend 1
+#define INCLUDE_xTaskGetSchedulerState    1
+#define INCLUDE_xTaskGetIdleTaskHandle    1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+
+/* A failed assertion ends the run, so regressions cannot pass silently */
+void sim_assert_failed(const char *file, int line);
+#define configASSERT(x)                                                        \
+  do {                                                                         \
+    if (!(x))                                                                  \
+      sim_assert_failed(__FILE__, __LINE__);                                   \
+  } while (0)
+
+/* cpuload, monitoring and trace hooks, shared with the target config */
+#include "blfm_rtos_hooks.h"
+
+#endif /* FREERTOS_CONFIG_H */
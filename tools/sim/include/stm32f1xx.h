@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef SIM_STM32F1XX_H
+#define SIM_STM32F1XX_H
+
+/*
+ * Host stand-in for the CMSIS device header, for `make sim`. Only what the
+ * modules built into the simulator touch is here. Drivers that program
+ * peripherals are replaced by tools/sim backends instead of compiled.
+ *
+ * Port addresses keep their real values so pin tables and the
+ * (uint32_t)GPIOx casts still work; the sim backends only compare them
+ * and never dereference them.
+ */
+
+#include <stdint.h>
+
+#define __IO volatile
+#define __NVIC_PRIO_BITS 4
+
+typedef struct {
+  __IO uint32_t CRL;
+  __IO uint32_t CRH;
+  __IO uint32_t IDR;
+  __IO uint32_t ODR;
+  __IO uint32_t BSRR;
+  __IO uint32_t BRR;
+  __IO uint32_t LCKR;
+} GPIO_TypeDef;
+
+#define GPIOA ((GPIO_TypeDef *)0x40010800UL)
+#define GPIOB ((GPIO_TypeDef *)0x40010C00UL)
+#define GPIOC ((GPIO_TypeDef *)0x40011000UL)
+
+typedef struct {
+  __IO uint32_t CTRL;
+  __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+  __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+/* CYCCNT counts host time at SystemCoreClock; refreshed on every access */
+DWT_Type *sim_dwt(void);
+#define DWT (sim_dwt())
+
+extern CoreDebug_Type sim_core_debug;
+#define CoreDebug (&sim_core_debug)
+
+extern uint32_t SystemCoreClock;
+
+/* PRIMASK masks the port's tick signal, the nearest thing to an IRQ */
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+
+#endif // SIM_STM32F1XX_H
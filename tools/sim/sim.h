@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+/*
+ * Host simulator: the real task graph on the FreeRTOS POSIX port, with the
+ * hardware drivers swapped for the backends below. Inputs come from a
+ * script, outputs are logged with the tick they happened on.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Log one line prefixed with the current tick. Dropped in quiet mode.
+ */
+void sim_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Inputs, called from the script task. Each returns false when the module
+// behind it is disabled in blfm_config.h.
+bool sim_ultrasonic_set(uint16_t distance_mm, bool echo);
+bool sim_ir_press(uint16_t address, uint16_t command, bool repeat);
+bool sim_mode_button(bool pressed);
+bool sim_bigsound(void);
+
+// Output counters for the end-of-run report
+typedef struct {
+  uint32_t gpio_writes;
+  uint32_t pwm_updates;
+  uint32_t pwm_cycles;
+  uint32_t motor_updates;
+} sim_output_stats_t;
+
+void sim_get_output_stats(sim_output_stats_t *out);
+
+#endif // SIM_H
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Cortex-M3 core pieces the firmware touches directly (DWT, PRIMASK), and
+ * the clock scaling that runs the simulation faster than real time.
+ */
+
+#include "sim_core.h"
+#include "FreeRTOS.h"
+#include "stm32f1xx.h"
+#include "task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+uint32_t SystemCoreClock = configCPU_CLOCK_HZ;
+CoreDebug_Type sim_core_debug;
+
+static DWT_Type dwt;
+static uint32_t primask;
+static uint32_t speed = 1;
+
+void sim_core_set_speed(uint32_t factor) { speed = factor ? factor : 1; }
+
+uint32_t sim_core_get_speed(void) { return speed; }
+
+uint64_t sim_core_host_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Cycles at the simulated clock, so one tick is always 72000 cycles
+DWT_Type *sim_dwt(void) {
+  uint64_t ns = sim_core_host_ns() * speed;
+  dwt.CYCCNT = (uint32_t)(ns * (configCPU_CLOCK_HZ / 1000000) / 1000);
+  return &dwt;
+}
+
+uint32_t __get_PRIMASK(void) { return primask; }
+
+void __disable_irq(void) {
+  portDISABLE_INTERRUPTS();
+  primask = 1;
+}
+
+void __enable_irq(void) {
+  primask = 0;
+  portENABLE_INTERRUPTS();
+}
+
+void __set_PRIMASK(uint32_t value) {
+  if (value) {
+    __disable_irq();
+  } else {
+    __enable_irq();
+  }
+}
+
+void sim_assert_failed(const char *file, int line) {
+  fflush(stdout);
+  fprintf(stderr, "configASSERT failed at %s:%d, tick %lu\n", file, line,
+          (unsigned long)xTaskGetTickCount());
+  exit(EXIT_FAILURE);
+}
+
+/*
+ * The POSIX port paces its tick with usleep() or setitimer(), depending on
+ * the kernel version. The link wraps both (-Wl,--wrap) and shortens every
+ * period by the speed factor, so a tick stays one simulated millisecond.
+ */
+int __real_usleep(useconds_t us);
+int __real_setitimer(int which, const struct itimerval *value,
+                     struct itimerval *old);
+
+int __wrap_usleep(useconds_t us) {
+  useconds_t scaled = us / speed;
+  return __real_usleep(scaled ? scaled : 1);
+}
+
+static void scale_timeval(struct timeval *tv) {
+  uint64_t us = (uint64_t)tv->tv_sec * 1000000u + (uint64_t)tv->tv_usec;
+  if (us == 0)
+    return;
+
+  us /= speed;
+  if (us == 0) {
+    us = 1;
+  }
+  tv->tv_sec = (time_t)(us / 1000000u);
+  tv->tv_usec = (suseconds_t)(us % 1000000u);
+}
+
+int __wrap_setitimer(int which, const struct itimerval *value,
+                     struct itimerval *old) {
+  struct itimerval scaled = *value;
+  scale_timeval(&scaled.it_interval);
+  scale_timeval(&scaled.it_value);
+  return __real_setitimer(which, &scaled, old);
+}
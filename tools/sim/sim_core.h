@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+#ifndef SIM_CORE_H
+#define SIM_CORE_H
+
+#include <stdint.h>
+
+/**
+ * Simulated time runs this many times faster than the host clock. Set
+ * before the scheduler starts.
+ */
+void sim_core_set_speed(uint32_t factor);
+uint32_t sim_core_get_speed(void);
+
+uint64_t sim_core_host_ns(void);
+
+#endif // SIM_CORE_H
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Simulated input drivers. Each implements its module's public API and
+ * delivers what the script injects along the same path the hardware would:
+ * the sensor hub reads ultrasonic distances, events land in the same
+ * controller queues, IR frames are posted from the IRDecode task.
+ */
+
+#include "sim.h"
+#include "FreeRTOS.h"
+#include "blfm_latency.h"
+#include "blfm_taskmanager.h"
+#include "blfm_types.h"
+#include "queue.h"
+#include "stm32f1xx.h"
+#include "task.h"
+
+#if BLFM_ENABLED_ULTRASONIC
+#include "blfm_ultrasonic.h"
+#endif
+
+#if BLFM_ENABLED_IR_REMOTE
+#include "blfm_ir_decoder.h"
+#include "blfm_ir_remote.h"
+#endif
+
+#if BLFM_ENABLED_MODE_BUTTON
+#include "blfm_mode_button.h"
+#endif
+
+#if BLFM_ENABLED_BIGSOUND
+#include "blfm_bigsound.h"
+#endif
+
+// ===============================================================
+// Ultrasonic
+// ===============================================================
+#if BLFM_ENABLED_ULTRASONIC
+// Sound covers about 0.343 mm/us, there and back
+#define ECHO_US_PER_MM 6
+
+static uint16_t distance_mm = 4000;
+static bool echo = true;
+
+void blfm_ultrasonic_init(void) {}
+
+// The real driver busy-waits for the echo; the time passes here as a delay
+bool blfm_ultrasonic_measure(blfm_ultrasonic_data_t *data) {
+  if (!data)
+    return false;
+
+  uint16_t mm = distance_mm;
+  bool found = echo;
+  vTaskDelay(pdMS_TO_TICKS(found ? mm * ECHO_US_PER_MM / 1000 + 1 : 30));
+  if (!found)
+    return false;
+
+  data->distance_mm = mm;
+  return true;
+}
+
+bool sim_ultrasonic_set(uint16_t mm, bool found) {
+  distance_mm = mm;
+  echo = found;
+  return true;
+}
+#else
+bool sim_ultrasonic_set(uint16_t mm, bool found) {
+  (void)mm;
+  (void)found;
+  return false;
+}
+#endif
+
+// ===============================================================
+// IR remote
+// ===============================================================
+#if BLFM_ENABLED_IR_REMOTE
+#define IR_PENDING 8
+
+static QueueHandle_t ir_controller_queue = NULL;
+static QueueHandle_t ir_pending = NULL;
+static blfm_ir_remote_stats_t ir_stats;
+
+void blfm_ir_remote_init(QueueHandle_t controller_queue) {
+  ir_controller_queue = controller_queue;
+  ir_pending = xQueueCreate(IR_PENDING, sizeof(blfm_ir_remote_event_t));
+  configASSERT(ir_pending != NULL);
+}
+
+void ir_exti_handler(void) {}
+
+// Stands in for the decoder: frames come whole, already decoded
+void blfm_ir_remote_task(void *params) {
+  (void)params;
+  blfm_ir_remote_event_t event;
+
+  for (;;) {
+    xQueuePeek(ir_pending, &event, portMAX_DELAY);
+
+    blfm_taskmanager_cycle_begin(BLFM_TASK_IR_DECODE, xTaskGetTickCount());
+    while (xQueueReceive(ir_pending, &event, 0) == pdPASS) {
+      ir_stats.frames[event.protocol]++;
+      xQueueSendToBack(ir_controller_queue, &event, 0);
+    }
+    blfm_taskmanager_cycle_end(BLFM_TASK_IR_DECODE);
+  }
+}
+
+void blfm_ir_remote_get_stats(blfm_ir_remote_stats_t *out) {
+  if (!out)
+    return;
+
+  taskENTER_CRITICAL();
+  *out = ir_stats;
+  taskEXIT_CRITICAL();
+}
+
+bool sim_ir_press(uint16_t address, uint16_t command, bool repeat) {
+  TickType_t now = xTaskGetTickCount();
+  blfm_ir_remote_event_t event = {
+      .timestamp = now,
+      .command = (blfm_ir_command_t)command,
+      .address = address,
+      .protocol = BLFM_IR_PROTO_NEC,
+      .repeat = repeat,
+  };
+
+  // The frame's last edge is now
+  blfm_latency_origin(&event.corr, BLFM_LATENCY_PATH_IR, DWT->CYCCNT, now);
+  if (xQueueSendToBack(ir_pending, &event, 0) != pdPASS) {
+    ir_stats.overruns++;
+  }
+  return true;
+}
+#else
+bool sim_ir_press(uint16_t address, uint16_t command, bool repeat) {
+  (void)address;
+  (void)command;
+  (void)repeat;
+  return false;
+}
+#endif
+
+// ===============================================================
+// Mode button
+// ===============================================================
+#if BLFM_ENABLED_MODE_BUTTON
+static QueueHandle_t mode_button_queue = NULL;
+
+void blfm_mode_button_init(QueueHandle_t controller_queue) {
+  mode_button_queue = controller_queue;
+}
+
+bool sim_mode_button(bool pressed) {
+  blfm_mode_button_event_t event = {
+      .event_type = pressed ? BLFM_MODE_BUTTON_EVENT_PRESSED
+                            : BLFM_MODE_BUTTON_EVENT_RELEASED,
+      .timestamp = xTaskGetTickCount(),
+  };
+  xQueueSendToBack(mode_button_queue, &event, 0);
+  return true;
+}
+#else
+bool sim_mode_button(bool pressed) {
+  (void)pressed;
+  return false;
+}
+#endif
+
+// ===============================================================
+// Big sound
+// ===============================================================
+#if BLFM_ENABLED_BIGSOUND
+static QueueHandle_t bigsound_queue = NULL;
+
+void blfm_bigsound_init(QueueHandle_t controller_queue) {
+  bigsound_queue = controller_queue;
+}
+
+void blfm_bigsound_isr_handler(void) {}
+
+bool sim_bigsound(void) {
+  blfm_bigsound_event_t event = {
+      .timestamp = xTaskGetTickCount(),
+      .event_type = BIGSOUND_EVENT_DETECTED,
+  };
+  xQueueSendToBack(bigsound_queue, &event, 0);
+  return true;
+}
+#else
+bool sim_bigsound(void) { return false; }
+#endif
@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Entry point of `make sim`. Sets the task graph up exactly as belfhym.c
+ * does, adds one top-priority task that plays the input script, and prints
+ * a timing report when the run ends.
+ *
+ * Script lines are "<ms> <event> [args]", in time order, # starts a comment:
+ *   ultrasonic <mm> | none     distance the next measurements return
+ *   ir <command> [repeat]      NEC frame from the rover's remote
+ *   button press | release     mode button edge
+ *   bigsound                   sound detector trigger
+ *   end                        stop the run
+ *
+ * Usage: belfhym_sim [-q] [-x speed] [-t ms] [script]
+ */
+
+#include "sim.h"
+#include "sim_core.h"
+#include "FreeRTOS.h"
+#include "blfm_cpuload.h"
+#include "blfm_gpio.h"
+#include "blfm_latency.h"
+#include "blfm_monitoring.h"
+#include "blfm_taskmanager.h"
+#include "task.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if BLFM_SENSOR_CYCLIC_EXEC
+#error "make sim: the cyclic executive is released by TIM3, which is not simulated"
+#endif
+
+#if BLFM_ENABLED_POTENTIOMETER || BLFM_ENABLED_TEMPERATURE ||                  \
+    BLFM_ENABLED_IMU || BLFM_ENABLED_DISPLAY || BLFM_ENABLED_OLED ||           \
+    BLFM_ENABLED_RADIO || BLFM_ENABLED_ESP32 || BLFM_ENABLED_TRACE
+#error "make sim: an enabled module has no simulated backend in tools/sim"
+#endif
+
+#define NEC_ROVER_ADDRESS 0xFF00
+#define DEFAULT_RUN_MS 10000
+#define DEFAULT_SPEED 10
+#define MAX_EVENTS 1024
+#define SCRIPT_STACK_WORDS 512
+
+typedef enum {
+  EV_ULTRASONIC,
+  EV_IR,
+  EV_BUTTON,
+  EV_BIGSOUND,
+  EV_END,
+} event_type_t;
+
+typedef struct {
+  uint32_t at_ms;
+  uint8_t type;
+  bool flag; // Echo, repeat or pressed
+  uint16_t value;
+  uint16_t line;
+} sim_event_t;
+
+static sim_event_t events[MAX_EVENTS];
+static uint16_t event_count;
+static const char *script_path;
+static uint32_t run_ms;
+static bool quiet;
+static uint64_t host_start_ns;
+
+void sim_log(const char *fmt, ...) {
+  if (quiet)
+    return;
+
+  bool running = xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+  va_list ap;
+  va_start(ap, fmt);
+  if (running) {
+    vTaskSuspendAll();
+  }
+  printf("[%8lu] ", running ? (unsigned long)xTaskGetTickCount() : 0ul);
+  vprintf(fmt, ap);
+  putchar('\n');
+  if (running) {
+    xTaskResumeAll();
+  }
+  va_end(ap);
+}
+
+// ===============================================================
+// Script
+// ===============================================================
+static int parse_line(char *line, uint16_t number, sim_event_t *ev) {
+  char *hash = strchr(line, '#');
+  if (hash) {
+    *hash = '\0';
+  }
+
+  char name[16] = "";
+  char arg[16] = "";
+  char arg2[16] = "";
+  unsigned long at;
+  int fields = sscanf(line, "%lu %15s %15s %15s", &at, name, arg, arg2);
+  if (fields <= 0)
+    return 0; // Blank or comment
+  if (fields < 2)
+    return -1;
+
+  memset(ev, 0, sizeof(*ev));
+  ev->at_ms = (uint32_t)at;
+  ev->line = number;
+
+  if (strcmp(name, "ultrasonic") == 0 && fields >= 3) {
+    ev->type = EV_ULTRASONIC;
+    ev->flag = strcmp(arg, "none") != 0;
+    ev->value = ev->flag ? (uint16_t)strtoul(arg, NULL, 0) : 0;
+  } else if (strcmp(name, "ir") == 0 && fields >= 3) {
+    ev->type = EV_IR;
+    ev->value = (uint16_t)strtoul(arg, NULL, 0);
+    ev->flag = fields >= 4 && strcmp(arg2, "repeat") == 0;
+  } else if (strcmp(name, "button") == 0 && fields >= 3) {
+    ev->type = EV_BUTTON;
+    ev->flag = strcmp(arg, "press") == 0;
+    if (!ev->flag && strcmp(arg, "release") != 0)
+      return -1;
+  } else if (strcmp(name, "bigsound") == 0) {
+    ev->type = EV_BIGSOUND;
+  } else if (strcmp(name, "end") == 0) {
+    ev->type = EV_END;
+  } else {
+    return -1;
+  }
+  return 1;
+}
+
+static bool load_script(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+
+  char line[128];
+  uint16_t number = 0;
+  uint32_t last_ms = 0;
+  while (fgets(line, sizeof(line), f)) {
+    number++;
+    sim_event_t ev;
+    int result = parse_line(line, number, &ev);
+    if (result == 0)
+      continue;
+    if (result < 0 || ev.at_ms < last_ms || event_count == MAX_EVENTS) {
+      fprintf(stderr, "%s:%u: bad or out of order event\n", path, number);
+      fclose(f);
+      return false;
+    }
+    last_ms = ev.at_ms;
+    events[event_count++] = ev;
+  }
+
+  fclose(f);
+  return true;
+}
+
+static void apply_event(const sim_event_t *ev) {
+  bool handled = true;
+
+  switch (ev->type) {
+  case EV_ULTRASONIC:
+    handled = sim_ultrasonic_set(ev->value, ev->flag);
+    if (ev->flag) {
+      sim_log("script ultrasonic %u mm", ev->value);
+    } else {
+      sim_log("script ultrasonic no echo");
+    }
+    break;
+  case EV_IR:
+    handled = sim_ir_press(NEC_ROVER_ADDRESS, ev->value, ev->flag);
+    sim_log("script ir 0x%02X%s", ev->value, ev->flag ? " repeat" : "");
+    break;
+  case EV_BUTTON:
+    handled = sim_mode_button(ev->flag);
+    sim_log("script button %s", ev->flag ? "press" : "release");
+    break;
+  case EV_BIGSOUND:
+    handled = sim_bigsound();
+    sim_log("script bigsound");
+    break;
+  default:
+    break;
+  }
+
+  if (!handled) {
+    fprintf(stderr, "%s:%u: module disabled in blfm_config.h, ignored\n",
+            script_path, ev->line);
+  }
+}
+
+// ===============================================================
+// Report
+// ===============================================================
+static void print_report(void) {
+  TickType_t ticks = xTaskGetTickCount();
+  double host_s = (double)(sim_core_host_ns() - host_start_ns) / 1e9;
+
+  printf("\n%lu ms simulated in %.2f s host time (%.1fx)\n",
+         (unsigned long)ticks, host_s,
+         host_s > 0 ? (double)ticks / 1000.0 / host_s : 0.0);
+
+  printf("\n%-16s %4s %8s %9s %9s %7s\n", "task", "prio", "cycles",
+         "resp_max", "jit_max", "misses");
+  for (uint8_t i = 0; i < BLFM_TASK_COUNT; i++) {
+    TaskHandle_t handle = blfm_taskmanager_get_handle((blfm_task_id_t)i);
+    if (!handle)
+      continue;
+
+    blfm_task_timing_t timing;
+    blfm_taskmanager_get_timing((blfm_task_id_t)i, &timing);
+    printf("%-16s %4lu %8lu %9lu %9lu %7lu\n", pcTaskGetName(handle),
+           (unsigned long)blfm_taskmanager_get_priority((blfm_task_id_t)i),
+           (unsigned long)timing.cycles, (unsigned long)timing.response_max,
+           (unsigned long)timing.jitter_max,
+           (unsigned long)timing.deadline_misses);
+  }
+
+  static const char *const path_names[BLFM_LATENCY_PATH_COUNT] = {
+      [BLFM_LATENCY_PATH_IR] = "IR",
+      [BLFM_LATENCY_PATH_SENSOR] = "sensor",
+  };
+  printf("\n%-16s %8s %10s\n", "latency", "count", "max_us");
+  for (uint8_t p = BLFM_LATENCY_PATH_IR; p < BLFM_LATENCY_PATH_COUNT; p++) {
+    blfm_latency_hist_t hist;
+    blfm_latency_get((blfm_latency_path_t)p, BLFM_LATENCY_SEG_TOTAL, &hist);
+    printf("%-16s %8lu %10lu\n", path_names[p], (unsigned long)hist.count,
+           (unsigned long)hist.max_us);
+  }
+
+  blfm_monitoring_report_t report;
+  blfm_monitoring_sample();
+  blfm_monitoring_get_report(&report);
+  printf("\n%-16s %6s %6s %6s\n", "queue", "peak", "length", "full");
+  for (uint8_t i = 0; i < report.queue_count; i++) {
+    printf("%-16s %6u %6u %6u\n", report.queues[i].name, report.queues[i].peak,
+           report.queues[i].length, report.queues[i].full);
+  }
+
+  sim_output_stats_t outputs;
+  sim_get_output_stats(&outputs);
+  printf("\ngpio writes %lu, pwm updates %lu, pwm cycles %lu, "
+         "motor updates %lu\n",
+         (unsigned long)outputs.gpio_writes, (unsigned long)outputs.pwm_updates,
+         (unsigned long)outputs.pwm_cycles,
+         (unsigned long)outputs.motor_updates);
+  fflush(stdout);
+}
+
+static void script_task(void *params) {
+  (void)params;
+  TickType_t start = xTaskGetTickCount();
+  TickType_t last = start;
+  uint32_t end_ms = run_ms;
+
+  host_start_ns = sim_core_host_ns();
+  for (uint16_t i = 0; i < event_count; i++) {
+    const sim_event_t *ev = &events[i];
+    if (ev->at_ms >= end_ms)
+      break;
+
+    TickType_t due = start + pdMS_TO_TICKS(ev->at_ms);
+    if (due > last) {
+      xTaskDelayUntil(&last, due - last);
+    }
+    if (ev->type == EV_END) {
+      end_ms = ev->at_ms;
+      break;
+    }
+    apply_event(ev);
+  }
+
+  TickType_t due = start + pdMS_TO_TICKS(end_ms);
+  if (due > last) {
+    xTaskDelayUntil(&last, due - last);
+  }
+
+  vTaskSuspendAll();
+  print_report();
+  exit(EXIT_SUCCESS);
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [-q] [-x speed] [-t ms] [script]\n"
+          "  -q        report only, no output log\n"
+          "  -x speed  simulated time per host time, default %d\n"
+          "  -t ms     stop after this long, default: the script's end "
+          "event, else %d\n",
+          argv0, DEFAULT_SPEED, DEFAULT_RUN_MS);
+}
+
+int main(int argc, char **argv) {
+  uint32_t speed = DEFAULT_SPEED;
+  long duration = -1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "qx:t:h")) != -1) {
+    switch (opt) {
+    case 'q':
+      quiet = true;
+      break;
+    case 'x':
+      speed = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 't':
+      duration = strtol(optarg, NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (optind < argc) {
+    script_path = argv[optind];
+    if (!load_script(script_path))
+      return EXIT_FAILURE;
+  }
+
+  run_ms = duration >= 0 ? (uint32_t)duration : DEFAULT_RUN_MS;
+  if (duration < 0) {
+    for (uint16_t i = 0; i < event_count; i++) {
+      if (events[i].type == EV_END) {
+        run_ms = events[i].at_ms;
+        break;
+      }
+    }
+  }
+  sim_core_set_speed(speed);
+
+  // blfm_board_init() in the firmware; clocks and NVIC have no host side
+  blfm_gpio_init();
+
+  blfm_taskmanager_setup();
+
+  BaseType_t result = xTaskCreate(script_task, "SimScript",
+                                  BLFM_TASK_STACK_WORDS(SCRIPT_STACK_WORDS),
+                                  NULL, configMAX_PRIORITIES - 1, NULL);
+  configASSERT(result == pdPASS);
+
+  blfm_taskmanager_start();
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2025 Masoud Bolhassani <masoud.bolhassani@gmail.com>
+ *
+ * This file is part of Belfhym.
+ *
+ * Belfhym is released under the GNU General Public License v3 (GPL-3.0).
+ * See LICENSE file for details.
+ */
+
+/*
+ * Simulated GPIO, PWM and motor drivers. They keep the state the real
+ * drivers would put in registers and log every change.
+ */
+
+#include "sim.h"
+#include "FreeRTOS.h"
+#include "blfm_gpio.h"
+#include "blfm_pwm.h"
+#include "task.h"
+#include <string.h>
+
+#if BLFM_ENABLED_MOTOR
+#include "blfm_motor.h"
+#endif
+
+#define PORT_COUNT 3
+
+static uint16_t pin_output[PORT_COUNT]; // Pins configured as outputs
+static uint16_t pin_level[PORT_COUNT];
+static uint16_t pulse_us[BLFM_PWM_MAX_CHANNELS];
+static sim_output_stats_t stats;
+
+static int port_index(uint32_t port) {
+  if (port == (uint32_t)GPIOA)
+    return 0;
+  if (port == (uint32_t)GPIOB)
+    return 1;
+  if (port == (uint32_t)GPIOC)
+    return 2;
+  return -1;
+}
+
+void blfm_gpio_init(void) {
+  memset(pin_output, 0, sizeof(pin_output));
+  // Inputs idle high behind their pull-ups
+  memset(pin_level, 0xFF, sizeof(pin_level));
+}
+
+static void config_pin(uint32_t port, uint32_t pin, bool output) {
+  int p = port_index(port);
+  if (p < 0 || pin > 15)
+    return;
+
+  if (output) {
+    pin_output[p] |= 1u << pin;
+  } else {
+    pin_output[p] &= ~(1u << pin);
+  }
+}
+
+void blfm_gpio_config_output(uint32_t port, uint32_t pin) {
+  config_pin(port, pin, true);
+}
+
+void blfm_gpio_config_input(uint32_t port, uint32_t pin) {
+  config_pin(port, pin, false);
+}
+
+void blfm_gpio_config_input_pullup(uint32_t port, uint32_t pin) {
+  config_pin(port, pin, false);
+}
+
+void blfm_gpio_config_analog(uint32_t port, uint32_t pin) {
+  config_pin(port, pin, false);
+}
+
+void blfm_gpio_config_alternate_pushpull(uint32_t port, uint32_t pin) {
+  config_pin(port, pin, true);
+}
+
+static void write_pin(uint32_t port, uint32_t pin, int level) {
+  int p = port_index(port);
+  if (p < 0 || pin > 15)
+    return;
+
+  uint16_t mask = 1u << pin;
+  int old = (pin_level[p] & mask) != 0;
+  if (level < 0) {
+    level = !old;
+  }
+
+  stats.gpio_writes++;
+  if (level == old)
+    return;
+
+  if (level) {
+    pin_level[p] |= mask;
+  } else {
+    pin_level[p] &= ~mask;
+  }
+  if (pin_output[p] & mask) {
+    sim_log("gpio P%c%lu %d", 'A' + p, (unsigned long)pin, level);
+  }
+}
+
+void blfm_gpio_set_pin(uint32_t port, uint32_t pin) { write_pin(port, pin, 1); }
+
+void blfm_gpio_clear_pin(uint32_t port, uint32_t pin) {
+  write_pin(port, pin, 0);
+}
+
+void blfm_gpio_toggle_pin(uint32_t port, uint32_t pin) {
+  write_pin(port, pin, -1);
+}
+
+int blfm_gpio_read_pin(uint32_t port, uint32_t pin) {
+  int p = port_index(port);
+  if (p < 0 || pin > 15)
+    return 0;
+  return (pin_level[p] >> pin) & 1;
+}
+
+void blfm_pwm_init(void) {
+  for (uint8_t i = 0; i < BLFM_PWM_MAX_CHANNELS; i++) {
+    pulse_us[i] = 1500;
+  }
+}
+
+void blfm_pwm_set_pulse_us(uint8_t channel, uint16_t us) {
+  if (channel >= BLFM_PWM_MAX_CHANNELS)
+    return;
+
+  stats.pwm_updates++;
+  if (pulse_us[channel] != us) {
+    pulse_us[channel] = us;
+    sim_log("pwm ch%u %u us", channel, us);
+  }
+}
+
+// The real driver bit-bangs one pulse per channel here
+void blfm_pwm_generate_cycle(void) { stats.pwm_cycles++; }
+
+#if BLFM_ENABLED_MOTOR
+static blfm_motor_command_t motor;
+
+void blfm_motor_init(void) { memset(&motor, 0, sizeof(motor)); }
+
+void blfm_motor_apply(const blfm_motor_command_t *cmd) {
+  if (!cmd)
+    return;
+
+  stats.motor_updates++;
+  if (cmd->left.speed == motor.left.speed &&
+      cmd->left.direction == motor.left.direction &&
+      cmd->right.speed == motor.right.speed &&
+      cmd->right.direction == motor.right.direction)
+    return;
+
+  motor = *cmd;
+  sim_log("motor L %s %u R %s %u", motor.left.direction ? "bwd" : "fwd",
+          motor.left.speed, motor.right.direction ? "bwd" : "fwd",
+          motor.right.speed);
+}
+#endif
+
+void sim_get_output_stats(sim_output_stats_t *out) {
+  taskENTER_CRITICAL();
+  *out = stats;
+  taskEXIT_CRITICAL();
+}
@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (C) 2025 Masoud Bolhassani
+#
+# Convert a blfm_trace UART dump into Chrome trace / Perfetto JSON.
+# Usage: tools/trace/trace2json.py dump.bin [-o trace.json] [--hz 72000000]
+#
+# Capture the dump with e.g. `cat /dev/ttyUSB0 > dump.bin` (BLFM_UART_BAUD 8N1) and
+# open the JSON in https://ui.perfetto.dev or chrome://tracing.
+
+import argparse
+import json
+import struct
+import sys
+
+# Must match blfm_trace_type_t in include/blfm_trace.h
+TASK_IN = 1
+TASK_OUT = 2
+QUEUE_SEND = 3
+QUEUE_RECEIVE = 4
+QUEUE_BLOCK_SEND = 5
+QUEUE_BLOCK_RECEIVE = 6
+ISR_ENTER = 7
+ISR_EXIT = 8
+SLEEP = 9
+
+NAME_TASK = 0
+NAME_QUEUE = 1
+NAME_ISR = 2
+
+PID_TASKS = 1
+PID_ISRS = 2
+PID_QUEUES = 3
+
+RECORD = struct.Struct("<IBBH")
+MAX_RECORDS_PER_FRAME = 1024
+
+
+def parse_frames(data):
+    """Yield ("name", kind, id, name) and ("records", dropped, records)."""
+    pos = 0
+    while True:
+        tn = data.find(b"BLTN", pos)
+        tr = data.find(b"BLTR", pos)
+        starts = [p for p in (tn, tr) if p >= 0]
+        if not starts:
+            return
+        pos = min(starts)
+
+        if pos == tn:
+            if pos + 7 > len(data):
+                return
+            kind, ident, length = data[pos + 4], data[pos + 5], data[pos + 6]
+            end = pos + 7 + length
+            if end > len(data):
+                return
+            name = data[pos + 7:end].decode("ascii", "replace")
+            yield ("name", kind, ident, name)
+            pos = end
+        else:
+            if pos + 8 > len(data):
+                return
+            count, dropped = struct.unpack_from("<HH", data, pos + 4)
+            end = pos + 8 + count * RECORD.size
+            if count > MAX_RECORDS_PER_FRAME or end > len(data):
+                # Magic matched inside other bytes, or a truncated tail
+                pos += 1
+                continue
+            records = [RECORD.unpack_from(data, pos + 8 + i * RECORD.size)
+                       for i in range(count)]
+            yield ("records", dropped, records)
+            pos = end
+
+
+class Converter:
+    def __init__(self, hz, tick_hz):
+        self.us_per_cycle = 1e6 / hz
+        self.cycles_per_tick = hz // tick_hz
+        self.names = {NAME_TASK: {}, NAME_QUEUE: {}, NAME_ISR: {}}
+        self.events = []
+        self.last_raw = None
+        self.offset = 0
+        self.task_start = {}
+        self.isr_start = {}
+        self.seen = {PID_TASKS: set(), PID_ISRS: set(), PID_QUEUES: set()}
+
+    def timestamp(self, raw):
+        # CYCCNT wraps every 2^32 cycles; records arrive in order
+        if self.last_raw is not None and raw < self.last_raw:
+            self.offset += 1 << 32
+        self.last_raw = raw
+        return (raw + self.offset) * self.us_per_cycle
+
+    def name(self, kind, ident):
+        default = {NAME_TASK: "task %d", NAME_QUEUE: "queue %d",
+                   NAME_ISR: "isr %d"}[kind] % ident
+        return self.names[kind].get(ident, default)
+
+    def complete(self, pid, tid, name, start, end):
+        self.seen[pid].add(tid)
+        self.events.append({"ph": "X", "pid": pid, "tid": tid, "name": name,
+                            "ts": start, "dur": max(end - start, 0.0)})
+
+    def instant(self, pid, tid, name, ts, args=None):
+        self.seen[pid].add(tid)
+        event = {"ph": "i", "s": "t", "pid": pid, "tid": tid, "name": name,
+                 "ts": ts}
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+    def record(self, raw, kind, ident, arg):
+        ts = self.timestamp(raw)
+
+        if kind == TASK_IN:
+            self.task_start[ident] = ts
+        elif kind == TASK_OUT:
+            start = self.task_start.pop(ident, None)
+            if start is not None:
+                self.complete(PID_TASKS, ident, self.name(NAME_TASK, ident),
+                              start, ts)
+        elif kind == ISR_ENTER:
+            self.isr_start.setdefault(ident, []).append(ts)
+        elif kind == ISR_EXIT:
+            stack = self.isr_start.get(ident)
+            if stack:
+                self.complete(PID_ISRS, ident, self.name(NAME_ISR, ident),
+                              stack.pop(), ts)
+        elif kind in (QUEUE_SEND, QUEUE_RECEIVE):
+            queue = self.name(NAME_QUEUE, ident)
+            depth = arg + 1 if kind == QUEUE_SEND else max(arg - 1, 0)
+            label = "send" if kind == QUEUE_SEND else "receive"
+            self.instant(PID_QUEUES, ident, label, ts, {"waiting": arg})
+            self.events.append({"ph": "C", "pid": PID_QUEUES, "name": queue,
+                                "ts": ts, "args": {"depth": depth}})
+        elif kind in (QUEUE_BLOCK_SEND, QUEUE_BLOCK_RECEIVE):
+            label = "block send" if kind == QUEUE_BLOCK_SEND else \
+                "block receive"
+            self.instant(PID_QUEUES, ident, label, ts, {"waiting": arg})
+        elif kind == SLEEP:
+            # CYCCNT stood still while the core slept; put the time back
+            slept = arg * self.cycles_per_tick
+            self.offset += slept
+            self.instant(PID_TASKS, 0, "sleep", ts + slept * self.us_per_cycle,
+                         {"ticks": arg})
+
+    def dropped(self, count):
+        if count and self.last_raw is not None:
+            ts = (self.last_raw + self.offset) * self.us_per_cycle
+            self.events.append({"ph": "i", "s": "g", "pid": PID_TASKS,
+                                "tid": 0, "name": "dropped",
+                                "ts": ts, "args": {"records": count}})
+
+    def metadata(self):
+        meta = []
+        for pid, label in ((PID_TASKS, "Tasks"), (PID_ISRS, "ISRs"),
+                           (PID_QUEUES, "Queues")):
+            meta.append({"ph": "M", "pid": pid, "name": "process_name",
+                         "args": {"name": label}})
+        kinds = {PID_TASKS: NAME_TASK, PID_ISRS: NAME_ISR,
+                 PID_QUEUES: NAME_QUEUE}
+        for pid, tids in self.seen.items():
+            for tid in sorted(tids):
+                meta.append({"ph": "M", "pid": pid, "tid": tid,
+                             "name": "thread_name",
+                             "args": {"name": self.name(kinds[pid], tid)}})
+        return meta
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert a blfm_trace UART dump into Chrome trace JSON")
+    parser.add_argument("dump", help="raw UART capture, '-' for stdin")
+    parser.add_argument("-o", "--output", help="JSON file (default stdout)")
+    parser.add_argument("--hz", type=int, default=72000000,
+                        help="core clock the cycle stamps count")
+    parser.add_argument("--tick-hz", type=int, default=1000,
+                        help="configTICK_RATE_HZ, for sleep records")
+    args = parser.parse_args()
+
+    if args.dump == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.dump, "rb") as f:
+            data = f.read()
+
+    conv = Converter(args.hz, args.tick_hz)
+    records = 0
+    for frame in parse_frames(data):
+        if frame[0] == "name":
+            _, kind, ident, name = frame
+            if kind in conv.names:
+                conv.names[kind][ident] = name
+        else:
+            _, dropped, batch = frame
+            for raw, kind, ident, arg in batch:
+                conv.record(raw, kind, ident, arg)
+            conv.dropped(dropped)
+            records += len(batch)
+
+    trace = {"traceEvents": conv.metadata() + conv.events,
+             "displayTimeUnit": "ns"}
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump(trace, out)
+    if args.output:
+        out.close()
+    print("%d records, %d events" % (records, len(conv.events)),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()